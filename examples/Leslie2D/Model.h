@@ -17,6 +17,12 @@
 #define PHASE_GRID PointerGrid
 #define PARAMETER_GRID UniformGrid
 
+/// class Model
+///    Describes the dynamical system to the database programs.
+///    With config.param.threads other than 1 the workers call the const
+///    methods (map, phaseSpace, annotate), and evaluate the maps they
+///    return, from several threads at once. They must therefore be safe to
+///    call concurrently: no shared mutable state, or state guarded by a lock.
 class Model {
  public:
   /// initialize
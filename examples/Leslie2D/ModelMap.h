@@ -6,13 +6,22 @@
 #include "database/maps/Map.h"
 #include "database/structures/EuclideanParameterSpace.h"
 #include "database/structures/RectGeo.h"
+#ifdef USE_VECTOR_INTERVAL
+#include "database/numerics/vector_interval.h"
+#else
 #include "database/numerics/simple_interval.h"
+#endif
 #include <memory>
 #include <vector>
 
 class ModelMap : public Map {
 public:
+#ifdef USE_VECTOR_INTERVAL
+  typedef rounded_interval<double> interval;
+  typedef interval_lanes<double> lanes;
+#else
   typedef simple_interval<double> interval;
+#endif
 
 // User interface: method to be provided by user
   // Parameter variables
@@ -52,6 +61,61 @@ public:
     return std::shared_ptr<Geo> ( new RectGeo ( 
         operator () ( * std::dynamic_pointer_cast<RectGeo> ( geo ) ) ) );
   }
+
+  // Allocation-free version, used by MapGraph
+  bool 
+  operator () ( const RectGeo & rectangle, RectGeo * image ) const {
+    interval x0 = getRectangleComponent ( rectangle, 0 );
+    interval x1 = getRectangleComponent ( rectangle, 1 );
+    interval y0 = (p0 * x0 + p1 * x1 ) * exp ( -0.1 * (x0 + x1) );     
+    interval y1 = 0.7 * x0;
+    image -> lower_bounds . resize ( 2 );
+    image -> upper_bounds . resize ( 2 );
+    image -> lower_bounds [ 0 ] = y0 . lower ();
+    image -> upper_bounds [ 0 ] = y0 . upper ();
+    image -> lower_bounds [ 1 ] = y1 . lower ();
+    image -> upper_bounds [ 1 ] = y1 . upper ();
+    return true;
+  }
+
+  // Batch version, used by MapGraph::precompute. The same formulas, run
+  // over arrays of bounds (with USE_VECTOR_INTERVAL, on lanes::width boxes
+  // at a time, and on the remaining boxes one by one).
+  bool 
+  operator () ( const BoxBatch & boxes, BoxBatch * images ) const {
+    size_t N = boxes . size ();
+    images -> resize ( 2, N );
+    const Real * x0_lower = boxes . lower ( 0 );
+    const Real * x0_upper = boxes . upper ( 0 );
+    const Real * x1_lower = boxes . lower ( 1 );
+    const Real * x1_upper = boxes . upper ( 1 );
+    Real * y0_lower = images -> lower ( 0 );
+    Real * y0_upper = images -> upper ( 0 );
+    Real * y1_lower = images -> lower ( 1 );
+    Real * y1_upper = images -> upper ( 1 );
+    size_t i = 0;
+#ifdef USE_VECTOR_INTERVAL
+    for ( ; i + lanes::width <= N; i += lanes::width ) {
+      lanes x0 ( x0_lower + i, x0_upper + i );
+      lanes x1 ( x1_lower + i, x1_upper + i );
+      lanes y0 = (p0 * x0 + p1 * x1 ) * exp ( -0.1 * (x0 + x1) );     
+      lanes y1 = 0.7 * x0;
+      y0 . store ( y0_lower + i, y0_upper + i );
+      y1 . store ( y1_lower + i, y1_upper + i );
+    }
+#endif
+    for ( ; i < N; ++ i ) {
+      interval x0 ( x0_lower [ i ], x0_upper [ i ] );
+      interval x1 ( x1_lower [ i ], x1_upper [ i ] );
+      interval y0 = (p0 * x0 + p1 * x1 ) * exp ( -0.1 * (x0 + x1) );     
+      interval y1 = 0.7 * x0;
+      y0_lower [ i ] = y0 . lower ();
+      y0_upper [ i ] = y0 . upper ();
+      y1_lower [ i ] = y1 . lower ();
+      y1_upper [ i ] = y1 . upper ();
+    }
+    return true;
+  }
 private:
   interval getRectangleComponent ( const RectGeo & rectangle, int d ) const {
     return interval (rectangle . lower_bounds [ d ], rectangle . upper_bounds [ d ]); 
@@ -0,0 +1,132 @@
+// ClutchingBenchmark
+//   Time Clutching (clutchingLabels + clutchingSweep), on Morse graphs and
+//   on their compact codes, against the lockstep tree walk it replaced
+//   (LockstepClutching.h), and check that all three give the same BG_Data.
+//
+//   Each trial builds two adaptive 2D phase space partitions (a uniform
+//   grid of depth 12 to 14, refined up to twice more on random parts) and
+//   cuts each into Morse sets made of runs of consecutive leaves with
+//   random labels: 50 to 79 Morse sets in the first graph, and 1 to 84 in
+//   the second.
+//
+// usage: ./main [trials]
+//   default: 50 trials
+
+#include <fstream>
+#include <boost/serialization/export.hpp>
+#include "database/structures/Grid.h"
+#include "database/structures/PointerGrid.h"
+BOOST_CLASS_EXPORT_IMPLEMENT(PointerGrid);
+
+#include <iostream>
+#include <deque>
+#include <vector>
+#include <cstdlib>
+#include <memory>
+#include "boost/chrono/chrono.hpp"
+#include "boost/random/mersenne_twister.hpp"
+#include "database/structures/MorseGraph.h"
+#include "database/structures/MorseGraphCode.h"
+#include "database/algorithms/join.h"
+#include "database/algorithms/clutching.h"
+#include "LockstepClutching.h"
+
+typedef boost::chrono::steady_clock Clock;
+typedef boost::chrono::duration<double> Seconds;
+
+boost::random::mt19937_64 rng;
+
+/// makePhaseSpace
+///   Return the unit square subdivided "depth" times, then "refinements"
+///   times joined with a further subdivision of about "fraction" of its leaves
+std::shared_ptr<Grid> makePhaseSpace ( int depth, int refinements, double fraction ) {
+  std::shared_ptr<TreeGrid> grid ( new PointerGrid );
+  RectGeo bounds ( 2 );
+  bounds . lower_bounds [ 0 ] = bounds . lower_bounds [ 1 ] = 0.0;
+  bounds . upper_bounds [ 0 ] = bounds . upper_bounds [ 1 ] = 1.0;
+  grid -> initialize ( bounds, std::vector<bool> ( 2, false ) );
+  for ( int k = 0; k < depth; ++ k ) grid -> subdivide ();
+  for ( int r = 0; r < refinements; ++ r ) {
+    std::deque<Grid::GridElement> part;
+    for ( uint64_t ge = 0; ge < grid -> size (); ++ ge ) {
+      if ( rng () % 1000 < fraction * 1000 ) part . push_back ( ge );
+    }
+    std::shared_ptr<Grid> refined ( grid -> subgrid ( part ) );
+    refined -> subdivide ();
+    std::vector<std::shared_ptr<Grid> > family;
+    family . push_back ( grid );
+    family . push_back ( refined );
+    std::shared_ptr<Grid> joined ( (Grid *) grid -> clone () );
+    join ( joined, family . begin (), family . end () );
+    grid = std::dynamic_pointer_cast<TreeGrid> ( joined );
+  }
+  return grid;
+}
+
+/// makeMorseGraph
+///   Cut "phase_space" into runs of 1 to "run" consecutive leaves, and give
+///   each run a random label below 3K/2; the runs labelled below K make up
+///   the Morse sets (empty ones are left out)
+void makeMorseGraph ( MorseGraph * morse_graph, std::shared_ptr<Grid> phase_space,
+                      int K, int run ) {
+  morse_graph -> phaseSpace () = phase_space;
+  std::vector<std::deque<Grid::GridElement> > sets ( K );
+  uint64_t ge = 0;
+  while ( ge < phase_space -> size () ) {
+    uint64_t length = 1 + rng () % run;
+    int label = rng () % ( K + K / 2 );
+    uint64_t stop = std::min ( phase_space -> size (), ge + length );
+    for ( ; ge < stop; ++ ge ) if ( label < K ) sets [ label ] . push_back ( ge );
+  }
+  for ( int k = 0; k < K; ++ k ) {
+    if ( sets [ k ] . empty () ) continue;
+    MorseGraph::Vertex v = morse_graph -> AddVertex ();
+    morse_graph -> grid ( v ) . reset ( phase_space -> subgrid ( sets [ k ] ) );
+  }
+}
+
+int main ( int argc, char * argv [] ) {
+  int trials = 50;
+  if ( argc > 1 ) trials = std::atoi ( argv [ 1 ] );
+  double lockstep_seconds = 0.0, sweep_seconds = 0.0, code_seconds = 0.0;
+  uint64_t vertices = 0, leaves = 0, edges = 0;
+  int mismatches = 0;
+  for ( int trial = 0; trial < trials; ++ trial ) {
+    rng . seed ( trial );
+    int K = 50 + rng () % 30;
+    int depth1 = 12 + rng () % 3;
+    int depth2 = 12 + rng () % 3;
+    MorseGraph graph1, graph2;
+    makeMorseGraph ( & graph1, makePhaseSpace ( depth1, rng () % 3, 0.3 ), K, 1 + rng () % 40 );
+    makeMorseGraph ( & graph2, makePhaseSpace ( depth2, rng () % 3, 0.3 ), 1 + rng () % ( K + 5 ), 1 + rng () % 40 );
+    MorseGraphCode code1 ( graph1 ), code2 ( graph2 );
+    vertices += graph1 . NumVertices () + graph2 . NumVertices ();
+    leaves += graph1 . phaseSpace () -> size () + graph2 . phaseSpace () -> size ();
+
+    BG_Data lockstep, sweep, code;
+    Clock::time_point start = Clock::now ();
+    LockstepClutching ( & lockstep, graph1, graph2 );
+    Clock::time_point middle = Clock::now ();
+    Clutching ( & sweep, graph1, graph2 );
+    Clock::time_point late = Clock::now ();
+    Clutching ( & code, code1, code2 );
+    Clock::time_point stop = Clock::now ();
+    lockstep_seconds += Seconds ( middle - start ) . count ();
+    sweep_seconds += Seconds ( late - middle ) . count ();
+    code_seconds += Seconds ( stop - late ) . count ();
+    edges += lockstep . edges . size ();
+    if ( not ( lockstep == sweep ) || not ( lockstep == code ) ) {
+      ++ mismatches;
+      std::cout << "Trial " << trial << ": results differ (" << lockstep . edges . size ()
+                << ", " << sweep . edges . size () << " and " << code . edges . size () << " edges)\n";
+    }
+  }
+  std::cout << trials << " trials, " << vertices << " Morse sets, " << leaves
+            << " phase space leaves, " << edges << " clutching edges, "
+            << mismatches << " mismatches.\n";
+  std::cout << "lockstep walk " << lockstep_seconds << "s, sweep " << sweep_seconds
+            << "s, sweep on codes " << code_seconds << "s ("
+            << lockstep_seconds / sweep_seconds << "x, "
+            << lockstep_seconds / code_seconds << "x)\n";
+  return 0;
+}
@@ -0,0 +1,46 @@
+// ConvertDatabase
+//   Convert a database file between the boost archive format and the
+//   column format (see Database::save and DatabaseFile). The input format
+//   is detected from the file.
+//
+// usage: ./main input.mdb output.mdb [--archive]
+//   without --archive the output is written in the column format,
+//   with --archive it is written as a boost binary archive
+
+#include <fstream>
+#include <boost/serialization/export.hpp>
+#include "database/structures/Grid.h"
+#include "database/structures/PointerGrid.h"
+#include "database/structures/SuccinctGrid.h"
+#include "database/structures/UniformGrid.h"
+#include "database/structures/EdgeGrid.h"
+#include "database/structures/ParameterSpace.h"
+#include "database/structures/EuclideanParameterSpace.h"
+#include "database/structures/AbstractParameterSpace.h"
+BOOST_CLASS_EXPORT_IMPLEMENT(PointerGrid);
+BOOST_CLASS_EXPORT_IMPLEMENT(SuccinctGrid);
+BOOST_CLASS_EXPORT_IMPLEMENT(UniformGrid);
+BOOST_CLASS_EXPORT_IMPLEMENT(EdgeGrid);
+BOOST_CLASS_EXPORT_IMPLEMENT(EuclideanParameter);
+BOOST_CLASS_EXPORT_IMPLEMENT(EuclideanParameterSpace);
+BOOST_CLASS_EXPORT_IMPLEMENT(AbstractParameterSpace);
+
+#include <iostream>
+#include <string>
+#include "database/structures/Database.h"
+
+int main ( int argc, char * argv [] ) {
+  if ( argc < 3 || ( argc == 4 && std::string ( argv [ 3 ] ) != "--archive" ) || argc > 4 ) {
+    std::cout << "usage: " << argv [ 0 ] << " input.mdb output.mdb [--archive]\n";
+    return 1;
+  }
+  bool archive = ( argc == 4 );
+  Database database;
+  database . load ( argv [ 1 ] );
+  if ( archive ) {
+    database . saveArchive ( argv [ 2 ] );
+  } else {
+    database . save ( argv [ 2 ] );
+  }
+  return 0;
+}
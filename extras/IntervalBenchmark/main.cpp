@@ -0,0 +1,240 @@
+// IntervalBenchmark
+//   Time the interval types on the formulas of the Leslie map
+//   (examples/Leslie2D/ModelMap.h), of the three-dimensional fisheries
+//   map (FishMap3 of include/database/maps/fisheries.h) and of the interval
+//   part of the Newton map (include/database/maps/Newton.h, up to the
+//   atan2 of the bounds), evaluated on a grid of boxes stored as bound
+//   arrays, as MapGraph::precompute hands them to a map:
+//     simple_interval     (simple_interval.h, not rigorous)
+//     rounded_interval    (vector_interval.h, one box at a time)
+//     interval_lanes      (vector_interval.h, CMDB_INTERVAL_LANES boxes at a time)
+//     boost interval      (boost_interval.h, only if built with
+//                          -DUSE_BOOST_INTERVAL, which needs GMP and MPFR)
+//   Each result is checked against rounded_interval, which must enclose the
+//   bounds of the other types (interval_lanes gives the same bounds, or
+//   tighter ones with the AVX-512 kernels). Build with -march=native (or
+//   -mavx) to get wider lanes.
+//
+// usage: ./main [boxes] [passes]
+//   default: 1048576 boxes, 20 passes
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include "boost/chrono/chrono.hpp"
+#include "boost/random/mersenne_twister.hpp"
+#include "database/numerics/simple_interval.h"
+#include "database/numerics/vector_interval.h"
+#ifdef USE_BOOST_INTERVAL
+#include "database/numerics/boost_interval.h"
+#endif
+
+typedef boost::chrono::steady_clock Clock;
+typedef boost::chrono::duration<double> Seconds;
+
+/// Boxes
+///   "size" boxes of dimension "dim", as arrays of lower and upper bounds
+///   (one pair of arrays per coordinate)
+struct Boxes {
+  int dim;
+  size_t size;
+  std::vector<std::vector<double> > lower;
+  std::vector<std::vector<double> > upper;
+  Boxes ( int dim, size_t size ) : dim ( dim ), size ( size ),
+    lower ( dim, std::vector<double> ( size ) ), upper ( dim, std::vector<double> ( size ) ) {}
+};
+
+/// makeBoxes
+///   Return "size" boxes, each a random cell of the uniform grid with
+///   2^depth cells along each side of [ 0, side [ d ] ]^dim
+Boxes makeBoxes ( const std::vector<double> & side, int depth, size_t size ) {
+  boost::random::mt19937 rng ( 1 );
+  int dim = side . size ();
+  Boxes boxes ( dim, size );
+  uint32_t cells = 1 << depth;
+  for ( int d = 0; d < dim; ++ d ) {
+    double width = side [ d ] / cells;
+    for ( size_t i = 0; i < size; ++ i ) {
+      uint32_t cell = rng () % cells;
+      boxes . lower [ d ] [ i ] = cell * width;
+      boxes . upper [ d ] [ i ] = ( cell + 1 ) * width;
+    }
+  }
+  return boxes;
+}
+
+/// point
+///   Return the interval [ lower, upper ] as an I (in every lane, for
+///   interval_lanes)
+template < class I >
+I point ( double lower, double upper ) { return I ( lower, upper ); }
+
+template < >
+interval_lanes<double> point ( double lower, double upper ) {
+  return interval_lanes<double> ( rounded_interval<double> ( lower, upper ) );
+}
+
+/// Leslie
+///   The Leslie map with parameters p0, p1
+struct Leslie {
+  static const int dim = 2;
+  static const int image_dim = 2;
+  double p [ 2 ] [ 2 ];
+  Leslie ( void ) { p [ 0 ] [ 0 ] = 19.0; p [ 0 ] [ 1 ] = 19.01; p [ 1 ] [ 0 ] = 30.0; p [ 1 ] [ 1 ] = 30.01; }
+  static std::string name ( void ) { return "Leslie"; }
+  static std::vector<double> side ( void ) { return std::vector<double> { 320.0, 224.0 }; }
+  template < class I >
+  void operator () ( const I x [], I y [] ) const {
+    I p0 = point<I> ( p [ 0 ] [ 0 ], p [ 0 ] [ 1 ] );
+    I p1 = point<I> ( p [ 1 ] [ 0 ], p [ 1 ] [ 1 ] );
+    y [ 0 ] = (p0 * x [ 0 ] + p1 * x [ 1 ] ) * exp ( -0.1 * (x [ 0 ] + x [ 1 ]) );
+    y [ 1 ] = 0.7 * x [ 0 ];
+  }
+};
+
+/// Fish3
+///   The three-dimensional fisheries map (FishMap3)
+struct Fish3 {
+  static const int dim = 3;
+  static const int image_dim = 3;
+  static std::string name ( void ) { return "fisheries"; }
+  static std::vector<double> side ( void ) { return std::vector<double> { 10.0, 6.0, 4.0 }; }
+  template < class I >
+  void operator () ( const I x [], I y [] ) const {
+    const double p = 0.60653065971263342; // exp ( -0.5 )
+    y [ 0 ] = p * (2.6 * x [ 2 ]) * exp ( -0.1 * (2.6 * x [ 2 ]) );
+    y [ 1 ] = p * x [ 0 ];
+    y [ 2 ] = p * x [ 1 ];
+  }
+};
+
+/// Newton
+///   The Newton map up to the angle of its image: theta is sent to the
+///   point ( x, y ), with parameters c, phi, a, b
+struct Newton {
+  static const int dim = 1;
+  static const int image_dim = 2;
+  static std::string name ( void ) { return "Newton"; }
+  static std::vector<double> side ( void ) { return std::vector<double> { 6.2831853071795862 }; }
+  template < class I >
+  void operator () ( const I x [], I y [] ) const {
+    I one = point<I> ( 1.0, 1.0 );
+    I c = point<I> ( 0.5, 0.5001 );
+    I phi = point<I> ( 0.3, 0.3001 );
+    I a = point<I> ( -1.0, -0.999 );
+    I b = point<I> ( 1.0, 1.001 );
+    const I & theta = x [ 0 ];
+    y [ 0 ] = one + ( c - one ) * cos ( theta ) * cos ( theta );
+    y [ 1 ] = (a + b ) * 0.5 + ( a - b ) * 0.5 * cos ( 2.0 * ( phi + theta ) );
+  }
+};
+
+/// evaluate
+///   Apply "map" to every box, one box at a time with interval type I
+template < class I, class MapT >
+void evaluate ( const MapT & map, const Boxes & boxes, Boxes * images ) {
+  I x [ MapT::dim ], y [ MapT::image_dim ];
+  for ( size_t i = 0; i < boxes . size; ++ i ) {
+    for ( int d = 0; d < MapT::dim; ++ d ) x [ d ] = I ( boxes . lower [ d ] [ i ], boxes . upper [ d ] [ i ] );
+    map ( x, y );
+    for ( int d = 0; d < MapT::image_dim; ++ d ) {
+      images -> lower [ d ] [ i ] = y [ d ] . lower ();
+      images -> upper [ d ] [ i ] = y [ d ] . upper ();
+    }
+  }
+}
+
+/// evaluateLanes
+///   Apply "map" to every box, lanes::width boxes at a time (and the
+///   remaining boxes one by one, as the Leslie ModelMap does)
+template < class MapT >
+void evaluateLanes ( const MapT & map, const Boxes & boxes, Boxes * images ) {
+  typedef interval_lanes<double> lanes;
+  typedef rounded_interval<double> interval;
+  lanes x [ MapT::dim ], y [ MapT::image_dim ];
+  size_t i = 0;
+  for ( ; i + lanes::width <= boxes . size; i += lanes::width ) {
+    for ( int d = 0; d < MapT::dim; ++ d ) x [ d ] . load ( & boxes . lower [ d ] [ i ], & boxes . upper [ d ] [ i ] );
+    map ( x, y );
+    for ( int d = 0; d < MapT::image_dim; ++ d ) y [ d ] . store ( & images -> lower [ d ] [ i ], & images -> upper [ d ] [ i ] );
+  }
+  interval u [ MapT::dim ], v [ MapT::image_dim ];
+  for ( ; i < boxes . size; ++ i ) {
+    for ( int d = 0; d < MapT::dim; ++ d ) u [ d ] = interval ( boxes . lower [ d ] [ i ], boxes . upper [ d ] [ i ] );
+    map ( u, v );
+    for ( int d = 0; d < MapT::image_dim; ++ d ) {
+      images -> lower [ d ] [ i ] = v [ d ] . lower ();
+      images -> upper [ d ] [ i ] = v [ d ] . upper ();
+    }
+  }
+}
+
+/// compare
+///   Return the number of boxes of "images" not contained in "reference"
+uint64_t compare ( const Boxes & reference, const Boxes & images ) {
+  uint64_t result = 0;
+  for ( size_t i = 0; i < reference . size; ++ i ) {
+    for ( int d = 0; d < reference . dim; ++ d ) {
+      double lower = images . lower [ d ] [ i ];
+      double upper = images . upper [ d ] [ i ];
+      bool good = lower >= reference . lower [ d ] [ i ] && upper <= reference . upper [ d ] [ i ];
+      if ( not good ) { ++ result; break; }
+    }
+  }
+  return result;
+}
+
+/// report
+///   Print the time per pass and per box of one interval type
+void report ( const std::string & type, double seconds, int passes, size_t size,
+              double reference_seconds, uint64_t failures, const std::string & check ) {
+  std::cout << "  " << type << ": " << seconds / passes << "s per pass, "
+            << 1e9 * seconds / passes / size << "ns per box, "
+            << reference_seconds / seconds << "x rounded_interval, "
+            << failures << " boxes " << check << "\n";
+}
+
+template < class MapT >
+void benchmark ( size_t size, int passes ) {
+  MapT map;
+  Boxes boxes = makeBoxes ( MapT::side (), 16, size );
+  Boxes reference ( MapT::image_dim, size ), images ( MapT::image_dim, size );
+  std::cout << MapT::name () << " map, " << size << " boxes, " << passes << " passes\n";
+
+  Clock::time_point start = Clock::now ();
+  for ( int pass = 0; pass < passes; ++ pass ) evaluate<rounded_interval<double> > ( map, boxes, & reference );
+  double rounded_seconds = Seconds ( Clock::now () - start ) . count ();
+  report ( "rounded_interval", rounded_seconds, passes, size, rounded_seconds, 0, "checked" );
+
+  start = Clock::now ();
+  for ( int pass = 0; pass < passes; ++ pass ) evaluateLanes ( map, boxes, & images );
+  double seconds = Seconds ( Clock::now () - start ) . count ();
+  report ( "interval_lanes<" + std::to_string ( CMDB_INTERVAL_LANES ) + ">", seconds, passes, size,
+           rounded_seconds, compare ( reference, images ), "not enclosed" );
+
+  start = Clock::now ();
+  for ( int pass = 0; pass < passes; ++ pass ) evaluate<simple_interval<double> > ( map, boxes, & images );
+  seconds = Seconds ( Clock::now () - start ) . count ();
+  report ( "simple_interval", seconds, passes, size,
+           rounded_seconds, compare ( reference, images ), "not enclosed" );
+
+#ifdef USE_BOOST_INTERVAL
+  start = Clock::now ();
+  for ( int pass = 0; pass < passes; ++ pass ) evaluate<interval> ( map, boxes, & images );
+  seconds = Seconds ( Clock::now () - start ) . count ();
+  report ( "boost interval", seconds, passes, size,
+           rounded_seconds, compare ( reference, images ), "not enclosed" );
+#endif
+}
+
+int main ( int argc, char * argv [] ) {
+  size_t size = 1 << 20;
+  int passes = 20;
+  if ( argc > 1 ) size = std::atol ( argv [ 1 ] );
+  if ( argc > 2 ) passes = std::atoi ( argv [ 2 ] );
+  benchmark<Leslie> ( size, passes );
+  benchmark<Fish3> ( size, passes );
+  benchmark<Newton> ( size, passes );
+  return 0;
+}
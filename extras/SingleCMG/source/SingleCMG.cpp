@@ -57,6 +57,7 @@ void computeMorseGraph (MorseGraph & morsegraph,
                         const int SINGLECMG_MIN_PHASE_SUBDIVISIONS,
                         const int SINGLECMG_MAX_PHASE_SUBDIVISIONS,
                         const int SINGLECMG_COMPLEXITY_LIMIT,
+                        const MapGraphSettings & SINGLECMG_MAP_GRAPH_SETTINGS,
                         const char * outputfile = NULL );
 void computeConleyMorseGraph (MorseGraph & morsegraph,
                               std::shared_ptr<const Map> map,
@@ -73,6 +74,7 @@ void computeMorseGraph ( MorseGraph & morsegraph,
                         const int SINGLECMG_MIN_PHASE_SUBDIVISIONS,
                         const int SINGLECMG_MAX_PHASE_SUBDIVISIONS,
                         const int SINGLECMG_COMPLEXITY_LIMIT,
+                        const MapGraphSettings & SINGLECMG_MAP_GRAPH_SETTINGS,
                         const char * outputfile ) {
 #ifdef CMG_VERBOSE
   std::cout << "SingleCMG: computeMorseGraph.\n";
@@ -85,7 +87,8 @@ void computeMorseGraph ( MorseGraph & morsegraph,
                        SINGLECMG_INIT_PHASE_SUBDIVISIONS,
                        SINGLECMG_MIN_PHASE_SUBDIVISIONS,
                        SINGLECMG_MAX_PHASE_SUBDIVISIONS,
-                       SINGLECMG_COMPLEXITY_LIMIT );
+                       SINGLECMG_COMPLEXITY_LIMIT,
+                       SINGLECMG_MAP_GRAPH_SETTINGS );
   clock_t stop_time = clock ();
   if ( outputfile != NULL ) {
     morsegraph . save ( outputfile );
@@ -175,6 +178,7 @@ int main ( int argc, char * argv [] ) {
   int SINGLECMG_MIN_PHASE_SUBDIVISIONS = config . PHASE_SUBDIV_MIN;
   int SINGLECMG_MAX_PHASE_SUBDIVISIONS = config . PHASE_SUBDIV_MAX;
   int SINGLECMG_COMPLEXITY_LIMIT= config . PHASE_SUBDIV_LIMIT;
+  MapGraphSettings SINGLECMG_MAP_GRAPH_SETTINGS = config . mapGraphSettings ();
 
   /* COMPUTE MORSE GRAPH *************************************/
   TIC;                                                       
@@ -182,7 +186,8 @@ int main ( int argc, char * argv [] ) {
                       SINGLECMG_INIT_PHASE_SUBDIVISIONS,
                       SINGLECMG_MIN_PHASE_SUBDIVISIONS, 
                       SINGLECMG_MAX_PHASE_SUBDIVISIONS,
-                      SINGLECMG_COMPLEXITY_LIMIT, "data.mg" );        
+                      SINGLECMG_COMPLEXITY_LIMIT, 
+                      SINGLECMG_MAP_GRAPH_SETTINGS, "data.mg" );        
   std::cout << "Total Time for Finding Morse Sets ";         
 #ifndef NO_REACHABILITY                                      
   std::cout << "and reachability relation: ";                
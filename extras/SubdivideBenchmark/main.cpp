@@ -0,0 +1,124 @@
+// SubdivideBenchmark
+//   Time the direct PointerGrid::subdivide and SuccinctGrid::subdivide
+//   against the generic TreeGrid::subdivide (compress, CompressedTree
+//   subdivide, assign) on the same grid.
+//
+//   The grid is built by subdividing the unit square until it has at least
+//   twice the requested number of leaves and then keeping that many leaves,
+//   picked at random, so that the tree is irregular. After timing, the two
+//   subdivided trees are compressed and their leaf and valid sequences
+//   compared bit for bit.
+//
+// usage: ./main [leaves] [pointer|succinct|both]
+//   defaults: 10000000 leaves, both grid types
+
+#include <fstream>
+#include <boost/serialization/export.hpp>
+#include "database/structures/Grid.h"
+#include "database/structures/PointerGrid.h"
+#include "database/structures/SuccinctGrid.h"
+BOOST_CLASS_EXPORT_IMPLEMENT(PointerGrid);
+BOOST_CLASS_EXPORT_IMPLEMENT(SuccinctGrid);
+
+#include <iostream>
+#include <string>
+#include <deque>
+#include <cstdlib>
+#include <memory>
+#include "boost/chrono/chrono.hpp"
+#include "boost/random/mersenne_twister.hpp"
+
+/// Generic versions, by way of compress and assign
+class GenericPointerGrid : public PointerGrid {
+public:
+  virtual void subdivide ( void ) { TreeGrid::subdivide (); }
+};
+class GenericSuccinctGrid : public SuccinctGrid {
+public:
+  virtual void subdivide ( void ) { TreeGrid::subdivide (); }
+};
+
+/// build
+///   Return an irregular grid of type GridType with "leaves" leaves (always
+///   the same one for the same number of leaves)
+template < class GridType >
+std::shared_ptr<TreeGrid> build ( uint64_t leaves ) {
+  std::shared_ptr<TreeGrid> full ( new PointerGrid );
+  RectGeo bounds ( 2 );
+  bounds . lower_bounds [ 0 ] = bounds . lower_bounds [ 1 ] = 0.0;
+  bounds . upper_bounds [ 0 ] = bounds . upper_bounds [ 1 ] = 1.0;
+  full -> initialize ( bounds );
+  while ( full -> size () < 2 * leaves ) full -> subdivide ();
+  // Keep each leaf with probability leaves / size
+  boost::random::mt19937 rng ( 1 );
+  std::deque<Grid::GridElement> keep;
+  uint64_t size = full -> size ();
+  for ( uint64_t ge = 0; ge < size && keep . size () < leaves; ++ ge ) {
+    if ( (uint64_t) rng () % ( size - ge ) < leaves - keep . size () ) keep . push_back ( ge );
+  }
+  std::shared_ptr<TreeGrid> sparse ( full -> subgrid ( keep ) );
+  full . reset ();
+  std::shared_ptr<TreeGrid> result ( new GridType );
+  result -> assign ( std::shared_ptr<const CompressedTreeGrid> ( sparse -> compress () ) );
+  return result;
+}
+
+/// timeSubdivide
+///   Return the seconds taken by one subdivide of "grid"
+double timeSubdivide ( TreeGrid * grid ) {
+  boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now ();
+  grid -> subdivide ();
+  return boost::chrono::duration<double> ( boost::chrono::steady_clock::now () - start ) . count ();
+}
+
+/// sameBits
+///   Return true if "a" and "b" hold the same bits
+bool sameBits ( const BitSequence & a, const BitSequence & b ) {
+  if ( a . size () != b . size () ) return false;
+  size_t i = 0;
+  for ( ; i + 64 <= a . size (); i += 64 ) {
+    if ( a . get ( i, 64 ) != b . get ( i, 64 ) ) return false;
+  }
+  return i == a . size () || a . get ( i, a . size () - i ) == b . get ( i, a . size () - i );
+}
+
+template < class Direct, class Generic >
+void compare ( const std::string & name, uint64_t leaves ) {
+  uint64_t direct_size;
+  double direct_seconds, generic_seconds;
+  std::shared_ptr<CompressedTreeGrid> direct, generic;
+  {
+    std::shared_ptr<TreeGrid> grid = build<Direct> ( leaves );
+    direct_seconds = timeSubdivide ( grid . get () );
+    direct_size = grid -> size ();
+    direct . reset ( grid -> compress () );
+  }
+  {
+    std::shared_ptr<TreeGrid> grid = build<Generic> ( leaves );
+    generic_seconds = timeSubdivide ( grid . get () );
+    generic . reset ( grid -> compress () );
+  }
+  bool same = sameBits ( direct -> tree () -> leaf_sequence, generic -> tree () -> leaf_sequence )
+              && sameBits ( direct -> tree () -> valid_sequence, generic -> tree () -> valid_sequence );
+  if ( not same ) {
+    std::cout << name << ": the two versions give different trees\n";
+    return;
+  }
+  std::cout << name << ": " << leaves << " leaves -> " << direct_size << " leaves, same tree. "
+            << "direct " << direct_seconds << "s, compress/assign " << generic_seconds << "s ("
+            << generic_seconds / direct_seconds << "x)\n";
+}
+
+int main ( int argc, char * argv [] ) {
+  uint64_t leaves = 10000000;
+  std::string which = "both";
+  if ( argc > 1 ) leaves = std::strtoull ( argv [ 1 ], NULL, 10 );
+  if ( argc > 2 ) which = argv [ 2 ];
+  if ( which == "pointer" || which == "both" ) {
+    compare<PointerGrid, GenericPointerGrid> ( "PointerGrid", leaves );
+  }
+  if ( which == "succinct" || which == "both" ) {
+    compare<SuccinctGrid, GenericSuccinctGrid> ( "SuccinctGrid", leaves );
+  }
+  return 0;
+}
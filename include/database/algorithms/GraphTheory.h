@@ -6,15 +6,62 @@
 
 #include "database/structures/Grid.h"
 #include "database/maps/Map.h"
+#include "database/structures/MapGraph.h"
 #include <vector>
 #include <queue>
 #include <memory>
+#include "boost/range/iterator_range.hpp"
+
+/// MorseSetStatistics
+///   Accumulated over calls of computeMorseSetsAndReachability:
+///   wall-clock seconds spent in each phase, and adjacency cache counters.
+///   "map" is only nonzero when the adjacency lists are precomputed by a 
+///   thread pool; otherwise map evaluation happens during, and is counted 
+///   in, "scc".
+struct MorseSetStatistics {
+  double map;
+  double scc;
+  double reachability;
+  double subgrid;
+  uint64_t cache_hits;
+  uint64_t cache_misses;
+  uint64_t cache_spilled;
+  MorseSetStatistics ( void ) : map ( 0 ), scc ( 0 ), reachability ( 0 ), subgrid ( 0 ),
+    cache_hits ( 0 ), cache_misses ( 0 ), cache_spilled ( 0 ) {}
+};
 
 /// computeMorseSetsAndReachability
+///    If settings.threads != 1, the adjacency lists are first computed with 
+///    a thread pool. Adjacency lists computed for the strong components are
+///    cached (see MapGraphSettings) and reused for reachability.
+///    If statistics is given, timings and cache counters are added to it.
+///    With settings.order other than "tree" the passes run over relabelled
+///    vertices, so the Morse sets (and reach) may come out in another order.
 void computeMorseSetsAndReachability (std::vector< std::shared_ptr<Grid> > * output,
                                       std::vector<std::vector<unsigned int> > * reach,
                                       std::shared_ptr<const Grid> G,
-                                      std::shared_ptr<const Map> f );
+                                      std::shared_ptr<const Map> f,
+                                      const MapGraphSettings & settings = MapGraphSettings (),
+                                      MorseSetStatistics * statistics = 0 );
+
+/// struct StrongComponents
+///    Strong components with vertex ids of type Id, all in one array:
+///    component c is vertices [ begin [ c ] ] ... vertices [ begin [ c + 1 ] - 1 ].
+template < class Id >
+struct StrongComponents {
+  std::vector<Id> vertices;
+  std::vector<uint64_t> begin;
+  StrongComponents ( void ) : begin ( 1, 0 ) {}
+  /// size
+  ///   Return the number of components
+  size_t size ( void ) const { return begin . size () - 1; }
+  /// operator []
+  ///   Return the vertices of component c
+  boost::iterator_range<const Id *> operator [] ( size_t c ) const {
+    return boost::iterator_range<const Id *> ( vertices . data () + begin [ c ], 
+                                               vertices . data () + begin [ c + 1 ] );
+  }
+};
 
 /// computeStrongComponents
 ///    Modified version of Tarjan's algorithm devised by Shaun Harker
@@ -25,12 +72,24 @@ void computeStrongComponents (std::vector<std::deque<typename Graph::Vertex> > *
          /* optional output */std::deque<typename Graph::Vertex> * topological_sort = 0,
          /* optional output */std::deque<typename Graph::Vertex> * SCC_root = 0);
 
+/// computeStrongComponents
+///    As above, keeping vertices as Id (e.g. uint32_t) in contiguous arrays.
+///    Requires fewer than 2^(bits of Id - 1) vertices; throws otherwise.
+template < class Graph, class Id >
+void computeStrongComponents (StrongComponents<Id> * output,
+                              const Graph & G,
+         /* optional output */std::vector<Id> * topological_sort,
+         /* optional output */std::vector<Id> * SCC_root );
+
 /// computeReachability
-template < class Graph >
+///    "morse_sets" is a std::vector of std::deques of vertices, or a
+///    StrongComponents; "topological_sort" a std::deque or std::vector,
+///    as produced by computeStrongComponents.
+template < class Graph, class Components, class Order >
 void computeReachability ( std::vector < std::vector < unsigned int > > * output, 
-                           std::vector<std::deque<typename Graph::size_type> > & morse_sets, 
+                           const Components & morse_sets, 
                            const Graph & G, 
-                           const std::deque<typename Graph::size_type> & topological_sort );
+                           const Order & topological_sort );
 
 #include "database/algorithms/GraphTheory.hpp"
 
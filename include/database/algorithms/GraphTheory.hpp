@@ -7,9 +7,11 @@
 #include <queue>
 #include <algorithm>
 #include <memory>
+#include <limits>
 #include "boost/unordered_set.hpp"
 #include "boost/unordered_map.hpp"
 #include "boost/foreach.hpp"
+#include "boost/chrono.hpp"
 #include "database/structures/MapGraph.h"
 
 #define DEBUGPRINT if(0)
@@ -22,16 +24,24 @@ uint64_t graph_memory = 0;
 uint64_t max_graph_memory = 0;
 #endif
 
-inline void 
-computeMorseSetsAndReachability (std::vector< std::shared_ptr<Grid> > * output,
-                                 std::vector<std::vector<unsigned int> > * reach,
-                                 std::shared_ptr<const Grid> G,
-                                 std::shared_ptr<const Map> f ) {
-  MapGraph mapgraph ( G, f );
+/// morseSetsAndReachability
+///   Body of computeMorseSetsAndReachability after the map graph is made,
+///   with vertex ids of type Id. Adds the phase timings to "elapsed".
+template < class Id > void
+morseSetsAndReachability (std::vector< std::shared_ptr<Grid> > * output,
+                          std::vector<std::vector<unsigned int> > * reach,
+                          const Grid & G,
+                          const MapGraph & mapgraph,
+                          MorseSetStatistics * elapsed ) {
+  typedef boost::chrono::steady_clock Clock;
+  typedef boost::chrono::duration<double> Seconds;
+  Clock::time_point start = Clock::now ();
   // Produce Strong Components and Reachability
-  std::vector < std::deque < Grid::GridElement > > components;
-  std::deque < Grid::size_type > topological_sort;
-  computeStrongComponents ( &components, mapgraph, &topological_sort );
+  StrongComponents<Id> components;
+  std::vector<Id> topological_sort;
+  computeStrongComponents ( &components, mapgraph, &topological_sort, (std::vector<Id> *) NULL );
+  elapsed -> scc = Seconds ( Clock::now () - start ) . count ();
+  start = Clock::now ();
 #ifdef CMG_VERBOSE
   if ( components . size () > 1 ) {
     std::cout << "Found " << components . size () 
@@ -41,27 +51,110 @@ computeMorseSetsAndReachability (std::vector< std::shared_ptr<Grid> > * output,
 #ifndef NO_REACHABILITY
   computeReachability ( reach, components, mapgraph, topological_sort );
 #endif
+  elapsed -> reachability = Seconds ( Clock::now () - start ) . count ();
+  start = Clock::now ();
   // Create output grids
+  std::vector<Id> () . swap ( topological_sort );
   output -> clear ();
-  BOOST_FOREACH ( const std::deque<Grid::GridElement> & component, components ) {
-    std::shared_ptr < Grid > component_grid ( G -> subgrid ( component ) );
+  std::deque<Grid::GridElement> component;
+  for ( size_t c = 0; c < components . size (); ++ c ) {
+    component . clear ();
+    BOOST_FOREACH ( Id v, components [ c ] ) component . push_back ( mapgraph . element ( v ) );
+    std::shared_ptr < Grid > component_grid ( G . subgrid ( component ) );
     output -> push_back ( component_grid );
   }
+  elapsed -> subgrid = Seconds ( Clock::now () - start ) . count ();
+}
+
+inline void 
+computeMorseSetsAndReachability (std::vector< std::shared_ptr<Grid> > * output,
+                                 std::vector<std::vector<unsigned int> > * reach,
+                                 std::shared_ptr<const Grid> G,
+                                 std::shared_ptr<const Map> f,
+                                 const MapGraphSettings & settings,
+                                 MorseSetStatistics * statistics ) {
+  typedef boost::chrono::steady_clock Clock;
+  typedef boost::chrono::duration<double> Seconds;
+  MorseSetStatistics elapsed;
+  Clock::time_point start = Clock::now ();
+  MapGraph mapgraph ( G, f, settings );
+  // Evaluate the map on every grid element in parallel, if requested
+  if ( settings . threads != 1 ) {
+    mapgraph . precompute ();
+    elapsed . map = Seconds ( Clock::now () - start ) . count ();
+  }
+  // 32-bit vertex ids whenever they fit (one bit is kept by computeStrongComponents)
+  if ( mapgraph . num_vertices () < ( (uint64_t) 1 << 31 ) ) {
+    morseSetsAndReachability<uint32_t> ( output, reach, *G, mapgraph, &elapsed );
+  } else {
+    morseSetsAndReachability<uint64_t> ( output, reach, *G, mapgraph, &elapsed );
+  }
+  if ( mapgraph . cache () ) {
+    elapsed . cache_hits = mapgraph . cache () -> hits ();
+    elapsed . cache_misses = mapgraph . cache () -> misses ();
+    elapsed . cache_spilled = mapgraph . cache () -> spilled ();
+  }
+#ifdef CMG_VERBOSE
+  std::cout << "computeMorseSetsAndReachability. V = " << G -> size () 
+            << ", map " << elapsed . map << "s, scc " << elapsed . scc 
+            << "s, reachability " << elapsed . reachability 
+            << "s, subgrids " << elapsed . subgrid << "s, cache hits " 
+            << elapsed . cache_hits << ", misses " << elapsed . cache_misses << ".\n";
+#endif
+  if ( statistics != NULL ) {
+    statistics -> map += elapsed . map;
+    statistics -> scc += elapsed . scc;
+    statistics -> reachability += elapsed . reachability;
+    statistics -> subgrid += elapsed . subgrid;
+    statistics -> cache_hits += elapsed . cache_hits;
+    statistics -> cache_misses += elapsed . cache_misses;
+    statistics -> cache_spilled += elapsed . cache_spilled;
+  }
 }
 
 /// computeStrongComponents (actually, SCPCs... needs renaming.)
 ///    Modified version of Tarjan's algorithm devised by Shaun Harker
 ///    Only calls for adjacency lists once each, yet only requires O(V) space.
-///
-/// comments: the interface results in some inefficiency. It would be nice to change
-///           it. In particular the way SCC_root requires it to be written in random
-///           order which is not ideal.
+///    This version runs the one below with 64-bit ids and copies the
+///    result into deques.
 template < class Graph >
 void computeStrongComponents (std::vector<std::deque<typename Graph::Vertex> > * output,
                               const Graph & G,
          /* optional output */std::deque<typename Graph::Vertex> * topological_sort,
          /* optional output */std::deque<typename Graph::Vertex> * SCC_root ) {
   typedef typename Graph::Vertex Vertex;
+  StrongComponents<uint64_t> components;
+  std::vector<uint64_t> order, roots;
+  computeStrongComponents ( &components, G, 
+                            topological_sort ? &order : NULL, 
+                            SCC_root ? &roots : NULL );
+  for ( size_t c = 0; c < components . size (); ++ c ) {
+    output -> push_back ( std::deque<Vertex> ( components [ c ] . begin (), 
+                                               components [ c ] . end () ) );
+  }
+  if ( topological_sort != NULL ) {
+    topological_sort -> insert ( topological_sort -> end (), order . begin (), order . end () );
+  }
+  if ( SCC_root != NULL ) {
+    SCC_root -> assign ( roots . begin (), roots . end () );
+  }
+}
+
+/// computeStrongComponents
+///    The depth first search keeps one stack entry per visit: 2u to enter
+///    vertex u (preorder) and 2u + 1 to leave it (postorder). Vertices are
+///    pushed when discovered, so a vertex may be on the stack many times;
+///    once the stack exceeds 2V entries only the topmost entry of each
+///    vertex is kept.
+template < class Graph, class Id >
+void computeStrongComponents (StrongComponents<Id> * output,
+                              const Graph & G,
+         /* optional output */std::vector<Id> * topological_sort,
+         /* optional output */std::vector<Id> * SCC_root ) {
+  typedef typename Graph::Vertex Vertex;
+  if ( (uint64_t) G . num_vertices () >= ( (uint64_t) 1 << ( 8 * sizeof ( Id ) - 1 ) ) ) {
+    throw std::logic_error ( "computeStrongComponents. Too many vertices for the vertex id type.\n" );
+  }
 #ifdef CMG_VERBOSE
   int64_t progress = 0;
   int64_t progresspercent = 0;
@@ -70,117 +163,118 @@ void computeStrongComponents (std::vector<std::deque<typename Graph::Vertex> > *
   graph_memory = 0;
 #endif
   int64_t E = 0;
-  int64_t N = (int64_t) G . num_vertices ();
+  Id N = (Id) G . num_vertices ();
   std::vector<bool> explored ( N, false );
   std::vector<bool> committed ( N, false );
-  std::vector<bool> duplicates ( N, false );
+  std::vector<bool> duplicates;
   std::vector<bool> self_connected (N, false);
-  std::vector<int64_t> preorder ( N, 0 );
-  std::deque<int64_t> LOWLINK, DFS, cleanDFS;
-  std::deque<Vertex> S;
+  std::vector<Id> preorder ( N, 0 );
+  std::vector<Id> LOWLINK, DFS, S;
+  output -> vertices . clear ();
+  output -> begin . assign ( 1, 0 );
+  if ( topological_sort != NULL ) {
+    topological_sort -> clear ();
+    topological_sort -> reserve ( N );
+  }
   if ( SCC_root != NULL ) {
-    SCC_root -> resize ( N );
+    SCC_root -> assign ( N, 0 );
   }
-  int64_t n = 0;
-  LOWLINK . push_back ( -1 );
-  for ( int64_t v = 0; v < N; ++ v ) {
-    if ( not explored [ v ] ) {
-      DFS . push_back ( v+1 );
-      while ( not DFS . empty () ) {
-        int64_t u = DFS . back ();
-        DFS . pop_back ();
+  Id n = 0;
+  LOWLINK . push_back ( 0 ); // absorbs the lowlinks of the search roots
+  for ( Id v = 0; v < N; ++ v ) {
+    if ( explored [ v ] ) continue;
+    DFS . push_back ( 2 * v );
+    while ( not DFS . empty () ) {
+      Id entry = DFS . back ();
+      DFS . pop_back ();
+      Id u = entry >> 1;
 #ifdef CMG_VERBOSE
-        if ( (100*progress)/(2L*N) > progresspercent) {
-          progresspercent = (100*progress)/(2L*N);
-          std::cout << "\rcomputeStrongComponents. V = " << N << ", " << progresspercent << "%" " finished.  ";
-          std::cout . flush ();
-        }
+      if ( (100*progress)/(2L*N) > progresspercent) {
+        progresspercent = (100*progress)/(2L*N);
+        std::cout << "\rcomputeStrongComponents. V = " << N << ", " << progresspercent << "%" " finished.  ";
+        std::cout . flush ();
+      }
 #endif
 #ifdef MEMORYBOOKKEEPING
-        uint64_t mem_bytes_external = sizeof ( int64_t ) * DFS . size () + 
-                                      sizeof ( int64_t ) * LOWLINK . size () +
-                                      sizeof ( Vertex ) * S . size (); 
-        uint64_t mem_bytes_internal = sizeof ( int64_t ) * preorder . size ()  +
-                                      N / 2; // For std::vector<bool> info
-        max_scc_memory_external = std::max( max_scc_memory_external, mem_bytes_external );
-        max_scc_memory_internal = std::max( max_scc_memory_internal, mem_bytes_internal );
+      uint64_t mem_bytes_external = sizeof ( Id ) * ( DFS . capacity () + 
+                                                      LOWLINK . capacity () +
+                                                      S . capacity () );
+      uint64_t mem_bytes_internal = sizeof ( Id ) * preorder . size () +
+                                    N / 2; // For std::vector<bool> info
+      max_scc_memory_external = std::max( max_scc_memory_external, mem_bytes_external );
+      max_scc_memory_internal = std::max( max_scc_memory_internal, mem_bytes_internal );
 #endif
-        if ( u > 0 ) {
-          // PREORDER
-          u = u - 1;
-          //std::cout << "Preorder(" << u << ")\n";
-          if ( not explored [ u ] ) {
+      if ( ( entry & 1 ) == 0 ) {
+        // PREORDER
+        if ( explored [ u ] ) continue;
 #ifdef CMG_VERBOSE
-            ++ progress;
+        ++ progress;
 #endif
-            DFS . push_back ( -u-1);
-            explored [ u ] = true;
-            preorder [ u ] = n;
-            int64_t low = n;
-            ++ n;
-            std::vector<Vertex> W =  G . adjacencies ( u );
+        DFS . push_back ( 2 * u + 1 );
+        explored [ u ] = true;
+        preorder [ u ] = n;
+        Id low = n;
+        ++ n;
+        std::vector<Vertex> W = G . adjacencies ( u );
 #ifdef MEMORYBOOKKEEPING
-            graph_memory += sizeof(Vertex) * (1 + W . size ());
+        graph_memory += sizeof(Vertex) * (1 + W . size ());
 #endif
-            E += W . size ();
-            BOOST_FOREACH ( int64_t w, W ) {
-              if ( u == w ) self_connected [ u ] = true;
-              if ( explored [ w ] ) {
-                if ( not committed [ w ] ) {
-                  low = std::min(low, preorder[w] );
-                }
-              } else {
-                DFS . push_back ( w + 1 );
-                if ( (int64_t) DFS . size () > 2L*N ) { 
-                  duplicates . assign ( N, false );
-                  while ( not DFS . empty () ) {
-                    int64_t x = DFS . back ();
-                    DFS . pop_back ();
-                    int64_t y = std::abs(x) - 1;
-                    if ( duplicates [ y ] ) continue;
-                    duplicates [ y ] = true;
-                    cleanDFS . push_front ( x );
-                  }
-                  std::swap ( DFS, cleanDFS );
-                }
-              }
+        E += W . size ();
+        BOOST_FOREACH ( Vertex w, W ) {
+          if ( u == w ) self_connected [ u ] = true;
+          if ( explored [ w ] ) {
+            if ( not committed [ w ] ) {
+              low = std::min ( low, preorder [ w ] );
             }
-            LOWLINK . push_back ( low );
-            S . push_back ( (Vertex) u );
+            continue;
+          } 
+          DFS . push_back ( 2 * (Id) w );
+          if ( DFS . size () > 2 * (uint64_t) N ) { 
+            // Keep the topmost entry of each vertex, in place
+            duplicates . assign ( N, false );
+            size_t kept = DFS . size ();
+            for ( size_t i = DFS . size (); i -- > 0; ) {
+              Id y = DFS [ i ] >> 1;
+              if ( duplicates [ y ] ) continue;
+              duplicates [ y ] = true;
+              DFS [ -- kept ] = DFS [ i ];
+            }
+            DFS . erase ( DFS . begin (), DFS . begin () + kept );
           }
-        } else {
-          // POSTORDER
-          u = -u - 1;
+        }
+        LOWLINK . push_back ( low );
+        S . push_back ( u );
+      } else {
+        // POSTORDER
 #ifdef CMG_VERBOSE
-          ++ progress;
+        ++ progress;
 #endif
-          //std::cout << "Postorder(" << u << ")\n";
-          int64_t lowlink = LOWLINK . back ();
-          LOWLINK . pop_back ();
-          if ( lowlink == preorder [ u ] ) {
-            output -> push_back ( std::deque<Vertex> () );
-            std::deque<Vertex> & SCC = output -> back ();
-            do {
-              int64_t w = S . back ();
-              S . pop_back ();
-              SCC . push_back ( (Vertex) w );
-              committed [ w ] = true;
-              if ( topological_sort != NULL ) {
-                topological_sort -> push_back ( w );
-              }
-              if ( SCC_root != NULL ) {
-                (*SCC_root) [ w ] = ( (Vertex) u );
-              }
-            } while ( not committed [ u ] );
-            // Only SCPCs:
-            if ( SCC . size () == 1 &&
-                 not self_connected [ u ] ) output -> pop_back ();
+        Id lowlink = LOWLINK . back ();
+        LOWLINK . pop_back ();
+        if ( lowlink == preorder [ u ] ) {
+          uint64_t first = output -> vertices . size ();
+          Id w;
+          do {
+            w = S . back ();
+            S . pop_back ();
+            output -> vertices . push_back ( w );
+            committed [ w ] = true;
+            if ( topological_sort != NULL ) {
+              topological_sort -> push_back ( w );
+            }
+            if ( SCC_root != NULL ) {
+              (*SCC_root) [ w ] = u;
+            }
+          } while ( w != u );
+          // Only SCPCs:
+          if ( output -> vertices . size () == first + 1 &&
+               not self_connected [ u ] ) {
+            output -> vertices . pop_back ();
+          } else {
+            output -> begin . push_back ( output -> vertices . size () );
           }
-          int64_t low = LOWLINK . back ();
-          LOWLINK . pop_back ();
-          lowlink = std::min ( lowlink, low );
-          LOWLINK . push_back ( lowlink );
         }
+        LOWLINK . back () = std::min ( LOWLINK . back (), lowlink );
       }
     }
   }
@@ -194,11 +288,17 @@ void computeStrongComponents (std::vector<std::deque<typename Graph::Vertex> > *
 }
 
 /// computeReachability 
-template < class Graph >
+///   Single sweep over the topological sort. Each vertex carries a bitset with
+///   one bit per Morse set (ceil(M/64) words), recording which Morse sets reach
+///   it. Codes live in a pool of slots: a vertex gets a slot only when some
+///   predecessor actually reaches it, and gives it back as soon as it has been
+///   processed (all its predecessors come before it), so memory is bounded by
+///   the widest reached frontier of the sweep rather than V * M bits.
+template < class Graph, class Components, class Order >
 void computeReachability ( std::vector < std::vector < unsigned int > > * output,
-                           std::vector<std::deque<typename Graph::size_type> > & morse_sets,
+                           const Components & morse_sets,
                            const Graph & G, 
-                           const std::deque<typename Graph::size_type> & topological_sort ) {
+                           const Order & topological_sort ) {
   typedef typename Graph::size_type size_type;
 #ifdef CMG_VERBOSE
   std::cout << "Computing Reachability Information.\n";
@@ -207,10 +307,11 @@ void computeReachability ( std::vector < std::vector < unsigned int > > * output
   size_type progresspercent = 0;
 #endif
   /* Count the Morse Sets */
-  uint64_t effort = 0;
   size_type number_of_morse_sets = morse_sets . size ();  
   if ( number_of_morse_sets == 0 ) return; // trivial case
   output -> resize ( number_of_morse_sets );
+  // Number of 64-bit words in a bitset over the Morse sets
+  const size_type W = ( (number_of_morse_sets - 1) / 64 ) + 1;
   // Paint the Morse Sets
   // For each morse set, go through its vertices and 
   // color them according to which morse set they are in.
@@ -218,94 +319,92 @@ void computeReachability ( std::vector < std::vector < unsigned int > > * output
   std::vector < size_type > morse_paint ( G . num_vertices (), number_of_morse_sets );
   for ( size_type count = 0; count < number_of_morse_sets; ++ count ) {
     BOOST_FOREACH ( size_type v, morse_sets [ count ] ) {
-      ++ effort; 
       morse_paint [ v ] = count;
     } 
   } 
 
-  // Break the Morse Sets up into Computational Groups of 64 and proceed 
-  size_type groups = ( (number_of_morse_sets - 1) / 64 ) + 1;
+  // condensed_code [ W*m .. W*m+W ) is the set of Morse sets reaching Morse set m.
+  // (Row number_of_morse_sets collects vertices outside Morse sets; it is unused.)
+  std::vector < uint64_t > condensed_code ( W * ( number_of_morse_sets + 1 ), 0 );
+  // slot [ v ] locates the code of v in the pool "codes", or is NO_SLOT
+  // if no Morse set has reached v yet.
+  const uint64_t NO_SLOT = std::numeric_limits<uint64_t>::max ();
+  std::vector < uint64_t > slot ( G . num_vertices (), NO_SLOT );
+  // done [ v ] is set once v is processed; edges back into a finished
+  // vertex (within a Morse set) must not claim a slot again.
+  std::vector < bool > done ( G . num_vertices (), false );
+  std::vector < uint64_t > codes;
+  std::vector < uint64_t > free_slots;
+  std::vector < uint64_t > code ( W );
   
+  // Loop through topological sort.
+  // Our goal is to produce "condensed_code", which we can read the info off from.
+  for ( int64_t vi = topological_sort . size () - 1; vi >= 0; -- vi ) {
 #ifdef CMG_VERBOSE
-  size_type total_work_to_do = topological_sort . size () * groups;
+    ++ progress;
+    if ( (100*progress)/topological_sort . size () > progresspercent) {
+      progresspercent = (100*progress)/topological_sort . size ();
+      std::cout << "\r" << progresspercent << "%    ";
+      std::cout . flush ();
+    }
 #endif
-  // We use a vector called morse_code. It's function is to maintain
-  // information about which morse sets can reach a given vertex.
-  // By processing in topological order, it is possible to give morse_code
-  // the correct values in a single pass.
-  std::vector < uint64_t > morse_code;
-  // We use a vector called condensed_code in order to store the final information
-  // about which morse sets can reach a given morse set. It can be inferred from morse_code
-  // during the same sweep in which we construct morse_code.
-  std::vector < uint64_t > condensed_code;
-  // Loop through groups.
-  for ( size_type group_number = 0; group_number < groups; ++ group_number ) {
-    ++ effort;
-    size_type group_size = std::min((size_type) 64, 
-          (size_type) number_of_morse_sets - ((size_type)64) * group_number);
-    size_type offset = 64L * group_number;
-    morse_code . clear ();
-    morse_code . resize ( G . num_vertices (), 0 );
-    condensed_code . clear ();
-    condensed_code . resize ( number_of_morse_sets + 1, 0 );
-
-    // Paint the codes.
-    // We do an initial sweep painting the sources onto their sets. 
-    for ( size_type count = 0; count < group_size; ++ count ) {
-      size_type set_number = offset + count;
-      uint64_t code = ((uint64_t)1) << count;
-      ++ effort;    
-      BOOST_FOREACH ( size_type v, morse_sets [ set_number ] ) {
-        ++ effort;
-        morse_code [ v ] = code;
-      } 
-    } 
-
-    // Loop through topological sort.
-    // Our goal is to produce "condensed_code", which we can read the info off from.
-    // The intermediate information is stored in "morse_code"
-    for ( int64_t vi = topological_sort . size () - 1; vi >= 0; -- vi ) {
-#ifdef CMG_VERBOSE
-      ++ progress;
-      if ( (100*progress)/total_work_to_do > progresspercent) {
-        progresspercent = (100*progress)/total_work_to_do;
-        std::cout << "\r" << progresspercent << "%    ";
-        std::cout . flush ();
+    size_type v = topological_sort [ vi ];
+    done [ v ] = true;
+    // Assemble the code of v: what reached it, plus its own Morse set
+    // and whatever reached its Morse set.
+    bool reached = false;
+    if ( slot [ v ] != NO_SLOT ) {
+      std::copy ( codes . begin () + slot [ v ], codes . begin () + slot [ v ] + W, code . begin () );
+      free_slots . push_back ( slot [ v ] );
+      slot [ v ] = NO_SLOT;
+      reached = true;
+    } else {
+      std::fill ( code . begin (), code . end (), 0 );
+    }
+    size_type paint = morse_paint [ v ];
+    if ( paint != number_of_morse_sets ) {
+      const uint64_t * condensed = & condensed_code [ W * paint ];
+      for ( size_type k = 0; k < W; ++ k ) code [ k ] |= condensed [ k ];
+      code [ paint / 64 ] |= ((uint64_t)1) << ( paint % 64 );
+      reached = true;
+    }
+    // Unreached vertices have nothing to pass on.
+    if ( not reached ) continue;
+    std::vector < size_type > children = G . adjacencies ( v ); // previously const &
+    BOOST_FOREACH ( size_type w, children ) {
+      uint64_t * condensed = & condensed_code [ W * morse_paint [ w ] ];
+      for ( size_type k = 0; k < W; ++ k ) condensed [ k ] |= code [ k ];
+      if ( done [ w ] ) continue;
+      if ( slot [ w ] == NO_SLOT ) {
+        if ( free_slots . empty () ) {
+          slot [ w ] = codes . size ();
+          codes . resize ( codes . size () + W, 0 );
+        } else {
+          slot [ w ] = free_slots . back ();
+          free_slots . pop_back ();
+          std::fill ( codes . begin () + slot [ w ], codes . begin () + slot [ w ] + W, 0 );
+        }
       }
+      uint64_t * target = & codes [ slot [ w ] ];
+      for ( size_type k = 0; k < W; ++ k ) target [ k ] |= code [ k ];
+    }
+  } 
+#ifdef MEMORYBOOKKEEPING
+  max_reach_memory = std::max ( max_reach_memory, (uint64_t) ( sizeof ( uint64_t ) * 
+    ( codes . size () + condensed_code . size () + slot . size () + morse_paint . size () ) ) );
 #endif
-      size_type v = topological_sort [ vi ];
-      std::vector < size_type > children = G . adjacencies ( v ); // previously const &
-      if ( morse_paint [ v ] != number_of_morse_sets ) {
-        morse_code [ v ] |= condensed_code [ morse_paint [ v ] ];
-      }
-      BOOST_FOREACH ( size_type w, children ) {
-        ++ effort;
-        morse_code [ w ] |= morse_code [ v ];
-        condensed_code [ morse_paint [ w ] ] |= morse_code [ v ];
 
+  // Note: Now condensed_code is indexed by targets, 
+  //       and contains the sources reaching it.    
+  // Loop through Morse Sets to learn reachability information
+  for ( size_type count = 0; count < number_of_morse_sets; ++ count ) {
+    const uint64_t * condensed = & condensed_code [ W * count ];
+    for ( size_type source = 0; source < number_of_morse_sets; ++ source ) {
+      if ( condensed [ source / 64 ] & ( ((uint64_t)1) << ( source % 64 ) ) ) {
+        (*output)[source] . push_back ( count );
       }
-    } 
-#ifdef CMG_VERBOSE
-    ++ progress;
-#endif
-
-    // Note: Now condensed_code is indexed by targets, 
-    //       and contains the sources reaching it.    
-    // Loop through Morse Sets to learn reachability information
-    for ( size_type count = 0; count < number_of_morse_sets; ++ count ) {
-      // Read condensed code to determine which of the group reached this morse set
-      ++ effort;
-      uint64_t bit = 1;
-      for ( int i = 0; i < 64; ++ i ) {
-        ++ effort;     
-        if ( condensed_code [ count ] & bit ) {
-          ++ effort;
-          (*output)[offset + i] . push_back ( count );
-        } // if
-        bit <<= 1;
-      } // for bit index
-    } // for morse set
-  } // for groups
+    }
+  } // for morse set
 #ifdef CMG_VERBOSE
   std::cout << "\r100%  Reachability Analysis Complete.\n ";
 #endif
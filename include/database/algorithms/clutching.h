@@ -5,7 +5,7 @@
 #include <stack>
 #include <vector>
 #include <ctime>
-#include <set>
+#include <map>
 
 #include "boost/serialization/vector.hpp"
 #include "boost/serialization/map.hpp"
@@ -14,264 +14,320 @@
 #include "database/structures/Atlas.h"
 #include "database/structures/TreeGrid.h"
 #include "database/structures/MorseGraph.h"
+#include "database/structures/MorseGraphCode.h"
 #include "database/structures/Database.h"
 #include "database/structures/Tree.h"
 
 // Declaration
+
+/// Clutching
+///   Record in result -> edges, in increasing order, the pairs ( i, j ) such
+///   that Morse set i of graph1 meets Morse set j of graph2.
+///   Each leaf of the two phase space partitions is labelled once with the
+///   Morse set containing it (clutchingLabels), then one depth first sweep
+///   over both partitions together pairs up the labels of overlapping leaves
+///   (clutchingSweep). The cost is linear in the sizes of the trees.
 inline void Clutching( BG_Data * result,
                const MorseGraph & graph1,
                const MorseGraph & graph2 );
 
+/// Clutching
+///   As above, for Morse graphs in compact form. The labelled leaf sequences
+///   of the two codes are read together in one preorder pass, so no grids
+///   are rebuilt.
+inline void Clutching( BG_Data * result,
+               const MorseGraphCode & code1,
+               const MorseGraphCode & code2 );
+
+/// clutchingLabels
+///   Set labels [ ge ] to i for each leaf ge of "partition" meeting 
+///   morse_sets [ i ], and to morse_sets . size () for leaves meeting none.
+///   Null entries of morse_sets are skipped.
+inline void clutchingLabels ( std::vector<uint64_t> * labels,
+                              const TreeGrid & partition,
+                              const std::vector < std::shared_ptr<const TreeGrid> > & morse_sets );
+
+/// clutchingSweep
+///   Walk partition1 and partition2 together and set 
+///   meets [ i * N2 + j ] whenever a leaf labelled i in partition1 overlaps
+///   a leaf labelled j in partition2. (Labels N1 and N2 mean "none".)
+inline void clutchingSweep ( std::vector<char> * meets,
+                             const TreeGrid & partition1,
+                             const std::vector<uint64_t> & labels1,
+                             uint64_t N1,
+                             const TreeGrid & partition2,
+                             const std::vector<uint64_t> & labels2,
+                             uint64_t N2 );
+
+/// clutchingSweep
+///   As above, for one chart of each of two Morse graph codes
+inline void clutchingSweep ( std::vector<char> * meets,
+                             const MorseGraphCode & code1,
+                             const MorseGraphCode::Chart & chart1,
+                             const MorseGraphCode & code2,
+                             const MorseGraphCode::Chart & chart2 );
+
 // Definition
 inline void Clutching( BG_Data * result,
                const MorseGraph & graph1,
                const MorseGraph & graph2 ) {
-
   typedef MorseGraph::Vertex Vertex;
-  std::set < std::pair < Vertex, Vertex > > bipartite_graph;
-
+  typedef std::shared_ptr<const TreeGrid> TreeGridPtr;
   size_t N1 = graph1 . NumVertices ();
   size_t N2 = graph2 . NumVertices ();
-  
-  // Dynamic dispatch.
-  std::vector < std::vector < std::shared_ptr<const TreeGrid> > > 
-    graph1_trees, graph2_trees;
-  size_t num_charts = 1;
-  if ( std::dynamic_pointer_cast<const Atlas> ( graph1 . phaseSpace () ) ) {
-  	const Atlas & atlas1 = * std::dynamic_pointer_cast<const Atlas> 
-      ( graph1 . phaseSpace () );
-  	const Atlas & atlas2 = * std::dynamic_pointer_cast<const Atlas> 
-      ( graph2 . phaseSpace () );
-
-  	// Determine number of charts.
-  	size_t num_charts1 = atlas1 . numCharts ();
-  	size_t num_charts2 = atlas2 . numCharts ();
-  	if ( num_charts1 != num_charts2 ) {
-  		return; // No clutching due to being incompatible.
-  	}
-  	num_charts = num_charts1;
-  	graph1_trees . resize ( num_charts, 
-      std::vector < std::shared_ptr<const TreeGrid> > ( N1 ) );
-  	graph2_trees . resize ( num_charts, 
-      std::vector < std::shared_ptr<const TreeGrid> > ( N2 ) );
+  if ( not graph1 . phaseSpace () || not graph2 . phaseSpace () ) return;
 
-  	// Loop through vertices and charts
-  	for ( size_t i = 0; i < N1; ++ i ) {
-  		const Atlas & atlas = * std::dynamic_pointer_cast<const Atlas> 
-        ( graph1 . grid ( i ) );
-      size_t count = 0;
+  // Dynamic dispatch. Collect, for each chart, the partitions of both
+  // graphs and the chart of each Morse set (null if empty)
+  std::vector < std::pair < TreeGridPtr, TreeGridPtr > > partitions;
+  std::vector < std::vector < TreeGridPtr > > graph1_trees, graph2_trees;
+  std::shared_ptr<const Atlas> atlas1 = 
+    std::dynamic_pointer_cast<const Atlas> ( graph1 . phaseSpace () );
+  std::shared_ptr<const Atlas> atlas2 = 
+    std::dynamic_pointer_cast<const Atlas> ( graph2 . phaseSpace () );
+  if ( atlas1 && atlas2 ) {
+    if ( atlas1 -> numCharts () != atlas2 -> numCharts () ) {
+      return; // No clutching due to being incompatible.
+    }
+    // Charts are matched by id
+    std::map < Atlas::size_type, size_t > chart_index;
+    for ( Atlas::IdChartPair const& pair : atlas1 -> charts () ) {
+      for ( Atlas::IdChartPair const& other : atlas2 -> charts () ) {
+        if ( other . first != pair . first ) continue;
+        chart_index [ pair . first ] = partitions . size ();
+        partitions . push_back ( std::make_pair ( pair . second, other . second ) );
+      }
+    }
+    graph1_trees . resize ( partitions . size (), std::vector < TreeGridPtr > ( N1 ) );
+    graph2_trees . resize ( partitions . size (), std::vector < TreeGridPtr > ( N2 ) );
+    for ( size_t i = 0; i < N1; ++ i ) {
+      const Atlas & atlas = * std::dynamic_pointer_cast<const Atlas> ( graph1 . grid ( i ) );
       for ( Atlas::IdChartPair const& pair : atlas . charts () ) {
-  			Atlas::Chart chart = pair . second;
-        if ( chart -> size () > 0 ) {
-  			 graph1_trees[count][i] = chart;
-        } else {
-         graph1_trees[count][i] . reset ();
-        }
-        ++ count;
-  		}
-  	}
-  	for ( size_t i = 0; i < N2; ++ i ) {
-  		const Atlas & atlas = * std::dynamic_pointer_cast<const Atlas> 
-        ( graph2 . grid ( i ) );
-      size_t count = 0;
+        if ( chart_index . count ( pair . first ) == 0 ) continue;
+        if ( pair . second -> size () == 0 ) continue;
+        graph1_trees [ chart_index [ pair . first ] ] [ i ] = pair . second;
+      }
+    }
+    for ( size_t i = 0; i < N2; ++ i ) {
+      const Atlas & atlas = * std::dynamic_pointer_cast<const Atlas> ( graph2 . grid ( i ) );
       for ( Atlas::IdChartPair const& pair : atlas . charts () ) {
-  			Atlas::Chart chart = pair . second;
-        if ( chart -> size () > 0 ) {
-         graph2_trees[count][i] = chart;
-        } else {
-         graph2_trees[count][i] . reset ();
-        }
-        ++ count;
-  		}
-  	}
+        if ( chart_index . count ( pair . first ) == 0 ) continue;
+        if ( pair . second -> size () == 0 ) continue;
+        graph2_trees [ chart_index [ pair . first ] ] [ i ] = pair . second;
+      }
+    }
   }
 
-  if ( std::dynamic_pointer_cast<const TreeGrid> ( graph1 . phaseSpace () ) ) {
-  	graph1_trees . resize ( num_charts, 
-      std::vector < std::shared_ptr<const TreeGrid> > ( N1 ) );
-  	graph2_trees . resize ( num_charts, 
-      std::vector < std::shared_ptr<const TreeGrid> > ( N2 ) );
-// Loop through vertices and charts
-  	for ( size_t i = 0; i < N1; ++ i ) {
-  		graph1_trees[0][i] = std::dynamic_pointer_cast<const TreeGrid> 
-        ( graph1 . grid ( i ) );
-  	}
-  	for ( size_t i = 0; i < N2; ++ i ) {
-  		graph2_trees[0][i] = std::dynamic_pointer_cast<const TreeGrid> 
-        ( graph2 . grid ( i ) );
-  	}
+  TreeGridPtr tree1 = std::dynamic_pointer_cast<const TreeGrid> ( graph1 . phaseSpace () );
+  TreeGridPtr tree2 = std::dynamic_pointer_cast<const TreeGrid> ( graph2 . phaseSpace () );
+  if ( tree1 && tree2 ) {
+    partitions . push_back ( std::make_pair ( tree1, tree2 ) );
+    graph1_trees . resize ( 1, std::vector < TreeGridPtr > ( N1 ) );
+    graph2_trees . resize ( 1, std::vector < TreeGridPtr > ( N2 ) );
+    for ( size_t i = 0; i < N1; ++ i ) {
+      graph1_trees [ 0 ] [ i ] = std::dynamic_pointer_cast<const TreeGrid> ( graph1 . grid ( i ) );
+    }
+    for ( size_t i = 0; i < N2; ++ i ) {
+      graph2_trees [ 0 ] [ i ] = std::dynamic_pointer_cast<const TreeGrid> ( graph2 . grid ( i ) );
+    }
   }
 
-  // Loop through charts.
-  // For each chart, make a collection of tree references
-  // Modify the algorithm to use the references rather than -> grid ( i) . tree ()
-  for ( size_t chart_id = 0; chart_id < num_charts; ++ chart_id ) {
-  	const std::vector< std::shared_ptr<const TreeGrid> > & trees1 
-      = graph1_trees [ chart_id ];
-  	const std::vector< std::shared_ptr<const TreeGrid> > & trees2 
-      = graph2_trees [ chart_id ];
-
-  	typedef Tree::iterator iterator;
+  // meets [ i * N2 + j ] is set if Morse sets i and j meet in some chart
+  std::vector<char> meets ( N1 * N2, 0 );
+  std::vector<uint64_t> labels1, labels2;
+  for ( size_t chart_id = 0; chart_id < partitions . size (); ++ chart_id ) {
+    const TreeGrid & partition1 = * partitions [ chart_id ] . first;
+    const TreeGrid & partition2 = * partitions [ chart_id ] . second;
+    clutchingLabels ( & labels1, partition1, graph1_trees [ chart_id ] );
+    clutchingLabels ( & labels2, partition2, graph2_trees [ chart_id ] );
+    clutchingSweep ( & meets, partition1, labels1, N1, partition2, labels2, N2 );
+  }
 
-  // How this works:
-  // We want to advance through the trees simultaneously, but they 
-  // aren't all the same tree. If we explore a subtree in some trees 
-  // that does not exist in others, we remain halted on the others
-  // until the subtree finishes.
-  //
-  // initialize iterators
+  // Return result
+  for ( size_t i = 0; i < N1; ++ i ) {
+    for ( size_t j = 0; j < N2; ++ j ) {
+      if ( meets [ i * N2 + j ] ) {
+        result -> edges . push_back ( std::make_pair ( (Vertex) i, (Vertex) j ) );
+      }
+    }
+  }
+}
 
-  // State machine:
-  // State 0: Try to go left. If can't, set success to false and try to go right. Otherwise success is true and try to go left on next iteration.
-  // State 1: Try to go right. If can't, set success to false and rise. Otherwise success is true and try to go left on next iteration.
-  // State 2: Rise. If rising from the right, rise again on next iteration. Otherwise try to go right on the next iteration.
-  	std::vector < iterator > iters1 ( N1 );
-  	std::vector < iterator > iters2 ( N2 );
-  	for ( size_t i = 0; i < N1; ++ i ) 
-      if ( trees1[i] ) iters1[i] = trees1[i] -> treeBegin ();
-  	for ( size_t i = 0; i < N2; ++ i ) 
-      if ( trees2[i] ) iters2[i] = trees2[i] -> treeBegin ();
-  	std::vector < size_t > depth1 ( N1, 0 );
-  	std::vector < size_t > depth2 ( N2, 0 );
-  	size_t depth = 0;
-  	int state = 0;
+inline void Clutching( BG_Data * result,
+               const MorseGraphCode & code1,
+               const MorseGraphCode & code2 ) {
+  typedef MorseGraph::Vertex Vertex;
+  size_t N1 = code1 . NumVertices ();
+  size_t N2 = code2 . NumVertices ();
+  if ( code1 . atlas () != code2 . atlas () ) return;
+  if ( code1 . charts () . size () != code2 . charts () . size () ) return;
+  // Charts are matched by id
+  std::vector<char> meets ( N1 * N2, 0 );
+  for ( const MorseGraphCode::Chart & chart1 : code1 . charts () ) {
+    for ( const MorseGraphCode::Chart & chart2 : code2 . charts () ) {
+      if ( chart1 . id != chart2 . id ) continue;
+      clutchingSweep ( & meets, code1, chart1, code2, chart2 );
+    }
+  }
+  for ( size_t i = 0; i < N1; ++ i ) {
+    for ( size_t j = 0; j < N2; ++ j ) {
+      if ( meets [ i * N2 + j ] ) {
+        result -> edges . push_back ( std::make_pair ( (Vertex) i, (Vertex) j ) );
+      }
+    }
+  }
+}
 
-  //std::cout << "Clutching Function.\n";
-  //std::cout << "N1 = " << N1 << " and N2 = " << N2 << "\n";
-  		while ( 1 ) {
-  			if ( (depth == 0) && ( state == 2 ) ) break;
-    //std::cout << "Position 0. depth = " << depth << " and state = " << state << "\n";
-  			bool success = false;
-  			Vertex set1 = N1;
-  			Vertex set2 = N2;
-  			for ( size_t i = 0; i < N1; ++ i ) {
-          if ( not trees1 [ i ] ) continue;
-      //std::cout << "Position 1. i = " << i << ", depth = " << depth << " and state = " << state << "\n";
-      // If node is halted, continue
-  				if ( depth1[i] == depth ) {
-  					iterator end = trees1[i] -> treeEnd ();
-  					switch ( state ) {
-  						case 0:
-  						{
-  							iterator left = trees1[i] -> left ( iters1 [ i ] );
-  							if ( left == end ) break;
-  							iters1[i] = left;
-  							++ depth1[i];
-  							success = true;
-  							break;
-  						}
-  						case 1:
-  						{
-  							iterator right = trees1 [ i ] -> right ( iters1 [ i ] );
-  							if ( right == end ) break;
-  							iters1[i] = right;
-  							++ depth1[i];
-  							success = true;
-  							break;
-  						}
-  						case 2:
-  						{
-  							if ( trees1 [ i ] -> tree () . isRight ( iters1 [ i ] ) ) 
-                    success = true;
-  							iters1[i] = trees1 [ i ] -> parent ( iters1 [ i ] );
-  							-- depth1[i];
-  							break;
-  						}
-  					}
-  				}
-  				if ( trees1 [ i ] -> isGrid ( iters1 [ i ] ) ) {
-  					if ( set1 != (Vertex)N1 ) std::cout << "Warning, morse sets are not disjoint.\n";
-  					set1 = (Vertex)i;
-  				}
+inline void 
+clutchingLabels ( std::vector<uint64_t> * labels,
+                  const TreeGrid & partition,
+                  const std::vector < std::shared_ptr<const TreeGrid> > & morse_sets ) {
+  uint64_t N = morse_sets . size ();
+  labels -> assign ( partition . size (), N );
+  for ( uint64_t i = 0; i < N; ++ i ) {
+    if ( not morse_sets [ i ] || morse_sets [ i ] -> size () == 0 ) continue;
+    // Walks only the part of "partition" under the leaves of Morse set i
+    std::vector<Grid::GridElement> leaves = partition . subset ( * morse_sets [ i ] );
+    BOOST_FOREACH ( Grid::GridElement ge, leaves ) (*labels) [ ge ] = i;
+  }
+}
 
-  			}
-  			for ( size_t i = 0; i < N2; ++ i ) {
-          if ( not trees2 [ i ] ) continue;
-      //std::cout << "Position 2. i = " << i << ", depth = " << depth << " and state = " << state << "\n";
-      // If node is halted, continue
-  				if ( depth2[i] == depth ) {
-  					iterator end = trees2 [ i ] -> treeEnd ();
-  					switch ( state ) {
-  						case 0:
-  						{
-  							iterator left = trees2 [ i ] -> left ( iters2 [ i ] );
-  							if ( left == end ) break;
-  							iters2[i] = left;
-  							++ depth2[i];
-  							success = true;
-  							break;
-  						}
-  						case 1:
-  						{
-  							iterator right = trees2 [ i ] -> right ( iters2 [ i ] );
-  							if ( right == end ) break;
-  							iters2[i] = right;
-  							++ depth2[i];
-  							success = true;
-  							break;
-  						}
-  						case 2:
-  						{
-  							if ( trees2 [ i ] -> tree () . isRight ( iters2 [ i ] ) ) 
-                    success = true;
-  							iters2[i] = trees2 [ i ] -> parent ( iters2 [ i ] );
-  							-- depth2[i];
-  							break;
-  						}
-  					}
-  				}
-  				if ( trees2 [ i ] -> isGrid ( iters2 [ i ] ) ) {
-  					if ( set2 != (Vertex)N2 ) std::cout << "Warning, morse sets are not disjoint.\n";
-  					set2 = (Vertex)i;
-  				}
-  			}
-    //std::cout << "Position 3. depth = " << depth << " and state = " << state << "\n";
-    //std::cout << ( success ? "success" : "failure" );
-  			switch ( state ) {
-      case 0: // Tried to go left
-      if ( success ) {
-          // Success. Try to go left again.
-      	state = 0;
-      	++ depth;
-      } else {
-          // Failure. Try to go right instead.
-      	state = 1;
-      }
-      break;
-      case 1: // Tried to go right
-      if ( success ) {
-          // Sucess. Try to go left now.
-      	state = 0;
-      	++ depth;
-      } else {
-          // Failure. Rise.
-      	state = 2;
-      }
-      break;
-      case 2: // Rose
-      -- depth;
-      if ( success ) {
-          // Rose from right, continue to rise
-      	state = 2;
-      } else {
-          // Rose from left, try to go right
-      	state = 1;
+inline void 
+clutchingSweep ( std::vector<char> * meets,
+                 const TreeGrid & partition1,
+                 const std::vector<uint64_t> & labels1,
+                 uint64_t N1,
+                 const TreeGrid & partition2,
+                 const std::vector<uint64_t> & labels2,
+                 uint64_t N2 ) {
+  typedef Tree::iterator iterator;
+  if ( partition1 . size () == 0 || partition2 . size () == 0 ) return;
+  // Pairs of nodes with the same position in both trees
+  std::stack < std::pair < iterator, iterator > > work;
+  // Nodes under a leaf of the other partition
+  std::stack < iterator > under;
+  work . push ( std::make_pair ( partition1 . treeBegin (), partition2 . treeBegin () ) );
+  while ( not work . empty () ) {
+    iterator it1 = work . top () . first;
+    iterator it2 = work . top () . second;
+    work . pop ();
+    bool leaf1 = partition1 . tree () . isLeaf ( it1 );
+    bool leaf2 = partition2 . tree () . isLeaf ( it2 );
+    if ( leaf1 || leaf2 ) {
+      // Pair the label of the leaf with those of all leaves under the other node
+      // (the trees are swapped so that the leaf is in "leaf_tree")
+      bool swap = not leaf1;
+      const TreeGrid & leaf_tree = swap ? partition2 : partition1;
+      const TreeGrid & other_tree = swap ? partition1 : partition2;
+      const std::vector<uint64_t> & leaf_labels = swap ? labels2 : labels1;
+      const std::vector<uint64_t> & other_labels = swap ? labels1 : labels2;
+      uint64_t leaf_none = swap ? N2 : N1;
+      uint64_t other_none = swap ? N1 : N2;
+      iterator leaf = swap ? it2 : it1;
+      if ( not leaf_tree . isGrid ( leaf ) ) continue;
+      uint64_t label = leaf_labels [ * leaf_tree . TreeToGrid ( leaf ) ];
+      if ( label == leaf_none ) continue;
+      under . push ( swap ? it1 : it2 );
+      while ( not under . empty () ) {
+        iterator it = under . top ();
+        under . pop ();
+        if ( other_tree . tree () . isLeaf ( it ) ) {
+          if ( not other_tree . isGrid ( it ) ) continue;
+          uint64_t other_label = other_labels [ * other_tree . TreeToGrid ( it ) ];
+          if ( other_label == other_none ) continue;
+          if ( swap ) {
+            (*meets) [ other_label * N2 + label ] = 1;
+          } else {
+            (*meets) [ label * N2 + other_label ] = 1;
+          }
+          continue;
+        }
+        iterator left = other_tree . left ( it );
+        iterator right = other_tree . right ( it );
+        if ( left != other_tree . treeEnd () ) under . push ( left );
+        if ( right != other_tree . treeEnd () ) under . push ( right );
       }
-      break;
+      continue;
     }
-    // Gather all intersection information
-    if ( (set1 != (Vertex)N1 ) && (set2 != (Vertex)N2 ) ) {
-      //std::cout << "Record intersection (" << set1 << ", " << set2 << ")\n";
-
-    	bipartite_graph . insert ( std::pair < Vertex, Vertex > ( set1, set2 ) );
+    // Follow the branches both trees share
+    iterator left1 = partition1 . left ( it1 );
+    iterator left2 = partition2 . left ( it2 );
+    if ( left1 != partition1 . treeEnd () && left2 != partition2 . treeEnd () ) {
+      work . push ( std::make_pair ( left1, left2 ) );
+    }
+    iterator right1 = partition1 . right ( it1 );
+    iterator right2 = partition2 . right ( it2 );
+    if ( right1 != partition1 . treeEnd () && right2 != partition2 . treeEnd () ) {
+      work . push ( std::make_pair ( right1, right2 ) );
     }
   }
 }
-  // Advance iterators to end, collecting intersections
-  // Return result
-  //std::cout << "Collate Results.\n";
-  for ( MorseGraph::Edge const& edge : bipartite_graph ) {
-    result -> edges . push_back ( edge );
+
+inline void
+clutchingSweep ( std::vector<char> * meets,
+                 const MorseGraphCode & code1,
+                 const MorseGraphCode::Chart & chart1,
+                 const MorseGraphCode & code2,
+                 const MorseGraphCode::Chart & chart2 ) {
+  uint64_t N1 = code1 . NumVertices ();
+  uint64_t N2 = code2 . NumVertices ();
+  if ( N1 == 0 || N2 == 0 ) return;
+  const BitSequence & nodes1 = chart1 . tree . leaf_sequence;
+  const BitSequence & nodes2 = chart2 . tree . leaf_sequence;
+  const BitSequence & valid1 = chart1 . tree . valid_sequence;
+  const BitSequence & valid2 = chart2 . tree . valid_sequence;
+  // Position in each leaf sequence, count of leaves passed (indexing the
+  // valid sequence) and of valid leaves passed (indexing the labels)
+  size_t i1 = 0, i2 = 0;
+  uint64_t leaf1 = 0, leaf2 = 0;
+  uint64_t valid_leaf1 = 0, valid_leaf2 = 0;
+  // Both positions are at the same node of the two trees. Where one tree
+  // has a leaf and the other a subtree, the subtree is read through, and
+  // the walk is at the same node again.
+  while ( i1 < nodes1 . size () && i2 < nodes2 . size () ) {
+    bool internal1 = nodes1 [ i1 ];
+    bool internal2 = nodes2 [ i2 ];
+    if ( internal1 && internal2 ) {
+      ++ i1; ++ i2;
+      continue;
+    }
+    // Label of the leaf (or one of the leaves) at this node
+    bool swap = internal1;
+    size_t & i = swap ? i2 : i1;
+    uint64_t & leaf = swap ? leaf2 : leaf1;
+    uint64_t & valid_leaf = swap ? valid_leaf2 : valid_leaf1;
+    const BitSequence & valid = swap ? valid2 : valid1;
+    const MorseGraphCode & code = swap ? code2 : code1;
+    const MorseGraphCode::Chart & chart = swap ? chart2 : chart1;
+    uint64_t label = swap ? N2 : N1;
+    if ( valid [ leaf ++ ] ) label = code . label ( chart, valid_leaf ++ );
+    ++ i;
+    // Pair it with the labels of all leaves under the other node
+    size_t & j = swap ? i1 : i2;
+    uint64_t & other_leaf = swap ? leaf1 : leaf2;
+    uint64_t & other_valid_leaf = swap ? valid_leaf1 : valid_leaf2;
+    const BitSequence & other_nodes = swap ? nodes1 : nodes2;
+    const BitSequence & other_valid = swap ? valid1 : valid2;
+    const MorseGraphCode & other_code = swap ? code1 : code2;
+    const MorseGraphCode::Chart & other_chart = swap ? chart1 : chart2;
+    uint64_t none = swap ? N2 : N1;
+    uint64_t other_none = swap ? N1 : N2;
+    uint64_t open = 1;
+    while ( open > 0 ) {
+      if ( other_nodes [ j ++ ] ) {
+        ++ open;
+        continue;
+      }
+      -- open;
+      if ( not other_valid [ other_leaf ++ ] ) continue;
+      uint64_t other_label = other_code . label ( other_chart, other_valid_leaf ++ );
+      if ( label == none || other_label == other_none ) continue;
+      if ( swap ) {
+        (*meets) [ other_label * N2 + label ] = 1;
+      } else {
+        (*meets) [ label * N2 + other_label ] = 1;
+      }
+    }
   }
 }
 
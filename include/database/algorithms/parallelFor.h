@@ -0,0 +1,80 @@
+// parallelFor.h
+#ifndef CMDB_PARALLELFOR_H
+#define CMDB_PARALLELFOR_H
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <vector>
+#include "boost/thread.hpp"
+
+/// resolveThreadCount
+///   Translate a requested thread count into an actual one.
+///   A request of 0 (or less) means "one thread per hardware core".
+inline int
+resolveThreadCount ( int requested ) {
+  if ( requested > 0 ) return requested;
+  int hardware = (int) boost::thread::hardware_concurrency ();
+  return std::max ( hardware, 1 );
+}
+
+/// parallelFor
+///   Apply "work" to the index range [begin, end) using "threads" worker threads.
+///   The range is cut into chunks of "chunk" consecutive indices which are handed
+///   out on demand, so that uneven per-index costs balance themselves out.
+///   "work" is called as work ( chunk_begin, chunk_end, thread_id ), where
+///   thread_id is in [0, threads). It must be safe to call concurrently on
+///   disjoint chunks.
+///   If there is less than one chunk per thread the loop runs serially in the
+///   calling thread. The first exception thrown by a worker is rethrown here
+///   once all workers have stopped. If the calling thread is interrupted
+///   (boost::thread::interrupt) the workers are interrupted and joined first.
+template < class Work >
+void
+parallelFor ( uint64_t begin,
+              uint64_t end,
+              uint64_t chunk,
+              int threads,
+              const Work & work ) {
+  if ( end <= begin ) return;
+  if ( chunk == 0 ) chunk = 1;
+  uint64_t num_chunks = ( end - begin + chunk - 1 ) / chunk;
+  if ( threads <= 1 || num_chunks < (uint64_t) threads ) {
+    work ( begin, end, 0 );
+    return;
+  }
+  std::atomic<uint64_t> next_chunk ( 0 );
+  std::exception_ptr failure;
+  boost::mutex failure_mutex;
+  boost::thread_group workers;
+  for ( int thread_id = 0; thread_id < threads; ++ thread_id ) {
+    workers . create_thread ( [&, thread_id] () {
+      try {
+        while ( 1 ) {
+          boost::this_thread::interruption_point ();
+          uint64_t c = next_chunk ++;
+          if ( c >= num_chunks ) break;
+          uint64_t chunk_begin = begin + c * chunk;
+          uint64_t chunk_end = std::min ( end, chunk_begin + chunk );
+          work ( chunk_begin, chunk_end, thread_id );
+        }
+      } catch ( ... ) {
+        // Stop handing out chunks and remember the first failure
+        next_chunk = num_chunks;
+        boost::lock_guard<boost::mutex> lock ( failure_mutex );
+        if ( not failure ) failure = std::current_exception ();
+      }
+    });
+  }
+  try {
+    workers . join_all ();
+  } catch ( boost::thread_interrupted & ) {
+    workers . interrupt_all ();
+    workers . join_all ();
+    throw;
+  }
+  if ( failure ) std::rethrow_exception ( failure );
+}
+
+#endif
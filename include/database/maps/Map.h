@@ -3,12 +3,51 @@
 
 #include <memory>
 #include "database/structures/Geo.h"
+#include "database/structures/RectGeo.h"
+#include "database/structures/BoxBatch.h"
 
 class Map {
 public:
   virtual ~Map ( void ) {}
   virtual std::shared_ptr<Geo> operator () ( std::shared_ptr<Geo> geo ) const = 0;
+
+  /// operator ()
+  ///   Evaluate the map on a box, writing the image (also a box) into
+  ///   "image", and return true. Maps which implement this can be evaluated
+  ///   without allocating memory once "image" has the right dimension.
+  ///   The default returns false, meaning the caller should use the
+  ///   shared_ptr version above instead. A map either implements this for
+  ///   every box or not at all.
+  virtual bool operator () ( const RectGeo & box, RectGeo * image ) const {
+    return false;
+  }
+
+  /// operator ()
+  ///   Evaluate the map on a batch of boxes, writing the images (also
+  ///   boxes) into "images", and return true. Maps written to work on
+  ///   whole arrays of bounds at a time (e.g. with SIMD) override this.
+  ///   The default evaluates the boxes one at a time with the versions
+  ///   above, and returns false if an image is not a box.
+  virtual bool operator () ( const BoxBatch & boxes, BoxBatch * images ) const;
 private:
 };
 
+inline bool
+Map::operator () ( const BoxBatch & boxes, BoxBatch * images ) const {
+  RectGeo box, image;
+  for ( size_t i = 0; i < boxes . size (); ++ i ) {
+    boxes . get ( i, & box );
+    if ( not (*this) ( box, & image ) ) {
+      std::shared_ptr<RectGeo> image_ptr = std::dynamic_pointer_cast<RectGeo> 
+        ( (*this) ( std::shared_ptr<Geo> ( new RectGeo ( box ) ) ) );
+      if ( not image_ptr ) return false;
+      image = * image_ptr;
+    }
+    if ( i == 0 ) images -> resize ( image . dimension (), boxes . size () );
+    images -> set ( i, image );
+  }
+  if ( boxes . size () == 0 ) images -> resize ( boxes . dimension (), 0 );
+  return true;
+}
+
 #endif
@@ -0,0 +1,510 @@
+/* ROUNDED INTERVAL CLASSES */
+
+// rounded_interval is a drop-in replacement for simple_interval whose
+// results enclose the exact ones; interval_lanes applies the same arithmetic
+// to several intervals at once, for maps evaluated on batches of boxes.
+
+#ifndef CMDB_VECTORINTERVAL_H
+#define CMDB_VECTORINTERVAL_H
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <cstring>
+#include <stdint.h>
+#if defined(__AVX512F__) && not defined(CMDB_INTERVAL_NO_INTRINSICS)
+#include <immintrin.h>
+#endif
+
+/// CMDB_INTERVAL_LANES
+///   Default number of intervals in an interval_lanes<double>: one vector
+///   register of doubles for the instruction set being compiled for.
+#ifndef CMDB_INTERVAL_LANES
+#if defined(__AVX512F__)
+#define CMDB_INTERVAL_LANES 8
+#elif defined(__AVX__)
+#define CMDB_INTERVAL_LANES 4
+#else
+#define CMDB_INTERVAL_LANES 2
+#endif
+#endif
+
+/// Outward rounding
+///   Bounds are computed in the default rounding mode (to nearest) and then
+///   moved outward by step ( x ) = |x| eps + min, which is at least one unit
+///   in the last place of x. ( min is the least normal number; subnormal
+///   operands are very slow on x86. ) Since + - * / are correctly rounded,
+///   one step encloses their exact results. The C library log and pow are
+///   accurate to within an ulp, so their results are moved out two steps;
+///   exp of a double is computed inline, see exp_bounds_inline.
+///   The rounding mode is never changed, so the same code is rigorous in
+///   every thread and in every SIMD lane, and the lane loops below contain
+///   only arithmetic, min, max and selects, which compilers vectorize.
+///   This is the portable path. When compiling for AVX-512, + - * / on
+///   interval_lanes<double,8> instead use the instructions' own directed
+///   rounding (see "AVX-512 kernels" below), which is also per instruction
+///   and leaves the rounding mode alone; define CMDB_INTERVAL_NO_INTRINSICS
+///   to use the portable path there too.
+
+template < class Real >
+inline Real interval_step ( Real x ) {
+  // Capped so that infinite bounds stay infinite rather than become NaN
+  return std::min ( std::abs ( x ) * std::numeric_limits<Real>::epsilon ()
+                    + std::numeric_limits<Real>::min (),
+                    std::numeric_limits<Real>::max () );
+}
+
+// An infinite result may stand for a finite one which overflowed, so
+// rounding +infinity down gives the greatest finite number (and -infinity
+// up the least)
+
+template < class Real >
+inline Real round_down ( Real x ) {
+  return std::min ( x - interval_step ( x ), std::numeric_limits<Real>::max () );
+}
+
+template < class Real >
+inline Real round_up ( Real x ) {
+  return std::max ( x + interval_step ( x ), - std::numeric_limits<Real>::max () );
+}
+
+// Kernels on ( lower, upper ) pairs, shared by both classes
+
+template < class Real >
+inline void interval_add ( Real al, Real au, Real bl, Real bu, Real & l, Real & u ) {
+  l = round_down ( al + bl );
+  u = round_up ( au + bu );
+}
+
+template < class Real >
+inline void interval_sub ( Real al, Real au, Real bl, Real bu, Real & l, Real & u ) {
+  l = round_down ( al - bu );
+  u = round_up ( au - bl );
+}
+
+template < class Real >
+inline void interval_mul ( Real al, Real au, Real bl, Real bu, Real & l, Real & u ) {
+  Real a = al * bl;
+  Real b = al * bu;
+  Real c = au * bl;
+  Real d = au * bu;
+  l = round_down ( std::min ( std::min ( a, b ), std::min ( c, d ) ) );
+  u = round_up ( std::max ( std::max ( a, b ), std::max ( c, d ) ) );
+}
+
+template < class Real >
+inline void interval_div ( Real al, Real au, Real bl, Real bu, Real & l, Real & u ) {
+  Real a = al / bl;
+  Real b = al / bu;
+  Real c = au / bl;
+  Real d = au / bu;
+  // A divisor containing zero gives the whole line
+  bool finite = ( bl > 0 ) || ( bu < 0 );
+  l = finite ? round_down ( std::min ( std::min ( a, b ), std::min ( c, d ) ) )
+             : - std::numeric_limits<Real>::infinity ();
+  u = finite ? round_up ( std::max ( std::max ( a, b ), std::max ( c, d ) ) )
+             : std::numeric_limits<Real>::infinity ();
+}
+
+/// exp_bounds
+///   Set l <= exp ( x ) <= u
+template < class Real >
+inline void exp_bounds ( Real x, Real & l, Real & u ) {
+  Real y = std::exp ( x );
+  l = std::max ( round_down ( round_down ( y ) ), Real ( 0 ) );
+  u = round_up ( round_up ( y ) );
+}
+
+/// exp_bounds_inline
+///   As exp_bounds, for -708 <= x <= 709, without a library call or a
+///   branch, so that loops over it vectorize. Outside that range the
+///   results are meaningless.
+///   x = k log 2 + r with |r| <= log(2)/2 (Cody-Waite reduction with a split
+///   log 2, exact for the k in range), exp ( r ) is the Taylor polynomial of
+///   degree 13 (truncation error below 2^-60), and 2^k is assembled from
+///   its exponent bits. The result is good to a few ulps; the bounds are
+///   moved out by a relative 2^-48, far more than that.
+inline void exp_bounds_inline ( double x, double & l, double & u ) {
+  const double log2e = 1.4426950408889634074;
+  const double ln2_hi = 6.93147180369123816490e-01;   // 32 significant bits
+  const double ln2_lo = 1.90821492927058770002e-10;
+  const double shift = 6755399441055744.0;            // 1.5 * 2^52
+  const double margin = 1.0 / 281474976710656.0;      // 2^-48
+  // t holds k = round ( x / log 2 ) in its low mantissa bits
+  double t = x * log2e + shift;
+  double k = t - shift;
+  double r = ( x - k * ln2_hi ) - k * ln2_lo;
+  double p = 1.0 / 6227020800.0;
+  p = p * r + 1.0 / 479001600.0;
+  p = p * r + 1.0 / 39916800.0;
+  p = p * r + 1.0 / 3628800.0;
+  p = p * r + 1.0 / 362880.0;
+  p = p * r + 1.0 / 40320.0;
+  p = p * r + 1.0 / 5040.0;
+  p = p * r + 1.0 / 720.0;
+  p = p * r + 1.0 / 120.0;
+  p = p * r + 1.0 / 24.0;
+  p = p * r + 1.0 / 6.0;
+  p = p * r + 1.0 / 2.0;
+  p = p * r + 1.0;
+  p = p * r + 1.0;
+  int64_t bits;
+  std::memcpy ( & bits, & t, sizeof ( double ) );
+  bits = ( ( bits + 1023 ) & 0x7ff ) << 52;
+  double scale;
+  std::memcpy ( & scale, & bits, sizeof ( double ) );
+  double e = p * scale;
+  l = round_down ( e - e * margin );
+  u = round_up ( e + e * margin );
+}
+
+/// exp_inline_range
+///   Return true if exp_bounds_inline is valid at x (false for NaN)
+inline bool exp_inline_range ( double x ) {
+  return x >= -708.0 && x <= 709.0;
+}
+
+inline void exp_bounds ( double x, double & l, double & u ) {
+  if ( exp_inline_range ( x ) ) exp_bounds_inline ( x, l, u );
+  else exp_bounds<double> ( x, l, u );
+}
+
+template < class Real >
+inline void interval_exp ( Real al, Real au, Real & l, Real & u ) {
+  Real unused;
+  exp_bounds ( al, l, unused );
+  exp_bounds ( au, unused, u );
+}
+
+/// interval_exp
+///   Lane version: the inline formula is applied to every lane, which
+///   vectorizes, and lanes out of its range are then redone one at a time
+template < class Real, int W >
+inline void interval_exp ( const Real (&al) [ W ], const Real (&au) [ W ], Real (&l) [ W ], Real (&u) [ W ] ) {
+  for ( int i = 0; i < W; ++ i ) interval_exp ( al [ i ], au [ i ], l [ i ], u [ i ] );
+}
+
+template < int W >
+inline void interval_exp ( const double (&al) [ W ], const double (&au) [ W ], double (&l) [ W ], double (&u) [ W ] ) {
+  double unused;
+  for ( int i = 0; i < W; ++ i ) {
+    exp_bounds_inline ( al [ i ], l [ i ], unused );
+    exp_bounds_inline ( au [ i ], unused, u [ i ] );
+  }
+  for ( int i = 0; i < W; ++ i ) {
+    if ( not exp_inline_range ( al [ i ] ) || not exp_inline_range ( au [ i ] ) ) {
+      interval_exp<double> ( al [ i ], au [ i ], l [ i ], u [ i ] );
+    }
+  }
+}
+
+template < class Real >
+inline void interval_log ( Real al, Real au, Real & l, Real & u ) {
+  l = round_down ( round_down ( std::log ( al ) ) );
+  u = round_up ( round_up ( std::log ( au ) ) );
+}
+
+// As with simple_interval, the base is assumed positive
+template < class Real >
+inline void interval_pow ( Real al, Real au, Real exponent, Real & l, Real & u ) {
+  Real a = exponent >= 0 ? al : au;
+  Real b = exponent >= 0 ? au : al;
+  l = std::max ( round_down ( round_down ( std::pow ( a, exponent ) ) ), Real ( 0 ) );
+  u = round_up ( round_up ( std::pow ( b, exponent ) ) );
+}
+
+/// interval_cos
+///   cos is 1 at even and -1 at odd multiples of pi. Those in [ al, au ]
+///   are found from al / pi and au / pi moved out two steps, which covers
+///   the error of the division and of the double pi; a multiple found
+///   spuriously only widens the result.
+template < class Real >
+inline void interval_cos ( Real al, Real au, Real & l, Real & u ) {
+  const Real pi = 3.1415926535897932384626433832795;
+  Real cl = std::cos ( al );
+  Real cu = std::cos ( au );
+  l = std::max ( round_down ( round_down ( std::min ( cl, cu ) ) ), Real ( -1 ) );
+  u = std::min ( round_up ( round_up ( std::max ( cl, cu ) ) ), Real ( 1 ) );
+  Real a = std::ceil ( round_down ( round_down ( al / pi ) ) );
+  Real b = std::floor ( round_up ( round_up ( au / pi ) ) );
+  if ( not ( b - a < 2 ) ) {
+    l = -1;
+    u = 1;
+    return;
+  }
+  for ( Real k = a; k <= b; k += 1 ) {
+    if ( std::fmod ( k, Real ( 2 ) ) == 0 ) u = 1; else l = -1;
+  }
+}
+
+// Lane versions of the kernels: apply the kernel to every lane
+
+template < class Real, int W >
+inline void interval_add ( const Real (&al) [ W ], const Real (&au) [ W ], const Real (&bl) [ W ], const Real (&bu) [ W ],
+                           Real (&l) [ W ], Real (&u) [ W ] ) {
+  for ( int i = 0; i < W; ++ i ) interval_add ( al [ i ], au [ i ], bl [ i ], bu [ i ], l [ i ], u [ i ] );
+}
+
+template < class Real, int W >
+inline void interval_sub ( const Real (&al) [ W ], const Real (&au) [ W ], const Real (&bl) [ W ], const Real (&bu) [ W ],
+                           Real (&l) [ W ], Real (&u) [ W ] ) {
+  for ( int i = 0; i < W; ++ i ) interval_sub ( al [ i ], au [ i ], bl [ i ], bu [ i ], l [ i ], u [ i ] );
+}
+
+template < class Real, int W >
+inline void interval_mul ( const Real (&al) [ W ], const Real (&au) [ W ], const Real (&bl) [ W ], const Real (&bu) [ W ],
+                           Real (&l) [ W ], Real (&u) [ W ] ) {
+  for ( int i = 0; i < W; ++ i ) interval_mul ( al [ i ], au [ i ], bl [ i ], bu [ i ], l [ i ], u [ i ] );
+}
+
+template < class Real, int W >
+inline void interval_div ( const Real (&al) [ W ], const Real (&au) [ W ], const Real (&bl) [ W ], const Real (&bu) [ W ],
+                           Real (&l) [ W ], Real (&u) [ W ] ) {
+  for ( int i = 0; i < W; ++ i ) interval_div ( al [ i ], au [ i ], bl [ i ], bu [ i ], l [ i ], u [ i ] );
+}
+
+#if defined(__AVX512F__) && not defined(CMDB_INTERVAL_NO_INTRINSICS)
+/// AVX-512 kernels
+///   + - * / on eight double intervals, each bound computed once with the
+///   rounding toward -infinity or +infinity encoded in the instruction
+///   (so nothing needs moving out afterwards). An overflowing bound rounds
+///   to the greatest finite number, as round_down and round_up give.
+///   The bounds are never wider than those of the portable kernels.
+#define CMDB_ROUND_DOWN ( _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC )
+#define CMDB_ROUND_UP ( _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC )
+
+inline void interval_add ( const double (&al) [ 8 ], const double (&au) [ 8 ], const double (&bl) [ 8 ], const double (&bu) [ 8 ],
+                           double (&l) [ 8 ], double (&u) [ 8 ] ) {
+  _mm512_storeu_pd ( l, _mm512_add_round_pd ( _mm512_loadu_pd ( al ), _mm512_loadu_pd ( bl ), CMDB_ROUND_DOWN ) );
+  _mm512_storeu_pd ( u, _mm512_add_round_pd ( _mm512_loadu_pd ( au ), _mm512_loadu_pd ( bu ), CMDB_ROUND_UP ) );
+}
+
+inline void interval_sub ( const double (&al) [ 8 ], const double (&au) [ 8 ], const double (&bl) [ 8 ], const double (&bu) [ 8 ],
+                           double (&l) [ 8 ], double (&u) [ 8 ] ) {
+  _mm512_storeu_pd ( l, _mm512_sub_round_pd ( _mm512_loadu_pd ( al ), _mm512_loadu_pd ( bu ), CMDB_ROUND_DOWN ) );
+  _mm512_storeu_pd ( u, _mm512_sub_round_pd ( _mm512_loadu_pd ( au ), _mm512_loadu_pd ( bl ), CMDB_ROUND_UP ) );
+}
+
+inline void interval_mul ( const double (&al) [ 8 ], const double (&au) [ 8 ], const double (&bl) [ 8 ], const double (&bu) [ 8 ],
+                           double (&l) [ 8 ], double (&u) [ 8 ] ) {
+  __m512d a_l = _mm512_loadu_pd ( al );
+  __m512d a_u = _mm512_loadu_pd ( au );
+  __m512d b_l = _mm512_loadu_pd ( bl );
+  __m512d b_u = _mm512_loadu_pd ( bu );
+  __m512d down = _mm512_min_pd ( _mm512_min_pd ( _mm512_mul_round_pd ( a_l, b_l, CMDB_ROUND_DOWN ),
+                                                 _mm512_mul_round_pd ( a_l, b_u, CMDB_ROUND_DOWN ) ),
+                                 _mm512_min_pd ( _mm512_mul_round_pd ( a_u, b_l, CMDB_ROUND_DOWN ),
+                                                 _mm512_mul_round_pd ( a_u, b_u, CMDB_ROUND_DOWN ) ) );
+  __m512d up = _mm512_max_pd ( _mm512_max_pd ( _mm512_mul_round_pd ( a_l, b_l, CMDB_ROUND_UP ),
+                                               _mm512_mul_round_pd ( a_l, b_u, CMDB_ROUND_UP ) ),
+                               _mm512_max_pd ( _mm512_mul_round_pd ( a_u, b_l, CMDB_ROUND_UP ),
+                                               _mm512_mul_round_pd ( a_u, b_u, CMDB_ROUND_UP ) ) );
+  _mm512_storeu_pd ( l, down );
+  _mm512_storeu_pd ( u, up );
+}
+
+inline void interval_div ( const double (&al) [ 8 ], const double (&au) [ 8 ], const double (&bl) [ 8 ], const double (&bu) [ 8 ],
+                           double (&l) [ 8 ], double (&u) [ 8 ] ) {
+  __m512d a_l = _mm512_loadu_pd ( al );
+  __m512d a_u = _mm512_loadu_pd ( au );
+  __m512d b_l = _mm512_loadu_pd ( bl );
+  __m512d b_u = _mm512_loadu_pd ( bu );
+  __m512d down = _mm512_min_pd ( _mm512_min_pd ( _mm512_div_round_pd ( a_l, b_l, CMDB_ROUND_DOWN ),
+                                                 _mm512_div_round_pd ( a_l, b_u, CMDB_ROUND_DOWN ) ),
+                                 _mm512_min_pd ( _mm512_div_round_pd ( a_u, b_l, CMDB_ROUND_DOWN ),
+                                                 _mm512_div_round_pd ( a_u, b_u, CMDB_ROUND_DOWN ) ) );
+  __m512d up = _mm512_max_pd ( _mm512_max_pd ( _mm512_div_round_pd ( a_l, b_l, CMDB_ROUND_UP ),
+                                               _mm512_div_round_pd ( a_l, b_u, CMDB_ROUND_UP ) ),
+                               _mm512_max_pd ( _mm512_div_round_pd ( a_u, b_l, CMDB_ROUND_UP ),
+                                               _mm512_div_round_pd ( a_u, b_u, CMDB_ROUND_UP ) ) );
+  // A divisor containing zero gives the whole line
+  __m512d zero = _mm512_setzero_pd ();
+  __mmask8 finite = _mm512_cmp_pd_mask ( b_l, zero, _CMP_GT_OQ ) | _mm512_cmp_pd_mask ( b_u, zero, _CMP_LT_OQ );
+  double infinity = std::numeric_limits<double>::infinity ();
+  _mm512_storeu_pd ( l, _mm512_mask_blend_pd ( finite, _mm512_set1_pd ( - infinity ), down ) );
+  _mm512_storeu_pd ( u, _mm512_mask_blend_pd ( finite, _mm512_set1_pd ( infinity ), up ) );
+}
+
+#undef CMDB_ROUND_DOWN
+#undef CMDB_ROUND_UP
+#endif
+
+/// rounded_interval
+///   An interval [ lower, upper ] whose operations enclose the exact result.
+///   A Real converts to the point interval [ x, x ].
+template < class Real >
+struct rounded_interval {
+  Real lower_;
+  Real upper_;
+  rounded_interval ( void ) {}
+  rounded_interval ( Real x ) : lower_(x), upper_(x) {}
+  rounded_interval ( Real lower_, Real upper_ ) : lower_(lower_), upper_(upper_) {}
+  Real lower ( void ) const { return lower_; }
+  Real upper ( void ) const { return upper_; }
+  Real mid ( void ) const { return (upper_ + lower_) / 2.0; }
+  Real radius ( void ) const { return (upper_ - lower_) / 2.0; }
+
+  friend rounded_interval operator + ( const rounded_interval & lhs, const rounded_interval & rhs ) {
+    rounded_interval result;
+    interval_add ( lhs . lower_, lhs . upper_, rhs . lower_, rhs . upper_, result . lower_, result . upper_ );
+    return result;
+  }
+
+  friend rounded_interval operator - ( const rounded_interval & lhs, const rounded_interval & rhs ) {
+    rounded_interval result;
+    interval_sub ( lhs . lower_, lhs . upper_, rhs . lower_, rhs . upper_, result . lower_, result . upper_ );
+    return result;
+  }
+
+  friend rounded_interval operator - ( const rounded_interval & term ) {
+    return rounded_interval ( - term . upper_, - term . lower_ );
+  }
+
+  friend rounded_interval operator * ( const rounded_interval & lhs, const rounded_interval & rhs ) {
+    rounded_interval result;
+    interval_mul ( lhs . lower_, lhs . upper_, rhs . lower_, rhs . upper_, result . lower_, result . upper_ );
+    return result;
+  }
+
+  friend rounded_interval operator / ( const rounded_interval & lhs, const rounded_interval & rhs ) {
+    rounded_interval result;
+    interval_div ( lhs . lower_, lhs . upper_, rhs . lower_, rhs . upper_, result . lower_, result . upper_ );
+    return result;
+  }
+
+  friend rounded_interval exp ( const rounded_interval & term ) {
+    rounded_interval result;
+    interval_exp ( term . lower_, term . upper_, result . lower_, result . upper_ );
+    return result;
+  }
+
+  friend rounded_interval log ( const rounded_interval & term ) {
+    rounded_interval result;
+    interval_log ( term . lower_, term . upper_, result . lower_, result . upper_ );
+    return result;
+  }
+
+  friend rounded_interval pow ( const rounded_interval & base, const Real exponent ) {
+    rounded_interval result;
+    interval_pow ( base . lower_, base . upper_, exponent, result . lower_, result . upper_ );
+    return result;
+  }
+
+  friend rounded_interval cos ( const rounded_interval & term ) {
+    rounded_interval result;
+    interval_cos ( term . lower_, term . upper_, result . lower_, result . upper_ );
+    return result;
+  }
+
+  friend rounded_interval square ( const rounded_interval & term ) {
+    return term * term;
+  }
+};
+
+/// interval_lanes
+///   W intervals stored as an array of lower bounds and an array of upper
+///   bounds. Every operation acts lane by lane; a Real or a rounded_interval
+///   converts by filling every lane with it. Load W consecutive intervals
+///   from the bound arrays of a BoxBatch, evaluate the map's formulas, and
+///   store the results.
+///   With the AVX-512 kernels the bounds of + - * / can be tighter than
+///   those of rounded_interval, so the two types need not agree bit for bit.
+template < class Real, int W = CMDB_INTERVAL_LANES >
+struct interval_lanes {
+  static const int width = W;
+  Real lower_ [ W ];
+  Real upper_ [ W ];
+  interval_lanes ( void ) {}
+  interval_lanes ( Real x ) {
+    for ( int i = 0; i < W; ++ i ) lower_ [ i ] = upper_ [ i ] = x;
+  }
+  interval_lanes ( const rounded_interval<Real> & x ) {
+    for ( int i = 0; i < W; ++ i ) { lower_ [ i ] = x . lower_; upper_ [ i ] = x . upper_; }
+  }
+  interval_lanes ( const Real * lower, const Real * upper ) { load ( lower, upper ); }
+
+  /// load
+  ///   Read lane i from lower [ i ] and upper [ i ]
+  void load ( const Real * lower, const Real * upper ) {
+    for ( int i = 0; i < W; ++ i ) { lower_ [ i ] = lower [ i ]; upper_ [ i ] = upper [ i ]; }
+  }
+
+  /// store
+  ///   Write lane i to lower [ i ] and upper [ i ]
+  void store ( Real * lower, Real * upper ) const {
+    for ( int i = 0; i < W; ++ i ) { lower [ i ] = lower_ [ i ]; upper [ i ] = upper_ [ i ]; }
+  }
+
+  /// operator []
+  ///   Return lane i
+  rounded_interval<Real> operator [] ( int i ) const {
+    return rounded_interval<Real> ( lower_ [ i ], upper_ [ i ] );
+  }
+
+  friend interval_lanes operator + ( const interval_lanes & lhs, const interval_lanes & rhs ) {
+    interval_lanes result;
+    interval_add ( lhs . lower_, lhs . upper_, rhs . lower_, rhs . upper_, result . lower_, result . upper_ );
+    return result;
+  }
+
+  friend interval_lanes operator - ( const interval_lanes & lhs, const interval_lanes & rhs ) {
+    interval_lanes result;
+    interval_sub ( lhs . lower_, lhs . upper_, rhs . lower_, rhs . upper_, result . lower_, result . upper_ );
+    return result;
+  }
+
+  friend interval_lanes operator - ( const interval_lanes & term ) {
+    interval_lanes result;
+    for ( int i = 0; i < W; ++ i ) {
+      result . lower_ [ i ] = - term . upper_ [ i ];
+      result . upper_ [ i ] = - term . lower_ [ i ];
+    }
+    return result;
+  }
+
+  friend interval_lanes operator * ( const interval_lanes & lhs, const interval_lanes & rhs ) {
+    interval_lanes result;
+    interval_mul ( lhs . lower_, lhs . upper_, rhs . lower_, rhs . upper_, result . lower_, result . upper_ );
+    return result;
+  }
+
+  friend interval_lanes operator / ( const interval_lanes & lhs, const interval_lanes & rhs ) {
+    interval_lanes result;
+    interval_div ( lhs . lower_, lhs . upper_, rhs . lower_, rhs . upper_, result . lower_, result . upper_ );
+    return result;
+  }
+
+  friend interval_lanes exp ( const interval_lanes & term ) {
+    interval_lanes result;
+    interval_exp ( term . lower_, term . upper_, result . lower_, result . upper_ );
+    return result;
+  }
+
+  friend interval_lanes log ( const interval_lanes & term ) {
+    interval_lanes result;
+    for ( int i = 0; i < W; ++ i )
+      interval_log ( term . lower_ [ i ], term . upper_ [ i ], result . lower_ [ i ], result . upper_ [ i ] );
+    return result;
+  }
+
+  friend interval_lanes pow ( const interval_lanes & base, const Real exponent ) {
+    interval_lanes result;
+    for ( int i = 0; i < W; ++ i )
+      interval_pow ( base . lower_ [ i ], base . upper_ [ i ], exponent,
+                     result . lower_ [ i ], result . upper_ [ i ] );
+    return result;
+  }
+
+  friend interval_lanes cos ( const interval_lanes & term ) {
+    interval_lanes result;
+    for ( int i = 0; i < W; ++ i )
+      interval_cos ( term . lower_ [ i ], term . upper_ [ i ], result . lower_ [ i ], result . upper_ [ i ] );
+    return result;
+  }
+
+  friend interval_lanes square ( const interval_lanes & term ) {
+    return term * term;
+  }
+};
+
+#endif
@@ -0,0 +1,181 @@
+// BoxScheduler.h
+#ifndef CMDB_BOXSCHEDULER_H
+#define CMDB_BOXSCHEDULER_H
+
+#include <stdint.h>
+#include <vector>
+#include <queue>
+#include <utility>
+#include <limits>
+#include "boost/foreach.hpp"
+
+/// class BoxScheduler
+///    Decides the order in which parameter boxes are sent out, and how they
+///    are grouped into jobs, from the observed cost (in seconds) of boxes
+///    computed so far.
+///
+///    The predicted cost of a box is the mean observed cost of its computed
+///    neighbors, or the mean observed cost over all boxes if none of its
+///    neighbors is computed yet. Boxes are handed out in order of decreasing
+///    predicted cost (longest processing time first), so that expensive
+///    regions of parameter space start early rather than hold up the end of
+///    the run. Boxes with equal predictions go out in the order given.
+class BoxScheduler {
+public:
+  /// initialize
+  ///   "boxes" are the boxes to schedule, "N" the size of parameter space
+  void initialize ( const std::vector<uint64_t> & boxes, uint64_t N );
+
+  /// empty
+  ///   Return true if every box has been handed out
+  bool empty ( void ) const { return num_sent_ == boxes_ . size (); }
+
+  /// batch
+  ///   Hand out the next job: the most expensive remaining box, followed by
+  ///   further boxes while the predicted total stays within "target" seconds,
+  ///   or while there are fewer than "min_size" boxes.
+  ///   A job is never extended past "deadline" seconds; the first box is
+  ///   always included.
+  std::vector<uint64_t> batch ( double target, double deadline, size_t min_size = 1 );
+
+  /// observe
+  ///   Record the cost of computing box v. "neighbors" are the adjacent
+  ///   boxes whose predictions should take it into account.
+  void observe ( uint64_t v, double seconds, const std::vector<uint64_t> & neighbors );
+
+  /// predicted
+  ///   Return the predicted cost of box v
+  double predicted ( uint64_t v ) const;
+
+  /// mean
+  ///   Return the mean observed cost (1 if nothing is observed yet)
+  double mean ( void ) const;
+
+  /// observedCost
+  ///   Return the total cost observed so far
+  double observedCost ( void ) const { return observed_cost_; }
+
+  /// remainingCost
+  ///   Return the predicted cost of all boxes not yet observed
+  double remainingCost ( void ) const;
+
+private:
+  // Remove boxes which have been sent, or whose entry is out of date,
+  // from the top of the queue
+  void clean ( void );
+  // Return the next box to send, or -1 if none is left, and its
+  // predicted cost. "take" marks it as sent.
+  int64_t next ( double * cost, bool take );
+
+  std::vector<uint64_t> boxes_;             // unknown boxes go out in this order
+  size_t cursor_;                           // position in boxes_
+  size_t num_sent_;
+  std::vector<char> sent_;
+  std::vector<char> observed_;
+  std::vector<float> neighbor_cost_;        // sum of neighbor costs
+  std::vector<uint16_t> neighbor_count_;
+  // Boxes with a neighbor-based prediction, most expensive first
+  typedef std::pair<double, int64_t> Entry; // ( cost, - position in boxes_ )
+  std::priority_queue<Entry> known_;
+  std::vector<size_t> position_;
+  double observed_cost_;
+  uint64_t num_observed_;
+};
+
+inline void
+BoxScheduler::initialize ( const std::vector<uint64_t> & boxes, uint64_t N ) {
+  boxes_ = boxes;
+  cursor_ = 0;
+  num_sent_ = 0;
+  sent_ . assign ( N, false );
+  observed_ . assign ( N, false );
+  neighbor_cost_ . assign ( N, 0.0f );
+  neighbor_count_ . assign ( N, 0 );
+  known_ = std::priority_queue<Entry> ();
+  position_ . assign ( N, 0 );
+  for ( size_t i = 0; i < boxes_ . size (); ++ i ) position_ [ boxes_ [ i ] ] = i;
+  observed_cost_ = 0.0;
+  num_observed_ = 0;
+}
+
+inline double
+BoxScheduler::mean ( void ) const {
+  if ( num_observed_ == 0 ) return 1.0;
+  return observed_cost_ / (double) num_observed_;
+}
+
+inline double
+BoxScheduler::predicted ( uint64_t v ) const {
+  if ( neighbor_count_ [ v ] == 0 ) return mean ();
+  return (double) neighbor_cost_ [ v ] / (double) neighbor_count_ [ v ];
+}
+
+inline void
+BoxScheduler::clean ( void ) {
+  while ( not known_ . empty () ) {
+    const Entry & top = known_ . top ();
+    uint64_t v = boxes_ [ - top . second ];
+    if ( not sent_ [ v ] && top . first == predicted ( v ) ) break;
+    known_ . pop ();
+  }
+}
+
+inline int64_t
+BoxScheduler::next ( double * cost, bool take ) {
+  while ( cursor_ < boxes_ . size () && sent_ [ boxes_ [ cursor_ ] ] ) ++ cursor_;
+  clean ();
+  int64_t v = -1;
+  // Boxes without a neighbor-based prediction are assumed to cost the mean
+  * cost = mean ();
+  if ( not known_ . empty () &&
+       ( cursor_ == boxes_ . size () || known_ . top () . first >= mean () ) ) {
+    v = boxes_ [ - known_ . top () . second ];
+    * cost = known_ . top () . first;
+    if ( take ) known_ . pop ();
+  } else if ( cursor_ < boxes_ . size () ) {
+    v = boxes_ [ cursor_ ];
+    if ( take ) ++ cursor_;
+  }
+  if ( take && v >= 0 ) {
+    sent_ [ v ] = true;
+    ++ num_sent_;
+  }
+  return v;
+}
+
+inline std::vector<uint64_t>
+BoxScheduler::batch ( double target, double deadline, size_t min_size ) {
+  std::vector<uint64_t> result;
+  double total = 0.0;
+  while ( not empty () ) {
+    double cost;
+    if ( next ( & cost, false ) < 0 ) break;
+    if ( not result . empty () && total + cost > deadline ) break;
+    if ( result . size () >= min_size && total + cost > target ) break;
+    result . push_back ( (uint64_t) next ( & cost, true ) );
+    total += cost;
+  }
+  return result;
+}
+
+inline void
+BoxScheduler::observe ( uint64_t v, double seconds, const std::vector<uint64_t> & neighbors ) {
+  if ( observed_ [ v ] ) return;
+  observed_ [ v ] = true;
+  observed_cost_ += seconds;
+  ++ num_observed_;
+  BOOST_FOREACH ( uint64_t u, neighbors ) {
+    if ( sent_ [ u ] ) continue;
+    if ( neighbor_count_ [ u ] == std::numeric_limits<uint16_t>::max () ) continue;
+    neighbor_cost_ [ u ] += (float) seconds;
+    ++ neighbor_count_ [ u ];
+    known_ . push ( Entry ( predicted ( u ), - (int64_t) position_ [ u ] ) );
+  }
+}
+
+inline double
+BoxScheduler::remainingCost ( void ) const {
+  return mean () * (double) ( boxes_ . size () - num_observed_ );
+}
+
+#endif
@@ -5,6 +5,7 @@
 #include <exception>
 #include <string>
 #include <sstream>
+#include <limits>
 #include <boost/serialization/serialization.hpp>
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/string.hpp>
@@ -13,6 +14,7 @@
 #include <unistd.h>
 #include <fstream>
 #include "database/structures/RectGeo.h"
+#include "database/structures/MapGraphSettings.h"
 
 class Configuration {
 public:
@@ -27,6 +29,11 @@ public:
   std::vector<uint64_t> PARAM_SUBDIV_SIZES;
   Rect PARAM_BOUNDS;
   std::vector<bool> PARAM_PERIODIC;
+  std::string PARAM_SCHEDULE; // "patch" (patches of boxes) or "box" (one job per box)
+  double PARAM_COST_TARGET; // box schedule: predicted seconds per job (0: one box per job)
+  double PARAM_COST_DEADLINE; // box schedule: jobs are never predicted to exceed this
+  double PARAM_TIME_LIMIT; // jobs running longer than this (in seconds) are abandoned
+  int PARAM_THREADS; // parameter boxes computed at once within a patch job (0: one per core)
 
   /* Phase Space */
   int PHASE_DIM;
@@ -34,9 +41,36 @@ public:
   int PHASE_SUBDIV_MIN;
   int PHASE_SUBDIV_MAX;
   int PHASE_SUBDIV_LIMIT;
+  int PHASE_THREADS; // threads evaluating the map (0: one per core)
+  int PHASE_NODE_THREADS; // Morse decomposition nodes computed at once (0: one per core)
+  int PHASE_CACHE_MEMORY; // adjacency cache budget in MB, <phase><cache><memory> (default 0: no cache)
+  std::string PHASE_CACHE_SPILL; // directory for cache overflow ("": none)
+  std::string PHASE_ORDER; // numbering of grid elements in graph passes ("tree" or "hilbert")
+  int PHASE_COVER_INDEX; // grids with at least this many elements get a cover index (-1: none)
   Rect PHASE_BOUNDS; 
   std::vector<bool> PHASE_PERIODIC;
+
+  /* Storage */
+  std::string GRIDS_STORE; // Morse graphs kept with their grids in database.grids ("none", "all",
+                           // or "reps": only those of the representatives the Conley process uses)
+
+  /* Continuation */
+  int CONTINUATION_THREADS; // threads postprocessing the database on rank 0 (0: one per core)
   
+  /// mapGraphSettings
+  ///   Return the settings for MapGraph described by the phase fields
+  MapGraphSettings mapGraphSettings ( void ) const {
+    MapGraphSettings settings;
+    settings . threads = PHASE_THREADS;
+    settings . node_threads = PHASE_NODE_THREADS;
+    settings . cache_memory = ((uint64_t) PHASE_CACHE_MEMORY) << 20;
+    settings . cache_spill = PHASE_CACHE_SPILL;
+    settings . order = PHASE_ORDER;
+    settings . cover_index = PHASE_COVER_INDEX < 0 ? std::numeric_limits<uint64_t>::max ()
+                                                   : (uint64_t) PHASE_COVER_INDEX;
+    return settings;
+  }
+
   // Loading
   void loadFromFile ( const char * filename ) {
     std::string filestring ( filename );
@@ -138,6 +172,33 @@ public:
       }
     }
     
+    boost::optional<std::string> param_schedule = pt.get_optional<std::string>("config.param.schedule");
+    PARAM_SCHEDULE = "patch";
+    if ( param_schedule ) {
+      std::stringstream param_schedule_ss ( *param_schedule );
+      param_schedule_ss >> PARAM_SCHEDULE;
+    }
+    if ( PARAM_SCHEDULE != "patch" && PARAM_SCHEDULE != "box" ) {
+      std::cout << "Configuration Error. config.param.schedule must be \"patch\" or \"box\"\n";
+      throw 1;
+    }
+    
+    boost::optional<double> param_cost_target = pt.get_optional<double>("config.param.cost.target");
+    PARAM_COST_TARGET = 0.0;
+    if ( param_cost_target ) PARAM_COST_TARGET = param_cost_target . get ();
+
+    boost::optional<double> param_cost_deadline = pt.get_optional<double>("config.param.cost.deadline");
+    PARAM_COST_DEADLINE = 3600.0;
+    if ( param_cost_deadline ) PARAM_COST_DEADLINE = param_cost_deadline . get ();
+
+    boost::optional<double> param_time_limit = pt.get_optional<double>("config.param.time.limit");
+    PARAM_TIME_LIMIT = 3600.0;
+    if ( param_time_limit ) PARAM_TIME_LIMIT = param_time_limit . get ();
+    
+    boost::optional<int> param_threads = pt.get_optional<int>("config.param.threads");
+    PARAM_THREADS = 1;
+    if ( param_threads ) PARAM_THREADS = param_threads . get ();
+    
     /* Phase Space */
     PHASE_DIM = pt.get<int>("config.phase.dim");
     PHASE_SUBDIV_MIN = pt.get<int>("config.phase.subdiv.min");
@@ -147,6 +208,36 @@ public:
     boost::optional<int> opt_phase_subdiv_init = pt.get_optional<int>("config.phase.subdiv.init");
     PHASE_SUBDIV_INIT = 0;
     if ( opt_phase_subdiv_init ) PHASE_SUBDIV_INIT = opt_phase_subdiv_init . get ();
+
+    boost::optional<int> opt_phase_threads = pt.get_optional<int>("config.phase.threads");
+    PHASE_THREADS = 1;
+    if ( opt_phase_threads ) PHASE_THREADS = opt_phase_threads . get ();
+
+    boost::optional<int> opt_phase_node_threads = pt.get_optional<int>("config.phase.nodes.threads");
+    PHASE_NODE_THREADS = 1;
+    if ( opt_phase_node_threads ) PHASE_NODE_THREADS = opt_phase_node_threads . get ();
+
+    boost::optional<int> opt_phase_cache_memory = pt.get_optional<int>("config.phase.cache.memory");
+    PHASE_CACHE_MEMORY = 0;
+    if ( opt_phase_cache_memory ) PHASE_CACHE_MEMORY = opt_phase_cache_memory . get ();
+
+    boost::optional<std::string> opt_phase_cache_spill = pt.get_optional<std::string>("config.phase.cache.spill");
+    PHASE_CACHE_SPILL = "";
+    if ( opt_phase_cache_spill ) {
+      std::stringstream phase_cache_spill_ss ( * opt_phase_cache_spill );
+      phase_cache_spill_ss >> PHASE_CACHE_SPILL;
+    }
+
+    boost::optional<std::string> opt_phase_order = pt.get_optional<std::string>("config.phase.order");
+    PHASE_ORDER = "tree";
+    if ( opt_phase_order ) {
+      std::stringstream phase_order_ss ( * opt_phase_order );
+      phase_order_ss >> PHASE_ORDER;
+    }
+
+    boost::optional<int> opt_phase_cover_index = pt.get_optional<int>("config.phase.cover.index");
+    PHASE_COVER_INDEX = 1024;
+    if ( opt_phase_cover_index ) PHASE_COVER_INDEX = opt_phase_cover_index . get ();
     
     PHASE_BOUNDS . lower_bounds . resize ( PHASE_DIM );
     PHASE_BOUNDS . upper_bounds . resize ( PHASE_DIM );
@@ -169,6 +260,23 @@ public:
         PHASE_PERIODIC [ d ] = (bool) x;
       }
     }
+
+    /* Storage */
+    boost::optional<std::string> opt_grids_store = pt.get_optional<std::string>("config.grids.store");
+    GRIDS_STORE = "none";
+    if ( opt_grids_store ) {
+      std::stringstream grids_store_ss ( * opt_grids_store );
+      grids_store_ss >> GRIDS_STORE;
+    }
+    if ( GRIDS_STORE != "none" && GRIDS_STORE != "reps" && GRIDS_STORE != "all" ) {
+      std::cout << "Configuration Error. config.grids.store must be \"none\", \"reps\" or \"all\"\n";
+      throw 1;
+    }
+
+    /* Continuation */
+    boost::optional<int> opt_continuation_threads = pt.get_optional<int>("config.continuation.threads");
+    CONTINUATION_THREADS = 1;
+    if ( opt_continuation_threads ) CONTINUATION_THREADS = opt_continuation_threads . get ();
     
     
   }
@@ -187,6 +295,11 @@ public:
     ar & PARAM_SUBDIV_SIZES;
     ar & PARAM_PERIODIC;
     ar & PARAM_BOUNDS;
+    ar & PARAM_SCHEDULE;
+    ar & PARAM_COST_TARGET;
+    ar & PARAM_COST_DEADLINE;
+    ar & PARAM_TIME_LIMIT;
+    ar & PARAM_THREADS;
     
     /* Phase Space */
     ar & PHASE_DIM;
@@ -194,8 +307,20 @@ public:
     ar & PHASE_SUBDIV_MIN;
     ar & PHASE_SUBDIV_MAX;
     ar & PHASE_SUBDIV_LIMIT;
+    ar & PHASE_THREADS;
+    ar & PHASE_NODE_THREADS;
+    ar & PHASE_CACHE_MEMORY;
+    ar & PHASE_CACHE_SPILL;
+    ar & PHASE_ORDER;
+    ar & PHASE_COVER_INDEX;
     ar & PHASE_BOUNDS; 
     ar & PHASE_PERIODIC;
+
+    /* Storage */
+    ar & GRIDS_STORE;
+
+    /* Continuation */
+    ar & CONTINUATION_THREADS;
   }
   
 };
@@ -4,6 +4,7 @@
 #include "cluster-delegator.h"
 #include "database/structures/Database.h"
 #include "database/program/Configuration.h"
+#include "database/program/MorseGridLog.h"
 #include "boost/date_time/posix_time/posix_time.hpp"
 #include <boost/chrono/chrono_io.hpp>
 
@@ -32,6 +33,9 @@ private:
   Database database;
   Model model;
   std::shared_ptr<ParameterSpace> parameter_space_;
+  // Morse graphs stored by the Morse process (see MorseGridLog)
+  std::string grids_filename_;
+  MorseGridLog::Index grid_offsets_;
   size_t num_jobs_sent_;
   size_t num_incc_;
   int64_t current_incc_;
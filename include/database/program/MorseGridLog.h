@@ -0,0 +1,134 @@
+// MorseGridLog.h
+#ifndef CMDB_MORSEGRIDLOG_H
+#define CMDB_MORSEGRIDLOG_H
+
+#include <stdint.h>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include "boost/unordered_map.hpp"
+#include "boost/unordered_set.hpp"
+#include "boost/archive/binary_iarchive.hpp"
+#include "boost/foreach.hpp"
+#include "database/structures/MorseGraphCode.h"
+#include "database/program/RecordLog.h"
+
+/// class MorseGridLog
+///    Append-only side file of Morse graphs with their grids, kept next to
+///    the database (which holds only the sizes of the Morse sets) so that
+///    clutching and Conley index computations can be done later without
+///    recomputing the Morse graphs. Each record is a parameter index, a byte
+///    count and a MorseGraphCode binary archive (a keyed RecordLog), and is
+///    flushed as soon as it is appended. As with ResultLog, an incomplete
+///    final record (a crash during append) is discarded when the file is
+///    indexed.
+class MorseGridLog {
+public:
+  typedef boost::unordered_map<uint64_t, uint64_t> Index;
+
+  /// MorseGridLog
+  MorseGridLog ( void ) : log_ ( true ) {}
+
+  /// open
+  ///   Open "filename" for appending (creating it if need be)
+  void open ( const std::string & filename ) { log_ . open ( filename ); }
+
+  /// is_open
+  bool is_open ( void ) const { return log_ . is_open (); }
+
+  /// append
+  ///   Append the code of the Morse graph at "parameter_index" (as written by
+  ///   the jobs) and flush it to disk
+  void append ( uint64_t parameter_index, const std::string & code_bytes ) {
+    log_ . append ( parameter_index, code_bytes );
+  }
+
+  /// index
+  ///   Record in "offsets" the position in "filename" of the record of each
+  ///   parameter index (the last one, if there are several), and cut off any
+  ///   incomplete trailing record. Returns the number of records (0 if the
+  ///   file does not exist).
+  static uint64_t index ( const std::string & filename, Index * offsets );
+
+  /// read
+  ///   Read the code bytes of the record at "offset" of "input" into
+  ///   "code_bytes" and return its parameter index
+  static uint64_t read ( std::istream & input, uint64_t offset, std::string * code_bytes );
+
+  /// load
+  ///   Read the record at "offset" of "input" into "code" and return its
+  ///   parameter index
+  static uint64_t load ( std::istream & input, uint64_t offset, MorseGraphCode * code );
+
+  /// filter
+  ///   Rewrite "filename" keeping only the records of the parameter indices
+  ///   in "keep". Returns the number of records kept.
+  static uint64_t filter ( const std::string & filename,
+                           const boost::unordered_set<uint64_t> & keep );
+
+private:
+  RecordLog log_;
+};
+
+inline uint64_t
+MorseGridLog::index ( const std::string & filename, Index * offsets ) {
+  return RecordLog::scan ( filename, true, 
+    [&] ( uint64_t parameter_index, uint64_t offset, uint64_t, std::istream & ) {
+      (*offsets) [ parameter_index ] = offset;
+      return true;
+    });
+}
+
+inline uint64_t
+MorseGridLog::read ( std::istream & input, uint64_t offset, std::string * code_bytes ) {
+  return RecordLog::read ( input, offset, true, code_bytes );
+}
+
+inline uint64_t
+MorseGridLog::load ( std::istream & input, uint64_t offset, MorseGraphCode * code ) {
+  std::string bytes;
+  uint64_t parameter_index = read ( input, offset, & bytes );
+  std::istringstream buffer ( bytes );
+  boost::archive::binary_iarchive ia ( buffer );
+  ia >> * code;
+  return parameter_index;
+}
+
+inline uint64_t
+MorseGridLog::filter ( const std::string & filename,
+                       const boost::unordered_set<uint64_t> & keep ) {
+  if ( not std::ifstream ( filename . c_str () ) . good () ) return 0;
+  Index offsets;
+  index ( filename, & offsets );
+  std::string temp_filename = filename + ".tmp";
+  uint64_t records = 0;
+  {
+    std::ifstream input ( filename . c_str (), std::ios::in | std::ios::binary );
+    MorseGridLog output;
+    output . open ( temp_filename );
+    // Keep file order, so that the rewrite reads the input front to back
+    std::vector<uint64_t> kept;
+    BOOST_FOREACH ( const Index::value_type & entry, offsets ) {
+      if ( keep . count ( entry . first ) ) kept . push_back ( entry . second );
+    }
+    std::sort ( kept . begin (), kept . end () );
+    std::string bytes;
+    BOOST_FOREACH ( uint64_t offset, kept ) {
+      uint64_t parameter_index = read ( input, offset, & bytes );
+      output . append ( parameter_index, bytes );
+      ++ records;
+    }
+  }
+  if ( std::rename ( temp_filename . c_str (), filename . c_str () ) != 0 ) {
+    throw std::runtime_error ( "MorseGridLog. Unable to replace " + filename + "\n" );
+  }
+  return records;
+}
+
+#endif
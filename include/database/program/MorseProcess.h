@@ -2,9 +2,19 @@
 #define CMDB_MORSEPROCESS_H
 
 #include <ctime>
+#include <vector>
+#include <deque>
+#include <string>
+#include <utility>
+#include "boost/unordered_set.hpp"
+#include "boost/unordered_map.hpp"
 #include "cluster-delegator.hpp"
 #include "database/structures/Database.h"
 #include "database/program/Configuration.h"
+#include "database/program/ResultLog.h"
+#include "database/program/MorseGridLog.h"
+#include "database/program/BoxScheduler.h"
+#include "boost/chrono/chrono.hpp"
 #include "database/structures/PointerGrid.h"
 #include "chomp/CubicalComplex.h"
 
@@ -25,8 +35,45 @@ public:
   void progressReport ( void );
 
 private:
+  void initializePatchSchedule ( size_t * num_calc );
+  void initializeBoxSchedule ( size_t * num_calc, size_t * num_skipped );
+  void advancePatch ( void );
+  bool jobReady ( void ) const;
+  void preparePatchJob ( Message & job, size_t job_number );
+  void prepareBoxJob ( Message & job, size_t job_number );
+  void acceptMorseGraph ( uint64_t v, const std::string & morse_graph_bytes );
+  void releaseEdge ( uint64_t u, uint64_t v );
+  void storeGrids ( uint64_t v, const std::string & code_bytes );
+
   size_t num_jobs_;
   size_t num_jobs_sent_;
+  // Results of a previous run
+  boost::unordered_set<uint64_t> computed_parameters_;
+  boost::unordered_set<std::pair<uint64_t,uint64_t> > computed_clutchings_;
+  // Patch schedule: the next patch to send (null once the sequence ends)
+  std::shared_ptr<ParameterPatch> next_patch_;
+  size_t num_patches_skipped_;                  // completed by a previous run
+  ResultLog result_log_;
+  // Morse graphs with their grids ("config.grids.store" is not "none")
+  MorseGridLog grid_log_;
+  boost::unordered_set<uint64_t> stored_grids_;
+  uint64_t num_box_calculations_;               // for the duplicate-work ratio
+  std::vector<bool> box_calculated_;
+
+  // Box schedule ("config.param.schedule" is "box"): one Morse graph job per
+  // parameter box, then one clutching job per edge once both ends are known.
+  enum { BOX_DONE, BOX_TODO, BOX_ARRIVED };
+  bool box_schedule_;
+  BoxScheduler scheduler_;
+  boost::unordered_map<size_t, std::vector<uint64_t> > boxes_of_job_;
+  std::vector<char> box_state_;
+  std::vector<std::vector<uint64_t> > pending_neighbors_;
+  std::vector<uint32_t> pending_count_;         // edges not yet sent, per box
+  boost::unordered_map<uint64_t, std::string> morse_graph_bytes_;
+  std::deque<std::pair<uint64_t, uint64_t> > clutch_queue_;
+  uint64_t num_grid_cells_;                     // phase space cells of boxes received
+  int worker_threads_;                          // boxes a worker computes at once, as last reported
+  boost::chrono::steady_clock::time_point start_time_;
   Configuration config;
   Model model;
   Database database;
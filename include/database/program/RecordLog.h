@@ -0,0 +1,124 @@
+// RecordLog.h
+#ifndef CMDB_RECORDLOG_H
+#define CMDB_RECORDLOG_H
+
+#include <stdint.h>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <unistd.h>
+
+/// class RecordLog
+///    Append-only file of byte strings, the common part of ResultLog and
+///    MorseGridLog. Each record is a header of 64-bit words (a key, if the
+///    log is "keyed", then a byte count) followed by the bytes, and is
+///    flushed as soon as it is appended, so that a run which crashes loses
+///    at most the record being written. "scan" reads back the complete
+///    records and cuts off an incomplete final one, so that later appends
+///    line up.
+class RecordLog {
+public:
+  /// RecordLog
+  ///   "keyed" says whether records carry a key
+  explicit RecordLog ( bool keyed ) : keyed_ ( keyed ) {}
+
+  /// open
+  ///   Open "filename" for appending (creating it if need be)
+  void open ( const std::string & filename );
+
+  /// is_open
+  bool is_open ( void ) const { return stream_ . is_open (); }
+
+  /// append
+  ///   Append a record and flush it to disk ("key" is ignored if the log
+  ///   is not keyed)
+  void append ( uint64_t key, const std::string & bytes );
+
+  /// scan
+  ///   Call visit ( key, offset, size, input ) on each complete record of
+  ///   "filename" in file order, with "input" positioned at the first of the
+  ///   "size" bytes of the record, which starts at "offset" (key is 0 if the
+  ///   log is not keyed). Reading stops at the first record for which visit
+  ///   returns false. The file is then cut off after the last record accepted.
+  ///   Returns the number of records accepted (0 if the file does not exist).
+  template < class Visitor >
+  static uint64_t scan ( const std::string & filename, bool keyed, const Visitor & visit );
+
+  /// read
+  ///   Read the bytes of the record at "offset" of "input" into "bytes" and
+  ///   return its key
+  static uint64_t read ( std::istream & input, uint64_t offset, bool keyed, std::string * bytes );
+
+private:
+  std::ofstream stream_;
+  bool keyed_;
+};
+
+inline void
+RecordLog::open ( const std::string & filename ) {
+  stream_ . open ( filename . c_str (), std::ios::out | std::ios::app | std::ios::binary );
+  if ( not stream_ . good () ) {
+    throw std::runtime_error ( "RecordLog. Unable to open " + filename + "\n" );
+  }
+}
+
+inline void
+RecordLog::append ( uint64_t key, const std::string & bytes ) {
+  uint64_t size = bytes . size ();
+  if ( keyed_ ) stream_ . write ( (const char *) & key, sizeof ( uint64_t ) );
+  stream_ . write ( (const char *) & size, sizeof ( uint64_t ) );
+  stream_ . write ( bytes . data (), size );
+  stream_ . flush ();
+  if ( not stream_ . good () ) {
+    throw std::runtime_error ( "RecordLog. Failed to append record.\n" );
+  }
+}
+
+template < class Visitor > uint64_t
+RecordLog::scan ( const std::string & filename, bool keyed, const Visitor & visit ) {
+  std::ifstream input ( filename . c_str (), std::ios::in | std::ios::binary );
+  if ( not input . good () ) return 0;
+  input . seekg ( 0, std::ios::end );
+  uint64_t length = input . tellg ();
+  input . seekg ( 0, std::ios::beg );
+  int header_words = keyed ? 2 : 1;
+  uint64_t records = 0;
+  uint64_t good_length = 0;
+  while ( 1 ) {
+    uint64_t header [ 2 ] = { 0, 0 };
+    if ( not input . read ( (char *) ( header + 2 - header_words ),
+                            header_words * sizeof ( uint64_t ) ) ) break;
+    uint64_t end = good_length + header_words * sizeof ( uint64_t ) + header [ 1 ];
+    if ( end > length ) break;
+    if ( not visit ( header [ 0 ], good_length, header [ 1 ], input ) ) break;
+    ++ records;
+    good_length = end;
+    input . clear ();
+    input . seekg ( good_length, std::ios::beg );
+  }
+  input . close ();
+  // Drop a partially written last record so that later appends line up
+  if ( good_length < length && truncate ( filename . c_str (), good_length ) != 0 ) {
+    std::cout << "RecordLog::scan. Warning: could not truncate " << filename << "\n";
+  }
+  return records;
+}
+
+inline uint64_t
+RecordLog::read ( std::istream & input, uint64_t offset, bool keyed, std::string * bytes ) {
+  int header_words = keyed ? 2 : 1;
+  uint64_t header [ 2 ] = { 0, 0 };
+  input . seekg ( offset, std::ios::beg );
+  if ( input . read ( (char *) ( header + 2 - header_words ), header_words * sizeof ( uint64_t ) ) ) {
+    bytes -> resize ( header [ 1 ] );
+    if ( header [ 1 ] > 0 ) input . read ( & (*bytes) [ 0 ], header [ 1 ] );
+  }
+  if ( not input . good () ) {
+    throw std::runtime_error ( "RecordLog. Failed to read record.\n" );
+  }
+  return header [ 0 ];
+}
+
+#endif
@@ -0,0 +1,74 @@
+// ResultLog.h
+#ifndef CMDB_RESULTLOG_H
+#define CMDB_RESULTLOG_H
+
+#include <stdint.h>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include "boost/archive/binary_oarchive.hpp"
+#include "boost/archive/binary_iarchive.hpp"
+#include "database/structures/Database.h"
+#include "database/program/RecordLog.h"
+
+/// class ResultLog
+///    Append-only file of job results. Each record is the Database returned
+///    by one job, stored as a byte count followed by a binary archive, and is
+///    flushed as soon as it is appended (see RecordLog). Checkpointing
+///    therefore costs only the size of the new result, and "replay" rebuilds
+///    the merged database after a crash. An incomplete final record (a crash
+///    during append) is discarded on replay.
+class ResultLog {
+public:
+  /// ResultLog
+  ResultLog ( void ) : log_ ( false ) {}
+
+  /// open
+  ///   Open "filename" for appending (creating it if need be)
+  void open ( const std::string & filename ) { log_ . open ( filename ); }
+
+  /// append
+  ///   Append a job result and flush it to disk
+  void append ( const Database & job_database );
+
+  /// replay
+  ///   Merge every complete record of "filename" into "database", and cut off
+  ///   any incomplete trailing record. Returns the number of records merged
+  ///   (0 if the file does not exist).
+  static uint64_t replay ( const std::string & filename, Database * database );
+
+private:
+  RecordLog log_;
+};
+
+inline void
+ResultLog::append ( const Database & job_database ) {
+  std::ostringstream buffer;
+  {
+    boost::archive::binary_oarchive oa ( buffer );
+    oa << job_database;
+  }
+  log_ . append ( 0, buffer . str () );
+}
+
+inline uint64_t
+ResultLog::replay ( const std::string & filename, Database * database ) {
+  std::string bytes;
+  return RecordLog::scan ( filename, false, 
+    [&] ( uint64_t, uint64_t, uint64_t size, std::istream & input ) {
+      bytes . resize ( size );
+      if ( size > 0 && not input . read ( & bytes [ 0 ], size ) ) return false;
+      Database job_database;
+      try {
+        std::istringstream buffer ( bytes );
+        boost::archive::binary_iarchive ia ( buffer );
+        ia >> job_database;
+      } catch ( ... ) {
+        return false;
+      }
+      database -> merge ( job_database );
+      return true;
+    });
+}
+
+#endif
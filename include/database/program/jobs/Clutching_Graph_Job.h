@@ -23,15 +23,20 @@ void Clutching_Graph_Job ( Message * result,
 #include <vector>
 #include <ctime>
 #include <set>
+#include <sstream>
 
 #include "boost/iterator_adaptors.hpp"
+#include "boost/unordered_map.hpp"
 #include "boost/iterator/counting_iterator.hpp"
 #include "boost/serialization/vector.hpp"
 #include "boost/serialization/map.hpp"
 #include "boost/serialization/set.hpp"
+#include "boost/archive/binary_oarchive.hpp"
 
 #include "database/program/Configuration.h"
+#include "database/algorithms/parallelFor.h"
 #include "database/structures/MorseGraph.h"
+#include "database/structures/MorseGraphCode.h"
 #include "database/program/jobs/Compute_Morse_Graph.h"
 #include "database/structures/Database.h"
 #include "database/algorithms/clutching.h"
@@ -41,6 +46,12 @@ void Clutching_Graph_Job ( Message * result,
  *
  *  This function is called from worker, and compare graph structure
  *  for each two adjacent boxes.
+ *  With PARAM_THREADS other than 1 the model is used from several threads
+ *  at once (see Model.h).
+ *  The result holds a database with the parameter and clutching records,
+ *  followed by the parameter indices and the Morse graphs (as MorseGraphCode
+ *  archives) of the boxes computed, if the job asks for grids to be stored,
+ *  and two empty vectors otherwise.
  */
 inline void 
 Clutching_Graph_Job ( Message * result, 
@@ -53,6 +64,9 @@ Clutching_Graph_Job ( Message * result,
   int PHASE_SUBDIV_MIN;
   int PHASE_SUBDIV_MAX;
   int PHASE_SUBDIV_LIMIT;
+  MapGraphSettings map_graph_settings;
+  int PARAM_THREADS;
+  bool STORE_GRIDS;
   
   std::cout << "Clutching_Graph_Job. About to read patch and phase space info.\n";
   job >> patch;
@@ -61,93 +75,141 @@ Clutching_Graph_Job ( Message * result,
   job >> PHASE_SUBDIV_MIN;
   job >> PHASE_SUBDIV_MAX;
   job >> PHASE_SUBDIV_LIMIT;
+  job >> map_graph_settings;
+  job >> PARAM_THREADS;
+  job >> STORE_GRIDS;
   std::cout << "Clutching_Graph_Job. About to do computation.\n";
+  int threads = resolveThreadCount ( PARAM_THREADS );
 
   // Prepare data structures
+  // Results are computed concurrently into slots indexed by position in
+  // the patch, then inserted into the database in patch order, so that
+  // the database is the same for any number of threads.
   Database database;
-  boost::unordered_map < uint64_t, MorseGraph> morse_graphs;
+  size_t num_parameters = patch -> vertices . size ();
+  std::vector < MorseGraph > morse_graphs ( num_parameters );
+  std::vector < char > computed ( num_parameters, false );
+  std::vector < std::string > codes ( num_parameters );
+  boost::unordered_map < uint64_t, size_t > position;
+  for ( size_t i = 0; i < num_parameters; ++ i ) {
+    position [ patch -> vertices [ i ] ] = i;
+  }
+  // If the boxes are computed side by side (see parallelFor), each one gets
+  // a single thread, so that the cores are not oversubscribed
+  if ( threads > 1 && num_parameters >= (size_t) threads ) {
+    map_graph_settings . threads = 1;
+    map_graph_settings . node_threads = 1;
+  }
 
   // Compute Morse Graphs
-  size_t num_parameters = patch -> vertices . size ();
-  std::cout << "Clutching_Graph_Job. Starting analysis of " << num_parameters << " parameter boxes.\n";
+  std::cout << "Clutching_Graph_Job. Starting analysis of " << num_parameters 
+            << " parameter boxes on " << threads << " threads.\n";
   std::cout << "--------- 1. Compute Morse Graphs --------- " << "\n";
 
-  size_t count = 0;
-  BOOST_FOREACH ( uint64_t vertex, patch -> vertices ) {
-    // Obtain parameter associated with vertex
-    std::shared_ptr<Parameter> parameter = patch -> parameter [ vertex ];
-    
-    // Debug output
-    std::cout << "Clutching_Graph_Job. Processing parameter " << *parameter 
-              << ", which is " << ++count << "/" << num_parameters << ".\n "; 
-
-    // Prepare dynamical map
-    std::shared_ptr<const Map> map = model . map ( parameter );
-    if ( not map ) {
-      std::cout << "Clutching_Graph_Job. No map associated with parameter " <<
-        *parameter << "; continuing.\n";
-      continue;
+  parallelFor ( 0, num_parameters, 1, threads,
+                [&] ( uint64_t begin, uint64_t end, int ) {
+    for ( uint64_t i = begin; i < end; ++ i ) {
+      uint64_t vertex = patch -> vertices [ i ];
+      // Obtain parameter associated with vertex
+      std::shared_ptr<Parameter> parameter = patch -> parameter . find ( vertex ) -> second;
+      
+      // Debug output
+      std::stringstream ss;
+      ss << "Clutching_Graph_Job. Processing parameter " << *parameter 
+         << ", which is " << i + 1 << "/" << num_parameters << ".\n "; 
+      std::cout << ss . str ();
+
+      // Prepare dynamical map
+      std::shared_ptr<const Map> map = model . map ( parameter );
+      if ( not map ) {
+        std::cout << "Clutching_Graph_Job. No map associated with parameter " <<
+          *parameter << "; continuing.\n";
+        continue;
+      }
+      // Prepare phase space
+      std::shared_ptr<Grid> phase_space = model . phaseSpace ();    
+      if ( not phase_space ) {
+        throw std::logic_error ( "Clutching_Graph_Job. model.phaseSpace() failed" 
+                                 " to return a valid pointer.\n");
+      }
+
+      // Perform Morse Graph computation
+      Compute_Morse_Graph 
+      ( & morse_graphs [ i ],
+        phase_space, 
+        map, 
+        PHASE_SUBDIV_INIT,
+        PHASE_SUBDIV_MIN, 
+        PHASE_SUBDIV_MAX, 
+        PHASE_SUBDIV_LIMIT,
+        map_graph_settings );
+
+      // Check for warnings
+      if ( morse_graphs [ i ] . NumVertices () == 0 )  { 
+        std::cerr << "Clutching_Graph_Job. WARNING. Vertex # " << vertex << ", parameter = " 
+        << *parameter << " yielded no morse sets.\n"; 
+      }
+
+      // Annotate the morse graph
+      model . annotate ( & morse_graphs [ i ] );
+      computed [ i ] = true;
+
+      if ( STORE_GRIDS ) {
+        std::ostringstream buffer;
+        {
+          MorseGraphCode code ( morse_graphs [ i ] );
+          boost::archive::binary_oarchive oa ( buffer );
+          oa << code;
+        }
+        codes [ i ] = buffer . str ();
+      }
     }
-    // Prepare phase space
-    std::shared_ptr<Grid> phase_space = model . phaseSpace ();    
-    if ( not phase_space ) {
-      throw std::logic_error ( "Clutching_Graph_Job. model.phaseSpace() failed" 
-                               " to return a valid pointer.\n");
+  });
+
+  // Insert Morse graphs into database
+  std::vector < uint64_t > coded_vertices;
+  std::vector < std::string > coded_graphs;
+  for ( size_t i = 0; i < num_parameters; ++ i ) {
+    if ( not computed [ i ] ) continue;
+    database . insert ( patch -> vertices [ i ], morse_graphs [ i ] );
+    if ( STORE_GRIDS ) {
+      coded_vertices . push_back ( patch -> vertices [ i ] );
+      coded_graphs . push_back ( std::string () );
+      coded_graphs . back () . swap ( codes [ i ] );
     }
-
-    // Perform Morse Graph computation
-    Compute_Morse_Graph 
-    ( & morse_graphs [ vertex ],
-      phase_space, 
-      map, 
-      PHASE_SUBDIV_INIT,
-      PHASE_SUBDIV_MIN, 
-      PHASE_SUBDIV_MAX, 
-      PHASE_SUBDIV_LIMIT );
-
-    std::cout << "Clutching_Graph_Job. Successfully computed " 
-      << "Morse Graph for parameter " << *parameter << ".\n";
-
-    // Check for warnings
-    if ( morse_graphs [ vertex ] . NumVertices () == 0 )  { 
-      std::cerr << "Clutching_Graph_Job. WARNING. Vertex # " << vertex << ", parameter = " 
-      << *parameter << " yielded no morse sets.\n"; 
-    }
-
-    // Annotate the morse graph
-    std::cout << "Clutching_Graph_Job. Annotating " 
-      << "Morse Graph for parameter " << *parameter << ".\n";
-    model . annotate ( & morse_graphs [ vertex ] );
-
-    // Insert Morse graph into database
-    std::cout << "Clutching_Graph_Job. Inserting " 
-      << "Morse Graph for parameter " << *parameter << " into local database.\n";
-    database . insert ( vertex, morse_graphs [ vertex ] );
   }
   
   // Compute Clutching Graphs
   std::cout << "--------- 2. Compute Clutching Graphs --------- " << "\n";
-  typedef std::pair < uint64_t, uint64_t > Adjacency;
-  BOOST_FOREACH ( const Adjacency & A, patch -> edges ) {
-    uint64_t u = A . first;
-    uint64_t v = A . second;
-    // If adjacency between uncomputed Morse sets, continue.
-    if ( morse_graphs . count ( u ) == 0  ||
-         morse_graphs . count ( v ) == 0 ) {
-      continue;
+  size_t num_edges = patch -> edges . size ();
+  std::vector < BG_Data > clutching_graphs ( num_edges );
+  std::vector < char > clutched ( num_edges, false );
+  parallelFor ( 0, num_edges, 16, threads,
+                [&] ( uint64_t begin, uint64_t end, int ) {
+    for ( uint64_t e = begin; e < end; ++ e ) {
+      size_t u = position . at ( patch -> edges [ e ] . first );
+      size_t v = position . at ( patch -> edges [ e ] . second );
+      // If adjacency between uncomputed Morse sets, continue.
+      if ( not computed [ u ] || not computed [ v ] ) continue;
+      Clutching ( & clutching_graphs [ e ],
+                  morse_graphs [ u ],
+                  morse_graphs [ v ]);
+      clutched [ e ] = true;
     }
-    // Compute clutching graph
-    BG_Data clutching_graph;
-    Clutching ( & clutching_graph,
-                morse_graphs [ u ],
-                morse_graphs [ v ]);
-
-    // Insert clutching graph into database
-    database . insert ( u, v, clutching_graph );
+  });
+
+  // Insert clutching graphs into database
+  for ( size_t e = 0; e < num_edges; ++ e ) {
+    if ( not clutched [ e ] ) continue;
+    database . insert ( patch -> edges [ e ] . first, 
+                        patch -> edges [ e ] . second, 
+                        clutching_graphs [ e ] );
   }
   
   // Return Result
   std::cout << "CLUTCHING JOB with " << num_parameters << " parameters COMPLETE.\n";
   *result << database;
+  *result << coded_vertices;
+  *result << coded_graphs;
 }
 #endif
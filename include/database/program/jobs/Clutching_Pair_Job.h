@@ -0,0 +1,64 @@
+/*
+ *  Clutching_Pair_Job.h
+ */
+
+#ifndef _CMDP_CLUTCHING_PAIR_JOB_
+#define _CMDP_CLUTCHING_PAIR_JOB_
+
+#include "cluster-delegator.hpp"
+
+void Clutching_Pair_Job ( Message * result,
+                          const Message & job );
+
+/////////////////
+// Definitions //
+/////////////////
+
+#include <string>
+#include <sstream>
+
+#include "boost/archive/binary_iarchive.hpp"
+
+#include "database/structures/MorseGraphCode.h"
+#include "database/structures/Database.h"
+#include "database/algorithms/clutching.h"
+
+/** Main function for a clutching job between two adjacent parameter boxes.
+ *
+ *  The job carries the two Morse graphs, as MorseGraphCode archives produced
+ *  by Morse_Graph_Job, so no map evaluation takes place here, and the codes
+ *  are clutched as they are, without rebuilding grids.
+ */
+inline void
+Clutching_Pair_Job ( Message * result,
+                     const Message & job ) {
+  uint64_t u, v;
+  std::string u_bytes, v_bytes;
+  job >> u;
+  job >> v;
+  job >> u_bytes;
+  job >> v_bytes;
+
+  MorseGraphCode u_code, v_code;
+  {
+    std::istringstream buffer ( u_bytes );
+    boost::archive::binary_iarchive ia ( buffer );
+    ia >> u_code;
+  }
+  {
+    std::istringstream buffer ( v_bytes );
+    boost::archive::binary_iarchive ia ( buffer );
+    ia >> v_code;
+  }
+
+  // Compute clutching graph
+  Database database;
+  BG_Data clutching_graph;
+  Clutching ( & clutching_graph, u_code, v_code );
+  database . insert ( u, v, clutching_graph );
+
+  std::cout << "CLUTCHING PAIR JOB for parameters " << u << " and " << v << " COMPLETE.\n";
+  *result << database;
+}
+
+#endif
@@ -10,10 +10,13 @@
 #include "database/structures/MorseGraph.h"
 #include "database/structures/Grid.h"
 #include "database/maps/Map.h"
+#include "database/structures/MapGraph.h"
  
 /// Computes the Morse decomposition with respect to the given map
 /// on the given phase space, and creates its representation by means
 /// of a Conley-Morse graph.
+/// "settings" controls how the map is evaluated on grid elements
+/// (threads, adjacency cache budget; see MapGraphSettings).
 
 void Compute_Morse_Graph (MorseGraph * MG,
                           std::shared_ptr<Grid> phase_space,
@@ -21,7 +24,8 @@ void Compute_Morse_Graph (MorseGraph * MG,
                           const unsigned int Init,
                           const unsigned int Min,
                           const unsigned int Max,
-                          const unsigned int Limit);  
+                          const unsigned int Limit,
+                          const MapGraphSettings & settings = MapGraphSettings ());  
 
 void Compute_Morse_Graph (MorseGraph * MG,
                           std::shared_ptr<Grid> phase_space,
@@ -18,6 +18,7 @@ using namespace cimg_library;
 
 #include "database/algorithms/GraphTheory.h"
 #include "database/algorithms/join.h"
+#include "database/algorithms/parallelFor.h"
 #include "database/structures/MapGraph.h"
 
 #include <ctime>
@@ -127,14 +128,19 @@ public:
   /// Fill these into "decomposition_"
   /// Fill children_ with an equal sized vector of pointers to new MorseDecomposition objects seeded with those sets.
   /// Put reachability information obtained in "reachability_"
+  /// "settings" controls map evaluation; timings and cache counters are added to "statistics"
   void 
-  decompose ( std::shared_ptr<const Map> f ) {
+  decompose ( std::shared_ptr<const Map> f,
+              const MapGraphSettings & settings = MapGraphSettings (),
+              MorseSetStatistics * statistics = NULL ) {
     //std::cout << "decompose at depth " << depth () << "\n";
     computeMorseSetsAndReachability
       ( &decomposition_, 
         &reachability_, 
         grid_, 
-        f );    
+        f,
+        settings,
+        statistics );    
     //std::cout << "  found " << decomposition_ . size () << " components\n";
   }
 
@@ -176,56 +182,114 @@ public:
 //  Algorithmically, this means we call decompose whenever the depth <= the number of
 //  subdivisions we want.
 // ConstructMorseDecomposition
+//  Nodes wait in a priority queue, largest first. settings.node_threads
+//  workers each take the largest waiting node, decompose it without holding
+//  the lock, and queue its children. A node's children are only touched by
+//  the worker that spawned them, and the tree does not depend on the order
+//  in which nodes are processed, so ConstructMorseGraph gives the same
+//  result for any number of workers. (The MEMORYBOOKKEEPING counters are
+//  not synchronized, and are only exact with one worker.)
 inline void
 ConstructMorseDecomposition (MorseDecomposition * root,
                              std::shared_ptr<const Map> f,
                              const unsigned int Min,
                              const unsigned int Max,
-                             const unsigned int Limit ) {
+                             const unsigned int Limit,
+                             const MapGraphSettings & settings = MapGraphSettings () ) {
+  int threads = resolveThreadCount ( settings . node_threads );
+  // Each worker has a MapGraph (and adjacency cache) of its own at a time;
+  // they share the memory budget
+  MapGraphSettings node_settings = settings;
+  node_settings . cache_memory /= threads;
   size_t nodes_processed = 0;
+  std::vector<MorseSetStatistics> thread_statistics ( threads );
   // We use a priority queue in order to do the more difficult computations first.
   std::priority_queue < MorseDecomposition *, 
                         std::vector<MorseDecomposition *>, 
                         MorseDecompCompare > pq;
+  boost::mutex pq_mutex;
+  boost::condition_variable pq_changed;
+  int busy = 0; // workers holding a node
+  bool failed = false;
   pq . push ( root );
-  while ( not pq . empty () ) {
-    ++ nodes_processed;
-    if ( nodes_processed % 1000 == 0 ) { 
-      std::cout << nodes_processed 
-        << " nodes have been encountered on Morse Decomposition Hierarchy.\n";
-    }
-    MorseDecomposition * work_node = pq . top ();
-    pq . pop ();
-    //std::cout << "Depth " << work_node -> depth () << ", node " << work_node 
-    //          << ", size = " << work_node -> size () << "\n";
-
-    // Do not decompose if past Min depth and over the Limit size.
-    if ( ( work_node -> depth () > Min ) 
-         && ( work_node -> size () > Limit ) ) {
-      //std::cout << "Halting search due to Limit.\n";
-      continue;
-    }
-
-    work_node -> decompose ( f );
-
-    // Check for spuriousness
-    if ( work_node -> decomposition ()  . empty () ) {
-      //std::cout << "Empty decomposition for " << work_node << ", marking as spurious.\n";
-      work_node -> spurious () = true;
-    }
+  parallelFor ( 0, threads, 1, threads, [&] ( uint64_t, uint64_t, int thread_id ) {
+    MorseSetStatistics & statistics = thread_statistics [ thread_id ];
+    std::vector < MorseDecomposition * > children;
+    while ( 1 ) {
+      MorseDecomposition * work_node;
+      {
+        boost::unique_lock<boost::mutex> lock ( pq_mutex );
+        // Wait for work while other workers may still spawn some
+        while ( pq . empty () && busy > 0 && not failed ) pq_changed . wait ( lock );
+        if ( pq . empty () || failed ) return;
+        work_node = pq . top ();
+        pq . pop ();
+        ++ busy;
+        ++ nodes_processed;
+        if ( nodes_processed % 1000 == 0 ) { 
+          std::cout << nodes_processed 
+            << " nodes have been encountered on Morse Decomposition Hierarchy.\n";
+        }
+      }
+      children . clear ();
+      try {
+        //std::cout << "Depth " << work_node -> depth () << ", node " << work_node 
+        //          << ", size = " << work_node -> size () << "\n";
+
+        // Do not decompose if past Min depth and over the Limit size.
+        if ( not ( ( work_node -> depth () > Min ) 
+                   && ( work_node -> size () > Limit ) ) ) {
+          work_node -> decompose ( f, node_settings, & statistics );
+
+          // Check for spuriousness
+          if ( work_node -> decomposition ()  . empty () ) {
+            //std::cout << "Empty decomposition for " << work_node << ", marking as spurious.\n";
+            work_node -> spurious () = true;
+          }
 
-    // Hierarchical Step
-    if ( (work_node -> depth () < Max) ) {
-      std::vector < MorseDecomposition * > children = work_node -> spawn ();
-      BOOST_FOREACH ( MorseDecomposition * child, children ) {
-        child -> grid () -> subdivide ();
-        pq . push ( child );
+          // Hierarchical Step
+          if ( (work_node -> depth () < Max) ) {
+            children = work_node -> spawn ();
+            BOOST_FOREACH ( MorseDecomposition * child, children ) {
+              child -> grid () -> subdivide ();
+            }
+          } 
+        }
+      } catch ( ... ) {
+        // Wake the others so that they stop, and let parallelFor rethrow
+        boost::lock_guard<boost::mutex> lock ( pq_mutex );
+        failed = true;
+        -- busy;
+        pq_changed . notify_all ();
+        throw;
       }
-    } 
-    //else {
-      //std::cout << "Halting search due to Max.\n";
-    //}
+      {
+        boost::lock_guard<boost::mutex> lock ( pq_mutex );
+        BOOST_FOREACH ( MorseDecomposition * child, children ) pq . push ( child );
+        -- busy;
+      }
+      pq_changed . notify_all ();
+    }
+  });
+  MorseSetStatistics statistics;
+  BOOST_FOREACH ( const MorseSetStatistics & part, thread_statistics ) {
+    statistics . map += part . map;
+    statistics . scc += part . scc;
+    statistics . reachability += part . reachability;
+    statistics . subgrid += part . subgrid;
+    statistics . cache_hits += part . cache_hits;
+    statistics . cache_misses += part . cache_misses;
+    statistics . cache_spilled += part . cache_spilled;
   }
+  std::cout << "ConstructMorseDecomposition. " << nodes_processed << " nodes, "
+            << threads << " node threads, "
+            << resolveThreadCount ( settings . threads ) << " map threads. Time (summed over node threads): map evaluation " 
+            << statistics . map << "s, strong components " << statistics . scc 
+            << "s, reachability " << statistics . reachability 
+            << "s, subgrids " << statistics . subgrid << "s.\n";
+  std::cout << "ConstructMorseDecomposition. Adjacency cache: " << statistics . cache_hits
+            << " hits, " << statistics . cache_misses << " misses, " 
+            << statistics . cache_spilled << " bytes spilled to disk.\n";
 }
 
 // ConstructMorseDecomposition
@@ -355,21 +419,22 @@ inline void
 Compute_Morse_Graph (MorseGraph * MG,
                      std::shared_ptr<Grid> phase_space,
                      std::shared_ptr<const Map> f,
-                     const unsigned int Init,
                      const unsigned int Min, 
                      const unsigned int Max, 
                      const unsigned int Limit) {
-  for ( int i = 0; i < (int)Init; ++ i ) phase_space -> subdivide ();
-  Compute_Morse_Graph ( MG, phase_space, f, Min - Init, Max - Init, Limit );
+  Compute_Morse_Graph ( MG, phase_space, f, 0, Min, Max, Limit );
 }
 
 inline void 
 Compute_Morse_Graph (MorseGraph * MG,
                      std::shared_ptr<Grid> phase_space,
                      std::shared_ptr<const Map> f,
+                     const unsigned int Init,
                      const unsigned int Min, 
                      const unsigned int Max, 
-                     const unsigned int Limit) {
+                     const unsigned int Limit,
+                     const MapGraphSettings & settings ) {
+  for ( int i = 0; i < (int)Init; ++ i ) phase_space -> subdivide ();
   // Produce Morse Set Decomposition Hierarchy
   std::cout << "Compute_Morse_Graph. Initializing root MorseDecomposition\n";
   std::cout << "Compute_Morse_Graph. A phase_space -> size () == " << phase_space -> size () << "\n";
@@ -384,12 +449,13 @@ Compute_Morse_Graph (MorseGraph * MG,
   
   ConstructMorseDecomposition (root,
                                f,
-                               Min,
-                               Max,
-                               Limit);
+                               Min - Init,
+                               Max - Init,
+                               Limit,
+                               settings);
   //std::cout << "Calling ConstructMorseGraph\n";
   // Stitch together Morse Graph from Decomposition Hierarchy
-  ConstructMorseGraph ( phase_space, MG, root, Min );
+  ConstructMorseGraph ( phase_space, MG, root, Min - Init );
 
   std::cout << "Compute_Morse_Graph. B phase_space -> size () == " << phase_space -> size () << "\n";
 
@@ -23,6 +23,7 @@ void Conley_Index_Job ( Message * result,
 #include "database/program/Configuration.h"
 #include "database/program/jobs/Compute_Morse_Graph.h"
 #include "database/structures/MorseGraph.h"
+#include "database/structures/MorseGraphCode.h"
 #include "database/structures/Database.h"
 #include "database/structures/Grid.h"
 #include "database/structures/PointerGrid.h"
@@ -34,6 +35,8 @@ void Conley_Index_Job ( Message * result,
 
 #include <vector>
 #include <string>
+#include <sstream>
+#include "boost/archive/binary_iarchive.hpp"
 
 class ConleyIndexThread {
 private:
@@ -75,6 +78,8 @@ Conley_Index_Job ( Message * result,
   int PHASE_SUBDIV_MIN;
   int PHASE_SUBDIV_MAX;
   int PHASE_SUBDIV_LIMIT;
+  MapGraphSettings map_graph_settings;
+  std::string morse_graph_bytes;
   //std::vector < bool > PHASE_PERIODIC;
   job >> job_number;
   job >> incc;
@@ -84,6 +89,8 @@ Conley_Index_Job ( Message * result,
   job >> PHASE_SUBDIV_MIN;
   job >> PHASE_SUBDIV_MAX;
   job >> PHASE_SUBDIV_LIMIT;
+  job >> map_graph_settings;
+  job >> morse_graph_bytes;
   
   std::cout << "CIJ: job_number = " << job_number << "  (" << incc << ", " <<  ms << ")\n";
 
@@ -107,37 +114,50 @@ Conley_Index_Job ( Message * result,
   }
   std::shared_ptr<const Map> map = model . map ( parameter );
 
-  std::cout << "CIJ: calling Compute_Morse_Graph\n";
-  
-  Compute_Morse_Graph ( &mg,
-                        phase_space,
-                        map,
-                        PHASE_SUBDIV_INIT,
-                        PHASE_SUBDIV_MIN,
-                        PHASE_SUBDIV_MAX,
-                        PHASE_SUBDIV_LIMIT );
-  
+  // Select Subset. The Morse graph is that stored by the Morse process
+  // (as a MorseGraphCode) if the job carries one, and is computed otherwise.
+  typedef std::vector < Grid::GridElement > Subset;
+  Subset subset;
+  uint64_t num_vertices;
+  if ( not morse_graph_bytes . empty () ) {
+    std::cout << "CIJ: loading stored Morse graph\n";
+    MorseGraphCode code;
+    {
+      std::istringstream buffer ( morse_graph_bytes );
+      boost::archive::binary_iarchive ia ( buffer );
+      ia >> code;
+    }
+    code . decodePhaseSpace ( phase_space );
+    num_vertices = code . NumVertices ();
+    if ( ms < num_vertices ) code . morseSet ( & subset, * phase_space, ms );
+  } else {
+    std::cout << "CIJ: calling Compute_Morse_Graph\n";
+    Compute_Morse_Graph ( &mg,
+                          phase_space,
+                          map,
+                          PHASE_SUBDIV_INIT,
+                          PHASE_SUBDIV_MIN,
+                          PHASE_SUBDIV_MAX,
+                          PHASE_SUBDIV_LIMIT,
+                          map_graph_settings );
     std::cout << "CIJ: returned from Compute_Morse_Graph\n";
+    num_vertices = mg . NumVertices ();
+    if ( ms < num_vertices ) subset = phase_space -> subset ( * mg . grid ( ms ) );
+  }
 
-  // Select Subset
-    //std::cout << "PHASE_PERIODIC = " << (PHASE_PERIODIC[0] ? "yes" : "no" ) << "\n";
-    //std::cout << "phase bounds = " << PHASE_BOUNDS << "\n";
     std::cout << "incc = " << incc << "\n";
     std::cout << "ms = " << ms << "\n";
-    std::cout << "num vertices = " << mg . NumVertices () << "\n";
+    std::cout << "num vertices = " << num_vertices << "\n";
 
   CI_Data ci_data;
-  if ( ms >= mg . NumVertices () ) {
+  if ( ms >= num_vertices ) {
     std::cerr << "Error: request to compute Conley Index for non-existent Morse Node.\n";
     abort ();
   }
 
   std::cout << "CIJ: size of phase space = " << phase_space -> size () << "\n";
-  std::cout << "CIJ: size of morse set = " << mg . grid ( ms ) -> size () << "\n";
+  std::cout << "CIJ: size of morse set = " << subset . size () << "\n";
   std::cout << "phase space grid type: " << typeid( * phase_space ).name() << "\n";
-  std::cout << "ms grid type: " << typeid( * mg . grid ( ms ) ).name() << "\n";
-  typedef std::vector < Grid::GridElement > Subset;
-  Subset subset = phase_space -> subset ( * mg . grid ( ms ) );
 
   std::cout << "CIJ: calling Conley_Index on Morse Set " << ms << "\n";
   
@@ -0,0 +1,165 @@
+/*
+ *  Morse_Graph_Job.h
+ */
+
+#ifndef _CMDP_MORSE_GRAPH_JOB_
+#define _CMDP_MORSE_GRAPH_JOB_
+
+#include "cluster-delegator.hpp"
+#include "Model.h"
+
+void Morse_Graph_Job ( Message * result,
+                       const Message & job,
+                       const Model & model );
+
+/////////////////
+// Definitions //
+/////////////////
+
+#include <exception>
+#include <string>
+#include <sstream>
+#include <vector>
+
+#include "boost/archive/binary_oarchive.hpp"
+#include "boost/serialization/vector.hpp"
+#include "boost/serialization/string.hpp"
+#include "boost/serialization/shared_ptr.hpp"
+#include "boost/chrono.hpp"
+
+#include "database/structures/MorseGraph.h"
+#include "database/structures/MorseGraphCode.h"
+#include "database/structures/MapGraphSettings.h"
+#include "database/program/jobs/Compute_Morse_Graph.h"
+#include "database/algorithms/parallelFor.h"
+#include "database/structures/Database.h"
+#include "database/maps/Map.h"
+
+/** Main function for a parameter box job.
+ *
+ *  Computes and annotates the Morse graphs of a batch of parameter boxes,
+ *  several at a time if the job asks for more than one thread (so the
+ *  model is then used from several threads at once; see Model.h).
+ *  The result holds a database with the parameter records, followed by,
+ *  for each box in the batch,
+ *    the Morse graph with its grids, as a binary archive of a MorseGraphCode,
+ *      which the coordinator keeps until the clutching jobs at this box have
+ *      been sent, and may store (empty if the box has no map),
+ *    the time taken, in seconds,
+ *    the size of the final phase space grid,
+ *  and then the number of threads the job used (PARAM_THREADS, with 0
+ *  resolved to the number of cores of this machine).
+ */
+inline void
+Morse_Graph_Job ( Message * result,
+                  const Message & job,
+                  const Model & model ) {
+  // Read Job Message
+  std::vector<uint64_t> vertices;
+  std::vector<std::shared_ptr<Parameter> > parameters;
+  int PHASE_SUBDIV_INIT;
+  int PHASE_SUBDIV_MIN;
+  int PHASE_SUBDIV_MAX;
+  int PHASE_SUBDIV_LIMIT;
+  MapGraphSettings map_graph_settings;
+  int PARAM_THREADS;
+
+  job >> vertices;
+  job >> parameters;
+  job >> PHASE_SUBDIV_INIT;
+  job >> PHASE_SUBDIV_MIN;
+  job >> PHASE_SUBDIV_MAX;
+  job >> PHASE_SUBDIV_LIMIT;
+  job >> map_graph_settings;
+  job >> PARAM_THREADS;
+
+  // The boxes are computed concurrently, sharing the (read-only) model,
+  // and recorded in the database in batch order afterwards.
+  Database database;
+  std::vector<std::string> morse_graph_bytes ( vertices . size () );
+  std::vector<double> seconds ( vertices . size (), 0.0 );
+  std::vector<uint64_t> grid_sizes ( vertices . size (), 0 );
+
+  std::vector<MorseGraph> morse_graphs ( vertices . size () );
+  std::vector<char> computed ( vertices . size (), false );
+  int threads = resolveThreadCount ( PARAM_THREADS );
+  // If the boxes are computed side by side (see parallelFor), each one gets
+  // a single thread, so that the cores are not oversubscribed
+  if ( threads > 1 && vertices . size () >= (size_t) threads ) {
+    map_graph_settings . threads = 1;
+    map_graph_settings . node_threads = 1;
+  }
+  parallelFor ( 0, vertices . size (), 1, threads,
+                [&] ( uint64_t begin, uint64_t end, int ) {
+    for ( size_t i = begin; i < end; ++ i ) {
+      uint64_t vertex = vertices [ i ];
+      const std::shared_ptr<Parameter> & parameter = parameters [ i ];
+      boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now ();
+      std::stringstream ss;
+      ss << "Morse_Graph_Job. Processing parameter " << *parameter
+         << ", which is " << i + 1 << "/" << vertices . size () << ".\n";
+      std::cout << ss . str ();
+
+      // Prepare dynamical map
+      std::shared_ptr<const Map> map = model . map ( parameter );
+      if ( not map ) {
+        std::cout << "Morse_Graph_Job. No map associated with parameter " <<
+          *parameter << "; continuing.\n";
+        continue;
+      }
+      // Prepare phase space
+      std::shared_ptr<Grid> phase_space = model . phaseSpace ();
+      if ( not phase_space ) {
+        throw std::logic_error ( "Morse_Graph_Job. model.phaseSpace() failed"
+                                 " to return a valid pointer.\n");
+      }
+
+      // Perform Morse Graph computation
+      MorseGraph & morse_graph = morse_graphs [ i ];
+      Compute_Morse_Graph
+      ( & morse_graph,
+        phase_space,
+        map,
+        PHASE_SUBDIV_INIT,
+        PHASE_SUBDIV_MIN,
+        PHASE_SUBDIV_MAX,
+        PHASE_SUBDIV_LIMIT,
+        map_graph_settings );
+
+      // Check for warnings
+      if ( morse_graph . NumVertices () == 0 )  {
+        std::cerr << "Morse_Graph_Job. WARNING. Vertex # " << vertex << ", parameter = "
+        << *parameter << " yielded no morse sets.\n";
+      }
+
+      // Annotate the morse graph
+      model . annotate ( & morse_graph );
+      computed [ i ] = true;
+
+      // Serialize the Morse graph in compact form for the clutching jobs
+      std::ostringstream buffer;
+      {
+        MorseGraphCode code ( morse_graph );
+        boost::archive::binary_oarchive oa ( buffer );
+        oa << code;
+      }
+      morse_graph_bytes [ i ] = buffer . str ();
+      if ( morse_graph . phaseSpace () ) grid_sizes [ i ] = morse_graph . phaseSpace () -> size ();
+      seconds [ i ] = boost::chrono::duration<double>
+        ( boost::chrono::steady_clock::now () - start ) . count ();
+    }
+  });
+
+  for ( size_t i = 0; i < vertices . size (); ++ i ) {
+    if ( computed [ i ] ) database . insert ( vertices [ i ], morse_graphs [ i ] );
+  }
+
+  std::cout << "MORSE GRAPH JOB with " << vertices . size () << " parameters COMPLETE.\n";
+  *result << database;
+  *result << morse_graph_bytes;
+  *result << seconds;
+  *result << grid_sizes;
+  *result << threads;
+}
+
+#endif
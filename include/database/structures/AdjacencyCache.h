@@ -0,0 +1,191 @@
+// AdjacencyCache.h
+
+#ifndef CMDB_ADJACENCYCACHE_H
+#define CMDB_ADJACENCYCACHE_H
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <limits>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "boost/thread.hpp"
+
+/// class AdjacencyCache
+///    Stores adjacency lists of a graph on vertices 0, ..., N-1 as they are
+///    computed, so that later passes over the graph can look them up rather
+///    than recompute them. Lists are appended, in whatever order they arrive,
+///    to one long edge log (compressed sparse row storage with an offset and a
+///    degree per vertex).
+///
+///    At most "memory_budget" bytes are held in memory, counting the offset
+///    and degree tables (overhead ( num_vertices ) bytes) as well as the edge
+///    log. When the budget is exceeded the in-memory part of the log is
+///    written to an unlinked temporary file in "spill_directory" and read
+///    back on demand. If no spill directory is given, lists which do not fit
+///    are not cached (smaller lists arriving later may still fit).
+///
+///    "insert" may be called from several threads at once. "find" must not
+///    run concurrently with "insert".
+class AdjacencyCache {
+public:
+  typedef uint64_t Vertex;
+
+  /// AdjacencyCache
+  AdjacencyCache ( uint64_t num_vertices,
+                   uint64_t memory_budget,
+                   const std::string & spill_directory = std::string () );
+
+  /// ~AdjacencyCache
+  ~AdjacencyCache ( void );
+
+  /// find
+  ///   If the adjacency list of v is cached, write it to "adjacencies" and
+  ///   return true (a hit). Otherwise return false (a miss).
+  bool find ( Vertex v, std::vector<Vertex> * adjacencies );
+
+  /// insert
+  ///   Cache the adjacency list of v. Returns false if it did not fit.
+  bool insert ( Vertex v, const std::vector<Vertex> & adjacencies );
+
+  /// overhead
+  ///   Return number of bytes of bookkeeping for a graph on num_vertices
+  ///   vertices; memory budgets at or below this leave no room for lists
+  static uint64_t overhead ( uint64_t num_vertices );
+
+  /// hits
+  uint64_t hits ( void ) const { return hits_; }
+
+  /// misses
+  uint64_t misses ( void ) const { return misses_; }
+
+  /// spilled
+  ///   Return number of bytes of the edge log written to disk
+  uint64_t spilled ( void ) const { return spilled_ * sizeof ( Vertex ); }
+
+  /// memory
+  ///   Return number of bytes held in memory
+  uint64_t memory ( void ) const;
+
+private:
+  AdjacencyCache ( const AdjacencyCache & );
+  AdjacencyCache & operator = ( const AdjacencyCache & );
+  void spill ( void );
+
+  static const uint64_t NOT_CACHED = std::numeric_limits<uint64_t>::max ();
+  // offset_ [ v ] is the position of v's list in the edge log
+  std::vector<uint64_t> offset_;
+  std::vector<uint32_t> degree_;
+  // The edge log. Positions [0, spilled_) are on disk, the rest is in buffer_
+  std::vector<Vertex> buffer_;
+  uint64_t spilled_;
+  uint64_t budget_; // bytes available to buffer_
+  int fd_;
+  uint64_t hits_;
+  uint64_t misses_;
+  boost::mutex mutex_;
+};
+
+inline
+AdjacencyCache::AdjacencyCache ( uint64_t num_vertices,
+                                 uint64_t memory_budget,
+                                 const std::string & spill_directory ) :
+offset_ ( num_vertices, (uint64_t) NOT_CACHED ),
+degree_ ( num_vertices, 0 ),
+spilled_ ( 0 ),
+budget_ ( memory_budget > overhead ( num_vertices ) ? memory_budget - overhead ( num_vertices ) : 0 ),
+fd_ ( -1 ),
+hits_ ( 0 ),
+misses_ ( 0 ) {
+  if ( spill_directory . empty () ) return;
+  std::string path = spill_directory + "/adjacency_cache.XXXXXX";
+  std::vector<char> name ( path . begin (), path . end () );
+  name . push_back ( '\0' );
+  fd_ = mkstemp ( & name [ 0 ] );
+  if ( fd_ == -1 ) {
+    throw std::runtime_error ( "AdjacencyCache. Unable to create spill file in "
+                               + spill_directory + "\n" );
+  }
+  // The file disappears when closed, even if we exit abnormally
+  unlink ( & name [ 0 ] );
+}
+
+inline
+AdjacencyCache::~AdjacencyCache ( void ) {
+  if ( fd_ != -1 ) close ( fd_ );
+}
+
+inline bool
+AdjacencyCache::find ( Vertex v, std::vector<Vertex> * adjacencies ) {
+  uint64_t offset = offset_ [ v ];
+  if ( offset == NOT_CACHED ) {
+    ++ misses_;
+    return false;
+  }
+  ++ hits_;
+  uint64_t degree = degree_ [ v ];
+  if ( offset >= spilled_ ) {
+    std::vector<Vertex>::const_iterator start = buffer_ . begin () + ( offset - spilled_ );
+    adjacencies -> assign ( start, start + degree );
+    return true;
+  }
+  adjacencies -> resize ( degree );
+  if ( degree == 0 ) return true;
+  size_t bytes = degree * sizeof ( Vertex );
+  ssize_t read_bytes = pread ( fd_, & (*adjacencies) [ 0 ], bytes, offset * sizeof ( Vertex ) );
+  if ( read_bytes != (ssize_t) bytes ) {
+    throw std::runtime_error ( "AdjacencyCache. Failed to read spill file.\n" );
+  }
+  return true;
+}
+
+inline bool
+AdjacencyCache::insert ( Vertex v, const std::vector<Vertex> & adjacencies ) {
+  boost::lock_guard<boost::mutex> lock ( mutex_ );
+  if ( offset_ [ v ] != NOT_CACHED ) return true;
+  if ( fd_ == -1 &&
+       ( buffer_ . size () + adjacencies . size () ) * sizeof ( Vertex ) > budget_ ) {
+    // Nowhere to put it
+    return false;
+  }
+  offset_ [ v ] = spilled_ + buffer_ . size ();
+  degree_ [ v ] = adjacencies . size ();
+  buffer_ . insert ( buffer_ . end (), adjacencies . begin (), adjacencies . end () );
+  if ( fd_ != -1 && buffer_ . size () * sizeof ( Vertex ) > budget_ ) spill ();
+  return true;
+}
+
+inline void
+AdjacencyCache::spill ( void ) {
+  const char * data = (const char *) & buffer_ [ 0 ];
+  size_t bytes = buffer_ . size () * sizeof ( Vertex );
+  off_t position = spilled_ * sizeof ( Vertex );
+  while ( bytes > 0 ) {
+    ssize_t written = pwrite ( fd_, data, bytes, position );
+    if ( written <= 0 ) {
+      throw std::runtime_error ( "AdjacencyCache. Failed to write spill file.\n" );
+    }
+    data += written;
+    bytes -= written;
+    position += written;
+  }
+  spilled_ += buffer_ . size ();
+  buffer_ . clear ();
+}
+
+inline uint64_t
+AdjacencyCache::overhead ( uint64_t num_vertices ) {
+  return ( sizeof ( uint64_t ) + sizeof ( uint32_t ) ) * num_vertices;
+}
+
+inline uint64_t
+AdjacencyCache::memory ( void ) const {
+  return sizeof ( uint64_t ) * offset_ . size () +
+         sizeof ( uint32_t ) * degree_ . size () +
+         sizeof ( Vertex ) * buffer_ . capacity ();
+}
+
+#endif
@@ -0,0 +1,135 @@
+// BitSequence.h
+#ifndef CMDB_BITSEQUENCE_H
+#define CMDB_BITSEQUENCE_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+#include <bitset>
+#include "boost/serialization/serialization.hpp"
+#include "boost/serialization/vector.hpp"
+
+/// class BitSequence
+///    A growable sequence of bits, packed 64 to a word (bit i is bit i % 64
+///    of word i / 64). Offers the part of the std::vector<bool> interface
+///    used by the tree code, together with operations on up to 64 bits at
+///    a time. Bits past the end of the last word are kept zero.
+class BitSequence {
+public:
+  /// BitSequence
+  BitSequence ( void ) : size_ ( 0 ) {}
+
+  /// size
+  size_t size ( void ) const { return size_; }
+
+  /// empty
+  bool empty ( void ) const { return size_ == 0; }
+
+  /// clear
+  void clear ( void ) { words_ . clear (); size_ = 0; }
+
+  /// reserve
+  void reserve ( size_t n ) { words_ . reserve ( ( n + 63 ) >> 6 ); }
+
+  /// operator []
+  bool operator [] ( size_t i ) const {
+    return ( words_ [ i >> 6 ] >> ( i & 63 ) ) & 1;
+  }
+
+  /// back
+  bool back ( void ) const { return (*this) [ size_ - 1 ]; }
+
+  /// set
+  ///   Set bit i to "bit"
+  void set ( size_t i, bool bit );
+
+  /// push_back
+  void push_back ( bool bit );
+
+  /// append
+  ///   Append the low "count" bits of "bits" (count <= 64), least
+  ///   significant bit first
+  void append ( uint64_t bits, int count );
+
+  /// append
+  ///   Append bits begin through end - 1 of "source", 64 at a time
+  void append ( const BitSequence & source, size_t begin, size_t end );
+
+  /// get
+  ///   Return the "count" bits (count <= 64) starting at position i, the
+  ///   bit at position i in the least significant place
+  uint64_t get ( size_t i, int count ) const;
+
+  /// count
+  ///   Return the number of 1 bits
+  size_t count ( void ) const;
+
+  /// mask
+  ///   Return a word whose low "count" bits (count <= 64) are set
+  static uint64_t mask ( int count ) {
+    return count >= 64 ? ~ (uint64_t) 0 : ( (uint64_t) 1 << count ) - 1;
+  }
+
+private:
+  std::vector<uint64_t> words_;
+  size_t size_;
+  friend class boost::serialization::access;
+  template<class Archive>
+  void serialize ( Archive & ar, const unsigned int version ) {
+    ar & words_;
+    ar & size_;
+  }
+};
+
+inline void
+BitSequence::set ( size_t i, bool bit ) {
+  uint64_t flag = (uint64_t) 1 << ( i & 63 );
+  if ( bit ) words_ [ i >> 6 ] |= flag;
+  else words_ [ i >> 6 ] &= ~ flag;
+}
+
+inline void
+BitSequence::push_back ( bool bit ) {
+  if ( ( size_ & 63 ) == 0 ) words_ . push_back ( 0 );
+  if ( bit ) words_ . back () |= (uint64_t) 1 << ( size_ & 63 );
+  ++ size_;
+}
+
+inline void
+BitSequence::append ( uint64_t bits, int count ) {
+  if ( count == 0 ) return;
+  bits &= mask ( count );
+  int offset = size_ & 63;
+  if ( offset == 0 ) {
+    words_ . push_back ( bits );
+  } else {
+    words_ . back () |= bits << offset;
+    if ( offset + count > 64 ) words_ . push_back ( bits >> ( 64 - offset ) );
+  }
+  size_ += count;
+}
+
+inline void
+BitSequence::append ( const BitSequence & source, size_t begin, size_t end ) {
+  for ( ; begin + 64 <= end; begin += 64 ) append ( source . get ( begin, 64 ), 64 );
+  if ( begin < end ) append ( source . get ( begin, end - begin ), end - begin );
+}
+
+inline uint64_t
+BitSequence::get ( size_t i, int count ) const {
+  int offset = i & 63;
+  uint64_t result = words_ [ i >> 6 ] >> offset;
+  if ( offset + count > 64 ) result |= words_ [ ( i >> 6 ) + 1 ] << ( 64 - offset );
+  return result & mask ( count );
+}
+
+inline size_t
+BitSequence::count ( void ) const {
+  size_t result = 0;
+  for ( size_t w = 0; w < words_ . size (); ++ w ) {
+    result += std::bitset<64> ( words_ [ w ] ) . count ();
+  }
+  return result;
+}
+
+#endif
@@ -0,0 +1,90 @@
+// BoxBatch.h
+
+#ifndef CMDB_BOXBATCH_H
+#define CMDB_BOXBATCH_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+
+#include "database/structures/RectGeo.h"
+#include "database/numerics/Real.h"
+
+/// class BoxBatch
+///    A block of boxes stored dimension by dimension (structure of arrays):
+///    lower ( d ) [ i ] and upper ( d ) [ i ] are the bounds of box i in
+///    dimension d. Each lower ( d ) and upper ( d ) is a contiguous array,
+///    so a map can run over the boxes of a batch with SIMD instructions.
+class BoxBatch {
+public:
+  /// BoxBatch
+  BoxBatch ( void ) : dimension_ ( 0 ), size_ ( 0 ) {}
+
+  /// resize
+  ///   Make room for "size" boxes of dimension "dimension". Storage is
+  ///   kept when shrinking, so reusing a batch does not allocate.
+  void resize ( int dimension, size_t size );
+
+  /// dimension
+  int dimension ( void ) const { return dimension_; }
+
+  /// size
+  size_t size ( void ) const { return size_; }
+
+  /// lower
+  ///   Return the array of lower bounds in dimension d
+  Real * lower ( int d ) { return & lower_ [ d * size_ ]; }
+  const Real * lower ( int d ) const { return & lower_ [ d * size_ ]; }
+
+  /// upper
+  ///   Return the array of upper bounds in dimension d
+  Real * upper ( int d ) { return & upper_ [ d * size_ ]; }
+  const Real * upper ( int d ) const { return & upper_ [ d * size_ ]; }
+
+  /// get
+  ///   Copy box i into "box"
+  void get ( size_t i, RectGeo * box ) const;
+
+  /// set
+  ///   Copy "box" into box i
+  void set ( size_t i, const RectGeo & box );
+
+private:
+  int dimension_;
+  size_t size_;
+  std::vector<Real> lower_;
+  std::vector<Real> upper_;
+};
+
+inline void
+BoxBatch::resize ( int dimension, size_t size ) {
+  dimension_ = dimension;
+  size_ = size;
+  // Keep at least one element so that lower ( d ) is valid on empty batches
+  size_t length = std::max ( (size_t) 1, (size_t) dimension * size );
+  if ( lower_ . size () < length ) {
+    lower_ . resize ( length );
+    upper_ . resize ( length );
+  }
+}
+
+inline void
+BoxBatch::get ( size_t i, RectGeo * box ) const {
+  box -> lower_bounds . resize ( dimension_ );
+  box -> upper_bounds . resize ( dimension_ );
+  for ( int d = 0; d < dimension_; ++ d ) {
+    box -> lower_bounds [ d ] = lower ( d ) [ i ];
+    box -> upper_bounds [ d ] = upper ( d ) [ i ];
+  }
+}
+
+inline void
+BoxBatch::set ( size_t i, const RectGeo & box ) {
+  for ( int d = 0; d < dimension_; ++ d ) {
+    lower ( d ) [ i ] = box . lower_bounds [ d ];
+    upper ( d ) [ i ] = box . upper_bounds [ d ];
+  }
+}
+
+#endif
@@ -0,0 +1,397 @@
+// ColumnFile.h
+#ifndef CMDB_COLUMNFILE_H
+#define CMDB_COLUMNFILE_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <exception>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "boost/unordered_map.hpp"
+
+/// Column File Format
+///    A file of named flat arrays ("columns"), written one column at a time
+///    and read back through a read-only memory map, so a reader only touches
+///    the pages of the columns it looks at. Layout (native byte order):
+///      bytes  0- 7  magic "CMDBCOL1"
+///      bytes  8-15  offset of the table of contents
+///      bytes 16-23  number of columns
+///      bytes 24-31  reserved (zero)
+///      columns, each starting on an 8 byte boundary
+///      table of contents: per column a 32 byte name (NUL padded), its
+///      offset, its number of elements and its element size
+///    Variable length data (e.g. the edges of each DAG) is kept as two
+///    columns: "<name>.o" holds one more offset than there are rows, and
+///    "<name>.v" holds the concatenated values of the rows.
+
+/// Column
+///    A read-only array of "size" elements. For a ColumnReader it points
+///    straight into the mapped file.
+template < class T >
+struct Column {
+  const T * data;
+  uint64_t size;
+  Column ( void ) : data ( NULL ), size ( 0 ) {}
+  Column ( const T * data, uint64_t size ) : data ( data ), size ( size ) {}
+  const T & operator [] ( uint64_t i ) const { return data [ i ]; }
+  const T * begin ( void ) const { return data; }
+  const T * end ( void ) const { return data + size; }
+};
+
+/// Rows
+///    A column of variable length rows, given by an offset table and the
+///    concatenated values
+template < class T >
+struct Rows {
+  Column<uint64_t> offsets;
+  Column<T> values;
+  uint64_t size ( void ) const { return offsets . size == 0 ? 0 : offsets . size - 1; }
+  Column<T> operator [] ( uint64_t i ) const {
+    return Column<T> ( values . data + offsets [ i ], offsets [ i + 1 ] - offsets [ i ] );
+  }
+};
+
+/// class ColumnWriter
+///    Write a column file front to back. A column is either written whole
+///    (write) or streamed in pieces (begin, append, end), so nothing needs
+///    to be gathered in memory first.
+class ColumnWriter {
+public:
+  ColumnWriter ( void ) : position_ ( 0 ), open_column_ ( false ) {}
+
+  /// open
+  ///   Create "filename" and write the header
+  void open ( const std::string & filename );
+
+  /// write
+  ///   Write the column "name" holding "count" elements at "data"
+  template < class T >
+  void write ( const std::string & name, const T * data, uint64_t count );
+
+  /// write
+  ///   Write the column "name" holding the elements of "data"
+  template < class T >
+  void write ( const std::string & name, const std::vector<T> & data ) {
+    write ( name, data . empty () ? (const T *) NULL : & data [ 0 ], data . size () );
+  }
+
+  /// begin
+  ///   Start the column "name" of elements of type T
+  template < class T >
+  void begin ( const std::string & name ) { begin ( name, sizeof ( T ) ); }
+  void begin ( const std::string & name, uint64_t element_size );
+
+  /// append
+  ///   Add "count" elements at "data" to the column being written
+  template < class T >
+  void append ( const T * data, uint64_t count );
+  template < class T >
+  void append ( const std::vector<T> & data ) {
+    append ( data . empty () ? (const T *) NULL : & data [ 0 ], data . size () );
+  }
+
+  /// end
+  ///   Finish the column being written
+  void end ( void );
+
+  /// writeColumn
+  ///   Write the column "name" of "count" elements, element i being
+  ///   value ( i ). Elements are gathered in blocks before being written.
+  template < class T, class ValueFunction >
+  void writeColumn ( const std::string & name, uint64_t count, const ValueFunction & value );
+
+  /// writeRows
+  ///   Write "count" variable length rows as the columns "name.o" and
+  ///   "name.v", where row ( i, & values ) fills "values" (which it finds
+  ///   empty) with row i. Each row is produced twice, once to lay out the
+  ///   offsets and once to write it, so no more than a row is held at once.
+  template < class T, class RowFunction >
+  void writeRows ( const std::string & name, uint64_t count, const RowFunction & row );
+
+  /// close
+  ///   Write the table of contents and close the file
+  void close ( void );
+
+private:
+  struct Entry {
+    char name [ 32 ];
+    uint64_t offset;
+    uint64_t count;
+    uint64_t element_size;
+  };
+  void pad ( void );
+  void check ( void );
+  std::string filename_;
+  std::ofstream stream_;
+  std::vector<Entry> entries_;
+  uint64_t position_;
+  bool open_column_;
+};
+
+/// class ColumnReader
+///    Map a column file read-only and hand out its columns. Columns stay
+///    valid for as long as the reader is open.
+class ColumnReader {
+public:
+  ColumnReader ( void ) : map_ ( NULL ), length_ ( 0 ) {}
+  ~ColumnReader ( void ) { close (); }
+
+  /// isColumnFile
+  ///   Return true if "filename" starts with the column file magic
+  static bool isColumnFile ( const std::string & filename );
+
+  /// open
+  ///   Map "filename" and read its table of contents
+  void open ( const std::string & filename );
+
+  /// close
+  ///   Unmap the file
+  void close ( void );
+
+  /// has
+  ///   Return true if the file holds the column "name"
+  bool has ( const std::string & name ) const { return entries_ . count ( name ) != 0; }
+
+  /// column
+  ///   Return the column "name", which must hold elements of type T.
+  ///   A column that is not in the file is returned empty.
+  template < class T >
+  Column<T> column ( const std::string & name ) const;
+
+  /// rows
+  ///   Return the variable length column stored as "name.o" and "name.v"
+  template < class T >
+  Rows<T> rows ( const std::string & name ) const;
+
+private:
+  ColumnReader ( const ColumnReader & );
+  ColumnReader & operator = ( const ColumnReader & );
+  struct Entry {
+    uint64_t offset;
+    uint64_t count;
+    uint64_t element_size;
+  };
+  std::string filename_;
+  const char * map_;
+  uint64_t length_;
+  boost::unordered_map<std::string, Entry> entries_;
+};
+
+static const char CMDB_COLUMN_MAGIC [ 9 ] = "CMDBCOL1";
+
+inline void
+ColumnWriter::open ( const std::string & filename ) {
+  filename_ = filename;
+  entries_ . clear ();
+  open_column_ = false;
+  stream_ . open ( filename . c_str (), std::ios::out | std::ios::trunc | std::ios::binary );
+  uint64_t header [ 4 ] = { 0, 0, 0, 0 };
+  std::memcpy ( header, CMDB_COLUMN_MAGIC, 8 );
+  stream_ . write ( (const char *) header, sizeof ( header ) );
+  position_ = sizeof ( header );
+  check ();
+}
+
+template < class T > void
+ColumnWriter::write ( const std::string & name, const T * data, uint64_t count ) {
+  begin<T> ( name );
+  append ( data, count );
+  end ();
+}
+
+inline void
+ColumnWriter::begin ( const std::string & name, uint64_t element_size ) {
+  if ( open_column_ || name . size () >= 32 ) {
+    throw std::logic_error ( "ColumnWriter. Cannot begin column " + name + "\n" );
+  }
+  pad ();
+  Entry entry;
+  std::memset ( entry . name, 0, 32 );
+  std::memcpy ( entry . name, name . data (), name . size () );
+  entry . offset = position_;
+  entry . count = 0;
+  entry . element_size = element_size;
+  entries_ . push_back ( entry );
+  open_column_ = true;
+}
+
+template < class T > void
+ColumnWriter::append ( const T * data, uint64_t count ) {
+  if ( not open_column_ || entries_ . back () . element_size != sizeof ( T ) ) {
+    throw std::logic_error ( "ColumnWriter. Append does not match the open column\n" );
+  }
+  if ( count == 0 ) return;
+  stream_ . write ( (const char *) data, count * sizeof ( T ) );
+  position_ += count * sizeof ( T );
+  entries_ . back () . count += count;
+}
+
+inline void
+ColumnWriter::end ( void ) {
+  open_column_ = false;
+  check ();
+}
+
+template < class T, class ValueFunction > void
+ColumnWriter::writeColumn ( const std::string & name, uint64_t count,
+                            const ValueFunction & value ) {
+  const uint64_t block = 4096;
+  std::vector<T> buffer;
+  buffer . reserve ( std::min ( count, block ) );
+  begin<T> ( name );
+  for ( uint64_t i = 0; i < count; ++ i ) {
+    buffer . push_back ( value ( i ) );
+    if ( buffer . size () == block ) {
+      append ( buffer );
+      buffer . clear ();
+    }
+  }
+  append ( buffer );
+  end ();
+}
+
+template < class T, class RowFunction > void
+ColumnWriter::writeRows ( const std::string & name, uint64_t count,
+                          const RowFunction & row ) {
+  std::vector<T> values;
+  uint64_t total = 0;
+  writeColumn<uint64_t> ( name + ".o", count + 1, [&] ( uint64_t i ) {
+    uint64_t offset = total;
+    if ( i < count ) {
+      values . clear ();
+      row ( i, & values );
+      total += values . size ();
+    }
+    return offset;
+  } );
+  begin<T> ( name + ".v" );
+  for ( uint64_t i = 0; i < count; ++ i ) {
+    values . clear ();
+    row ( i, & values );
+    append ( values );
+  }
+  end ();
+}
+
+inline void
+ColumnWriter::close ( void ) {
+  if ( open_column_ ) end ();
+  pad ();
+  uint64_t toc_offset = position_;
+  if ( not entries_ . empty () ) {
+    stream_ . write ( (const char *) & entries_ [ 0 ], entries_ . size () * sizeof ( Entry ) );
+  }
+  uint64_t fields [ 2 ] = { toc_offset, entries_ . size () };
+  stream_ . seekp ( 8, std::ios::beg );
+  stream_ . write ( (const char *) fields, sizeof ( fields ) );
+  check ();
+  stream_ . close ();
+}
+
+inline void
+ColumnWriter::pad ( void ) {
+  static const char zeros [ 8 ] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+  uint64_t padding = ( 8 - position_ % 8 ) % 8;
+  stream_ . write ( zeros, padding );
+  position_ += padding;
+}
+
+inline void
+ColumnWriter::check ( void ) {
+  if ( not stream_ . good () ) {
+    throw std::runtime_error ( "ColumnWriter. Failed to write " + filename_ + "\n" );
+  }
+}
+
+inline bool
+ColumnReader::isColumnFile ( const std::string & filename ) {
+  std::ifstream input ( filename . c_str (), std::ios::in | std::ios::binary );
+  char magic [ 8 ];
+  if ( not input . read ( magic, 8 ) ) return false;
+  return std::memcmp ( magic, CMDB_COLUMN_MAGIC, 8 ) == 0;
+}
+
+inline void
+ColumnReader::open ( const std::string & filename ) {
+  close ();
+  filename_ = filename;
+  int fd = ::open ( filename . c_str (), O_RDONLY );
+  if ( fd < 0 ) {
+    throw std::runtime_error ( "ColumnReader. Unable to open " + filename + "\n" );
+  }
+  struct stat info;
+  if ( fstat ( fd, & info ) != 0 || info . st_size < 32 ) {
+    ::close ( fd );
+    throw std::runtime_error ( "ColumnReader. " + filename + " is not a column file\n" );
+  }
+  length_ = info . st_size;
+  void * map = mmap ( NULL, length_, PROT_READ, MAP_PRIVATE, fd, 0 );
+  ::close ( fd );
+  if ( map == MAP_FAILED ) {
+    length_ = 0;
+    throw std::runtime_error ( "ColumnReader. Unable to map " + filename + "\n" );
+  }
+  map_ = (const char *) map;
+  const uint64_t * header = (const uint64_t *) map_;
+  uint64_t toc_offset = header [ 1 ];
+  uint64_t toc_count = header [ 2 ];
+  if ( std::memcmp ( map_, CMDB_COLUMN_MAGIC, 8 ) != 0 ||
+       toc_offset > length_ || toc_count > ( length_ - toc_offset ) / 56 ) {
+    close ();
+    throw std::runtime_error ( "ColumnReader. " + filename + " is not a column file\n" );
+  }
+  for ( uint64_t i = 0; i < toc_count; ++ i ) {
+    const char * record = map_ + toc_offset + 56 * i;
+    Entry entry;
+    std::memcpy ( & entry, record + 32, sizeof ( Entry ) );
+    if ( entry . offset > length_ ||
+         entry . count * entry . element_size > length_ - entry . offset ) {
+      close ();
+      throw std::runtime_error ( "ColumnReader. " + filename + " is truncated\n" );
+    }
+    entries_ [ std::string ( record, strnlen ( record, 32 ) ) ] = entry;
+  }
+}
+
+inline void
+ColumnReader::close ( void ) {
+  if ( map_ != NULL ) munmap ( (void *) map_, length_ );
+  map_ = NULL;
+  length_ = 0;
+  entries_ . clear ();
+}
+
+template < class T > Column<T>
+ColumnReader::column ( const std::string & name ) const {
+  boost::unordered_map<std::string, Entry>::const_iterator it = entries_ . find ( name );
+  if ( it == entries_ . end () ) return Column<T> ();
+  if ( it -> second . element_size != sizeof ( T ) ) {
+    throw std::runtime_error ( "ColumnReader. Column " + name + " of " + filename_ +
+                               " has the wrong element size\n" );
+  }
+  return Column<T> ( (const T *) ( map_ + it -> second . offset ), it -> second . count );
+}
+
+template < class T > Rows<T>
+ColumnReader::rows ( const std::string & name ) const {
+  Rows<T> result;
+  result . offsets = column<uint64_t> ( name + ".o" );
+  result . values = column<T> ( name + ".v" );
+  if ( result . size () > 0 &&
+       ( result . offsets [ 0 ] != 0 ||
+         result . offsets [ result . size () ] != result . values . size ) ) {
+    throw std::runtime_error ( "ColumnReader. Rows " + name + " of " + filename_ +
+                               " are inconsistent\n" );
+  }
+  return result;
+}
+
+#endif
@@ -1,19 +1,25 @@
 #ifndef CMDB_COMPRESSED_TREE_H
 #define CMDB_COMPRESSED_TREE_H
 //CompressedTree.h
+#include <stdint.h>
+#include <vector>
+#include <bitset>
+#include <algorithm>
+#include "database/structures/BitSequence.h"
+
 class CompressedTree {
 public:
   /// leaf_sequence
   ///    A sequence of bits describing a full binary tree in the following manner:
   ///    leaf_sequence [ i ] == 0 if and only if the ith preorder node is a leaf.
   ///    (Note: we use the convention that the root has preorder 0.)
-  std::vector<bool> leaf_sequence; // defines a full binary tree (length 2N-1)
+  BitSequence leaf_sequence; // defines a full binary tree (length 2N-1)
   
   /// valid_sequence
   ///    A bit vector that describes which leaves are valid in full binary tree (length N)
   ///    The leaves are indexed starting at 0 and are in the order induced from preorder
   ///    An entry of 1 means validity, 0 means not valid.
-  std::vector<bool> valid_sequence; 
+  BitSequence valid_sequence;
 
   /// size
   ///    Return the number of valid leaves of the tree
@@ -23,45 +29,125 @@ public:
   ///    Update leaf_sequence and valid_sequence so that
   ///    all valid leaves become interior nodes with two leaf children.
   void subdivide ( void );
+
+  /// subtreeEnd
+  ///    Return one past the preorder position of the last node in the
+  ///    subtree rooted at preorder position "node". The subtree occupies
+  ///    leaf_sequence [ node, end ) and has ( end - node + 1 ) / 2 leaves.
+  size_t subtreeEnd ( size_t node ) const;
+};
+
+/// CompressedTreeExcess
+///    Lookup table used by CompressedTree::subtreeEnd, which scans the
+///    leaf sequence eight nodes at a time. Reading a preorder node opens
+///    one pending subtree if it is interior and closes one if it is a
+///    leaf; for eight leaf sequence bits the table holds the net change
+///    and the lowest running total reached (relative to the start).
+class CompressedTreeExcess {
+public:
+  /// table
+  ///   Return the table (built on first use)
+  static const CompressedTreeExcess & table ( void ) {
+    static const CompressedTreeExcess result;
+    return result;
+  }
+
+  /// change
+  ///   Return the net change in pending subtrees over eight nodes
+  int change ( uint8_t nodes ) const { return change_ [ nodes ]; }
+
+  /// minimum
+  ///   Return the lowest change reached after the first k nodes, k = 1..8
+  int minimum ( uint8_t nodes ) const { return minimum_ [ nodes ]; }
+
+private:
+  CompressedTreeExcess ( void );
+  int change_ [ 256 ];
+  int minimum_ [ 256 ];
+};
+
+/// CompressedTreeSubdivision
+///    Lookup table used by CompressedTree::subdivide, which handles eight
+///    nodes of the leaf sequence at a time. For eight leaf sequence bits
+///    and the valid bits of the leaves among them, an entry holds the bits
+///    which replace them in the subdivided leaf and valid sequences.
+class CompressedTreeSubdivision {
+public:
+  struct Entry {
+    uint32_t leaf_bits;
+    uint8_t leaf_length;
+    uint8_t valid_length;
+    uint16_t valid_bits;
+  };
+
+  /// table
+  ///   Return the table (built on first use)
+  static const CompressedTreeSubdivision & table ( void ) {
+    static const CompressedTreeSubdivision result;
+    return result;
+  }
+
+  /// leaves
+  ///   Return the number of leaves among eight nodes
+  int leaves ( uint8_t nodes ) const { return leaves_ [ nodes ]; }
+
+  /// operator ()
+  ///   Return the entry for eight nodes and the valid bits of their leaves
+  const Entry & operator () ( uint8_t nodes, uint64_t valid ) const {
+    return entries_ [ offset_ [ nodes ] + valid ];
+  }
+
+private:
+  CompressedTreeSubdivision ( void );
+  std::vector<Entry> entries_;
+  uint32_t offset_ [ 256 ];
+  int leaves_ [ 256 ];
 };
 
 inline size_t 
 CompressedTree::leafCount ( void ) const {
-  size_t result = 0;
-  size_t N = valid_sequence . size ();
-  for ( size_t i = 0; i < N; ++ i ) if ( valid_sequence [ i ] ) ++ result;
-  return result;
+  return valid_sequence . count ();
 }
 
 inline void 
 CompressedTree::subdivide ( void ) {
   //std::cout << "CompressedTree::subdivide\n";
+  const CompressedTreeSubdivision & table = CompressedTreeSubdivision::table ();
   CompressedTree new_tree;
-  std::vector < bool > & new_leaf_sequence
+  BitSequence & new_leaf_sequence
     = new_tree . leaf_sequence;
-  std::vector < bool > & new_valid_sequence
+  BitSequence & new_valid_sequence
     = new_tree . valid_sequence;
+  uint64_t num_valid = leafCount ();
+  new_leaf_sequence . reserve ( leaf_sequence . size () + 2 * num_valid );
+  new_valid_sequence . reserve ( valid_sequence . size () + num_valid );
 
   size_t M = leaf_sequence . size ();
   uint64_t leaf = 0;
-  for ( size_t i = 0; i < M; ++ i ) {
+  size_t i = 0;
+  // Eight nodes at a time by table lookup
+  for ( ; i + 8 <= M; i += 8 ) {
+    uint8_t nodes = leaf_sequence . get ( i, 8 );
+    int leaves = table . leaves ( nodes );
+    uint64_t valid = leaves ? valid_sequence . get ( leaf, leaves ) : 0;
+    leaf += leaves;
+    const CompressedTreeSubdivision::Entry & entry = table ( nodes, valid );
+    new_leaf_sequence . append ( entry . leaf_bits, entry . leaf_length );
+    new_valid_sequence . append ( entry . valid_bits, entry . valid_length );
+  }
+  // The rest one at a time
+  for ( ; i < M; ++ i ) {
     if ( leaf_sequence [ i ] ) {
       // Not a leaf. Copy.
       new_leaf_sequence . push_back ( 1 );
+    } else if ( valid_sequence [ leaf ++ ] ) {
+      // The leaf is valid. Subdivide it.
+      new_leaf_sequence . append ( 1, 3 );
+      new_valid_sequence . append ( 3, 2 );
     } else {
-      // This is a leaf. If it is valid, subdivide it
-      if ( valid_sequence [ leaf ++ ] ) {
-        // The leaf is valid. Subdivide it.
-        new_leaf_sequence . push_back ( 1 );
-        new_leaf_sequence . push_back ( 0 );
-        new_leaf_sequence . push_back ( 0 );
-        new_valid_sequence . push_back ( 1 );
-        new_valid_sequence . push_back ( 1 );
-      } else {
-        // The leaf is not valid. Do not subdivide. Mark as invalid.
-        new_leaf_sequence . push_back ( 0 );
-        new_valid_sequence . push_back ( 0 );
-      }
+      // The leaf is not valid. Do not subdivide. Mark as invalid.
+      new_leaf_sequence . push_back ( 0 );
+      new_valid_sequence . push_back ( 0 );
     }
   }
 
@@ -69,4 +155,75 @@ CompressedTree::subdivide ( void ) {
   std::swap ( valid_sequence, new_valid_sequence );
 }
 
+inline size_t
+CompressedTree::subtreeEnd ( size_t node ) const {
+  const CompressedTreeExcess & table = CompressedTreeExcess::table ();
+  size_t M = leaf_sequence . size ();
+  size_t i = node;
+  int64_t pending = 1;
+  // Skip eight nodes at a time while the subtree cannot close among them
+  while ( 1 ) {
+    if ( i + 8 <= M ) {
+      uint8_t nodes = leaf_sequence . get ( i, 8 );
+      if ( pending + table . minimum ( nodes ) > 0 ) {
+        pending += table . change ( nodes );
+        i += 8;
+        continue;
+      }
+    }
+    pending += leaf_sequence [ i ++ ] ? 1 : -1;
+    if ( pending == 0 ) return i;
+  }
+}
+
+inline
+CompressedTreeExcess::CompressedTreeExcess ( void ) {
+  for ( int nodes = 0; nodes < 256; ++ nodes ) {
+    int change = 0;
+    int minimum = 8;
+    for ( int bit = 0; bit < 8; ++ bit ) {
+      change += ( nodes >> bit ) & 1 ? 1 : -1;
+      minimum = std::min ( minimum, change );
+    }
+    change_ [ nodes ] = change;
+    minimum_ [ nodes ] = minimum;
+  }
+}
+
+inline
+CompressedTreeSubdivision::CompressedTreeSubdivision ( void ) {
+  // Eight nodes with k leaves have 2^k validity patterns
+  uint32_t offset = 0;
+  for ( int nodes = 0; nodes < 256; ++ nodes ) {
+    leaves_ [ nodes ] = 8 - std::bitset<8> ( nodes ) . count ();
+    offset_ [ nodes ] = offset;
+    offset += 1 << leaves_ [ nodes ];
+  }
+  entries_ . resize ( offset );
+  for ( int nodes = 0; nodes < 256; ++ nodes ) {
+    for ( uint32_t valid = 0; valid < ( 1u << leaves_ [ nodes ] ); ++ valid ) {
+      Entry & entry = entries_ [ offset_ [ nodes ] + valid ];
+      entry . leaf_bits = 0;
+      entry . leaf_length = 0;
+      entry . valid_bits = 0;
+      entry . valid_length = 0;
+      int leaf = 0;
+      for ( int bit = 0; bit < 8; ++ bit ) {
+        if ( nodes & ( 1 << bit ) ) {
+          entry . leaf_bits |= 1u << entry . leaf_length;
+          entry . leaf_length += 1;
+        } else if ( valid & ( 1u << leaf ++ ) ) {
+          entry . leaf_bits |= 1u << entry . leaf_length;
+          entry . leaf_length += 3;
+          entry . valid_bits |= 3u << entry . valid_length;
+          entry . valid_length += 2;
+        } else {
+          entry . leaf_length += 1;
+          entry . valid_length += 1;
+        }
+      }
+    }
+  }
+}
+
 #endif
@@ -4,6 +4,12 @@
 #define CMDP_DATABASE
 
 #include <cstddef>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <sstream>
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
@@ -11,6 +17,8 @@
 #include <memory>
 #include <boost/foreach.hpp>
 #include <boost/functional/hash.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/lock_guard.hpp>
 
 #include <boost/serialization/serialization.hpp>
 #include <boost/serialization/vector.hpp>
@@ -37,6 +45,8 @@
 #include "database/structures/EdgeGrid.h"
 
 #include "database/structures/MorseGraph.h"
+#include "database/structures/ColumnFile.h"
+#include "database/algorithms/parallelFor.h"
 
 #include "boost/archive/binary_iarchive.hpp"
 #include "boost/archive/binary_oarchive.hpp"
@@ -369,6 +379,240 @@ struct INCC_Record {
 };
 
 
+/*****************/
+/*   FILE        */
+/*****************/
+
+/// class DatabaseFile
+///    Read-only view of a database saved in the column file format (see
+///    ColumnFile.h and Database::save). The file is memory mapped and each
+///    record is decoded only when it is asked for, so a tool which looks at
+///    a few records of a large database neither reads nor holds the rest.
+///    The columns are:
+///      space                        parameter space (boost archive bytes)
+///      str                          rows of chars
+///      ann                          rows of string indices
+///      mg.dag mg.ann mg.abv         morse graph records
+///      dag.n dag.po                 vertex counts, rows of edges (2 ints each)
+///      bg.e cs.v                    rows of edges (2 ints each), rows of vertices
+///      ci.o ci.str                  string ranges of each record, rows of chars
+///      pr.pi pr.mg pr.mss           parameter records
+///      cr.pi1 cr.pi2 cr.bg          clutching records
+///      mgccp.mg mgccp.pi            MGCCP records
+///      inccp.cs inccp.mgccp         INCCP records
+///      mgcc.mgccp                   MGCC records
+///      incc.inccp incc.rep          INCC records (reps are 3 uint64s each)
+///      pb_to_mgccp mgccp_to_mgcc inccp_to_incc mgcc_sizes incc_sizes
+///      incc_conley                  flat lookup tables
+///      incc_to_mgcc mgcc_nb         rows of (sorted) indices
+class DatabaseFile {
+public:
+  /// open
+  ///   Map "filename"
+  void open ( const std::string & filename );
+
+  /// columns
+  ///   Return the underlying column reader
+  const ColumnReader & columns ( void ) const { return reader_; }
+
+  /// parameterSpace
+  ///   Decode and return the parameter space (NULL if none was saved)
+  std::shared_ptr<ParameterSpace> parameterSpace ( void ) const;
+
+  uint64_t numStrings ( void ) const { return strings_ . size (); }
+  uint64_t numAnnotations ( void ) const { return annotations_ . size (); }
+  uint64_t numMorseGraphs ( void ) const { return mg_dag_ . size; }
+  uint64_t numDAGs ( void ) const { return dag_n_ . size; }
+  uint64_t numBGs ( void ) const { return bg_ . size (); }
+  uint64_t numCSs ( void ) const { return cs_ . size (); }
+  uint64_t numCIs ( void ) const { return ci_ . size == 0 ? 0 : ci_ . size - 1; }
+  uint64_t numParameterRecords ( void ) const { return pr_pi_ . size; }
+  uint64_t numClutchRecords ( void ) const { return cr_bg_ . size; }
+  uint64_t numMGCCPs ( void ) const { return mgccp_mg_ . size; }
+  uint64_t numINCCPs ( void ) const { return inccp_cs_ . size; }
+  uint64_t numMGCCs ( void ) const { return mgcc_ . size (); }
+  uint64_t numINCCs ( void ) const { return incc_ . size (); }
+
+  std::string string ( uint64_t i ) const;
+  Annotation_Record annotation ( uint64_t i ) const;
+  MorseGraphRecord morsegraph ( uint64_t i ) const;
+  DAG_Data dag ( uint64_t i ) const;
+  BG_Data bg ( uint64_t i ) const;
+  CS_Data cs ( uint64_t i ) const;
+  CI_Data ci ( uint64_t i ) const;
+  ParameterRecord parameterRecord ( uint64_t i ) const;
+  ClutchingRecord clutchRecord ( uint64_t i ) const;
+  MGCCP_Record MGCCP ( uint64_t i ) const;
+  INCCP_Record INCCP ( uint64_t i ) const;
+  MGCC_Record MGCC ( uint64_t i ) const;
+  INCC_Record INCC ( uint64_t i ) const;
+
+  Column<uint64_t> pb_to_mgccp ( void ) const { return reader_ . column<uint64_t> ( "pb_to_mgccp" ); }
+  Column<uint64_t> mgccp_to_mgcc ( void ) const { return reader_ . column<uint64_t> ( "mgccp_to_mgcc" ); }
+  Column<uint64_t> inccp_to_incc ( void ) const { return reader_ . column<uint64_t> ( "inccp_to_incc" ); }
+  Column<uint64_t> mgcc_sizes ( void ) const { return reader_ . column<uint64_t> ( "mgcc_sizes" ); }
+  Column<uint64_t> incc_sizes ( void ) const { return reader_ . column<uint64_t> ( "incc_sizes" ); }
+  Column<uint64_t> incc_conley ( void ) const { return reader_ . column<uint64_t> ( "incc_conley" ); }
+  Rows<uint64_t> incc_to_mgcc ( void ) const { return reader_ . rows<uint64_t> ( "incc_to_mgcc" ); }
+  Rows<uint64_t> mgcc_nb ( void ) const { return reader_ . rows<uint64_t> ( "mgcc_nb" ); }
+
+private:
+  ColumnReader reader_;
+  Rows<char> strings_;
+  Rows<uint64_t> annotations_;
+  Column<uint64_t> mg_dag_, mg_ann_;
+  Rows<uint64_t> mg_abv_;
+  Column<int32_t> dag_n_;
+  Rows<int32_t> dag_po_, bg_, cs_;
+  Column<uint64_t> ci_;
+  Rows<char> ci_strings_;
+  Column<uint64_t> pr_pi_, pr_mg_;
+  Rows<uint64_t> pr_mss_;
+  Column<uint64_t> cr_pi1_, cr_pi2_, cr_bg_;
+  Column<uint64_t> mgccp_mg_;
+  Rows<uint64_t> mgccp_pi_;
+  Column<uint64_t> inccp_cs_, inccp_mgccp_;
+  Rows<uint64_t> mgcc_, incc_, incc_rep_;
+};
+
+inline void DatabaseFile::open ( const std::string & filename ) {
+  reader_ . open ( filename );
+  strings_ = reader_ . rows<char> ( "str" );
+  annotations_ = reader_ . rows<uint64_t> ( "ann" );
+  mg_dag_ = reader_ . column<uint64_t> ( "mg.dag" );
+  mg_ann_ = reader_ . column<uint64_t> ( "mg.ann" );
+  mg_abv_ = reader_ . rows<uint64_t> ( "mg.abv" );
+  dag_n_ = reader_ . column<int32_t> ( "dag.n" );
+  dag_po_ = reader_ . rows<int32_t> ( "dag.po" );
+  bg_ = reader_ . rows<int32_t> ( "bg.e" );
+  cs_ = reader_ . rows<int32_t> ( "cs.v" );
+  ci_ = reader_ . column<uint64_t> ( "ci.o" );
+  ci_strings_ = reader_ . rows<char> ( "ci.str" );
+  pr_pi_ = reader_ . column<uint64_t> ( "pr.pi" );
+  pr_mg_ = reader_ . column<uint64_t> ( "pr.mg" );
+  pr_mss_ = reader_ . rows<uint64_t> ( "pr.mss" );
+  cr_pi1_ = reader_ . column<uint64_t> ( "cr.pi1" );
+  cr_pi2_ = reader_ . column<uint64_t> ( "cr.pi2" );
+  cr_bg_ = reader_ . column<uint64_t> ( "cr.bg" );
+  mgccp_mg_ = reader_ . column<uint64_t> ( "mgccp.mg" );
+  mgccp_pi_ = reader_ . rows<uint64_t> ( "mgccp.pi" );
+  inccp_cs_ = reader_ . column<uint64_t> ( "inccp.cs" );
+  inccp_mgccp_ = reader_ . column<uint64_t> ( "inccp.mgccp" );
+  mgcc_ = reader_ . rows<uint64_t> ( "mgcc.mgccp" );
+  incc_ = reader_ . rows<uint64_t> ( "incc.inccp" );
+  incc_rep_ = reader_ . rows<uint64_t> ( "incc.rep" );
+}
+
+inline std::shared_ptr<ParameterSpace> DatabaseFile::parameterSpace ( void ) const {
+  std::shared_ptr<ParameterSpace> result;
+  Column<char> bytes = reader_ . column<char> ( "space" );
+  if ( bytes . size == 0 ) return result;
+  std::istringstream buffer ( std::string ( bytes . data, bytes . size ) );
+  boost::archive::binary_iarchive ia ( buffer );
+  ia >> result;
+  return result;
+}
+
+inline std::string DatabaseFile::string ( uint64_t i ) const {
+  Column<char> row = strings_ [ i ];
+  return std::string ( row . data, row . size );
+}
+
+inline Annotation_Record DatabaseFile::annotation ( uint64_t i ) const {
+  Annotation_Record result;
+  Column<uint64_t> row = annotations_ [ i ];
+  result . string_indices . insert ( row . begin (), row . end () );
+  return result;
+}
+
+inline MorseGraphRecord DatabaseFile::morsegraph ( uint64_t i ) const {
+  Column<uint64_t> row = mg_abv_ [ i ];
+  return MorseGraphRecord ( mg_dag_ [ i ], mg_ann_ [ i ],
+                            std::vector<uint64_t> ( row . begin (), row . end () ) );
+}
+
+inline DAG_Data DatabaseFile::dag ( uint64_t i ) const {
+  DAG_Data result;
+  result . num_vertices = dag_n_ [ i ];
+  Column<int32_t> row = dag_po_ [ i ];
+  result . partial_order . reserve ( row . size / 2 );
+  for ( uint64_t j = 0; j + 1 < row . size; j += 2 ) {
+    result . partial_order . push_back ( std::make_pair ( row [ j ], row [ j + 1 ] ) );
+  }
+  return result;
+}
+
+inline BG_Data DatabaseFile::bg ( uint64_t i ) const {
+  BG_Data result;
+  Column<int32_t> row = bg_ [ i ];
+  result . edges . reserve ( row . size / 2 );
+  for ( uint64_t j = 0; j + 1 < row . size; j += 2 ) {
+    result . edges . push_back ( std::make_pair ( row [ j ], row [ j + 1 ] ) );
+  }
+  return result;
+}
+
+inline CS_Data DatabaseFile::cs ( uint64_t i ) const {
+  CS_Data result;
+  Column<int32_t> row = cs_ [ i ];
+  result . vertices . assign ( row . begin (), row . end () );
+  return result;
+}
+
+inline CI_Data DatabaseFile::ci ( uint64_t i ) const {
+  CI_Data result;
+  for ( uint64_t j = ci_ [ i ]; j < ci_ [ i + 1 ]; ++ j ) {
+    Column<char> row = ci_strings_ [ j ];
+    result . conley_index . push_back ( std::string ( row . data, row . size ) );
+  }
+  return result;
+}
+
+inline ParameterRecord DatabaseFile::parameterRecord ( uint64_t i ) const {
+  Column<uint64_t> row = pr_mss_ [ i ];
+  return ParameterRecord ( pr_pi_ [ i ], pr_mg_ [ i ],
+                           std::vector<uint64_t> ( row . begin (), row . end () ) );
+}
+
+inline ClutchingRecord DatabaseFile::clutchRecord ( uint64_t i ) const {
+  return ClutchingRecord ( cr_pi1_ [ i ], cr_pi2_ [ i ], cr_bg_ [ i ] );
+}
+
+inline MGCCP_Record DatabaseFile::MGCCP ( uint64_t i ) const {
+  MGCCP_Record result;
+  Column<uint64_t> row = mgccp_pi_ [ i ];
+  result . parameter_indices . assign ( row . begin (), row . end () );
+  result . morsegraph_index = mgccp_mg_ [ i ];
+  return result;
+}
+
+inline INCCP_Record DatabaseFile::INCCP ( uint64_t i ) const {
+  INCCP_Record result;
+  result . cs_index = inccp_cs_ [ i ];
+  result . mgccp_index = inccp_mgccp_ [ i ];
+  return result;
+}
+
+inline MGCC_Record DatabaseFile::MGCC ( uint64_t i ) const {
+  MGCC_Record result;
+  Column<uint64_t> row = mgcc_ [ i ];
+  result . mgccp_indices . assign ( row . begin (), row . end () );
+  return result;
+}
+
+inline INCC_Record DatabaseFile::INCC ( uint64_t i ) const {
+  INCC_Record result;
+  Column<uint64_t> row = incc_ [ i ];
+  result . inccp_indices . assign ( row . begin (), row . end () );
+  Column<uint64_t> reps = incc_rep_ [ i ];
+  for ( uint64_t j = 0; j + 2 < reps . size; j += 3 ) {
+    result . smallest_reps . insert ( std::make_pair ( reps [ j ],
+      std::make_pair ( reps [ j + 1 ], reps [ j + 2 ] ) ) );
+  }
+  return result;
+}
+
+
 /****************/
 /*   DATABASE   */
 /****************/
@@ -388,15 +632,30 @@ private:
   std::vector < BG_Data > bg_data_;
   std::vector < CS_Data > cs_data_;
   std::vector < CI_Data > ci_data_;
-  std::unordered_map < std::string, uint64_t > string_index_;
-  std::unordered_map < Annotation_Record, uint64_t, boost::hash<Annotation_Record> > annotation_index_;
-  std::unordered_map < MorseGraphRecord, uint64_t, boost::hash<MorseGraphRecord> > morsegraph_index_;
-  std::unordered_map < DAG_Data, uint64_t, boost::hash<DAG_Data> > dag_index_;
-  std::unordered_map < BG_Data, uint64_t, boost::hash<BG_Data> > bg_index_;
-  std::unordered_map < CS_Data, uint64_t, boost::hash<CS_Data> > cs_index_;
-  std::unordered_map < CI_Data, uint64_t, boost::hash<CI_Data> > ci_index_;
+  // (the indices are not saved in the column format; after such a load they
+  //  are rebuilt from the data, one at a time, the first time one is needed)
+  mutable std::unordered_map < std::string, uint64_t > string_index_;
+  mutable std::unordered_map < Annotation_Record, uint64_t, boost::hash<Annotation_Record> > annotation_index_;
+  mutable std::unordered_map < MorseGraphRecord, uint64_t, boost::hash<MorseGraphRecord> > morsegraph_index_;
+  mutable std::unordered_map < DAG_Data, uint64_t, boost::hash<DAG_Data> > dag_index_;
+  mutable std::unordered_map < BG_Data, uint64_t, boost::hash<BG_Data> > bg_index_;
+  mutable std::unordered_map < CS_Data, uint64_t, boost::hash<CS_Data> > cs_index_;
+  mutable std::unordered_map < CI_Data, uint64_t, boost::hash<CI_Data> > ci_index_;
+  // Which indices are stale, and the lock taken to rebuild them, so that
+  // const lookups may run concurrently. A copy gets a lock of its own.
+  struct IndexState {
+    std::atomic<int> stale;
+    boost::mutex mutex;
+    IndexState ( void ) : stale ( 0 ) {}
+    IndexState ( const IndexState & other ) : stale ( other . stale . load () ) {}
+    IndexState & operator = ( const IndexState & other ) {
+      stale = other . stale . load ();
+      return *this;
+    }
+  };
+  mutable IndexState index_state_;
   // continuation data
-  std::unordered_map < INCCP_Record, uint64_t, boost::hash<INCCP_Record> > inccp_index_;
+  mutable std::unordered_map < INCCP_Record, uint64_t, boost::hash<INCCP_Record> > inccp_index_;
   std::vector < uint64_t > pb_to_mgccp_;
   std::vector < uint64_t > mgccp_to_mgcc_;
   std::vector < uint64_t > inccp_to_incc_;
@@ -410,6 +669,20 @@ private:
   std::vector < MGCC_Record > MGCC_records_;
   std::vector < INCC_Record > INCC_records_;
 
+  enum { STRING_INDEX = 1, ANNOTATION_INDEX = 2, MORSEGRAPH_INDEX = 4, DAG_INDEX = 8,
+         BG_INDEX = 16, CS_INDEX = 32, CI_INDEX = 64, INCCP_INDEX = 128, ALL_INDICES = 255 };
+
+  /// index
+  ///    rebuild those of the indices in "which" that are stale. Safe to call
+  ///    from several threads at once (the const lookups do); the methods
+  ///    that modify the database must not run alongside anything else.
+  void index ( int which ) const;
+
+  /// saveColumns / loadColumns
+  ///    save and load in the column file format (see DatabaseFile)
+  void saveColumns ( const char * filename );
+  void loadColumns ( const char * filename );
+
 public:
   Database ( void ) {}
 
@@ -470,10 +743,30 @@ public:
   void insert ( uint64_t incc, const CI_Data & ci );
 
 
-  void postprocess ( void );
+  /// postprocess
+  ///    compute the continuation classes (MGCCs and INCCs) from the raw
+  ///    parameter and clutching records, using "threads" threads
+  ///    (0: one per core). If the database has been postprocessed before,
+  ///    the raw records inserted since (e.g. with merge) are folded into the
+  ///    existing classes instead; only the new clutching records are
+  ///    examined. Records of parameters which were already postprocessed are
+  ///    ignored, and folding is refused once Conley index data is attached.
+  void postprocess ( int threads = 1 );
   void makeAttractorsMinimal ( void );
   void performTransitiveReductions ( void );
-  void save ( const char * filename );   
+
+  /// save
+  ///    save in the column file format, which can be memory mapped and read
+  ///    lazily with DatabaseFile
+  void save ( const char * filename );
+
+  /// saveArchive
+  ///    save as a boost binary archive (the format used before the column
+  ///    format, still read by load)
+  void saveArchive ( const char * filename );
+
+  /// load
+  ///    load a database saved by save or by saveArchive
   void load ( const char * filename );
   
   const ParameterSpace & parameter_space ( void ) const { return *parameter_space_;}
@@ -500,21 +793,21 @@ public:
   const std::vector < CI_Data > & ciData ( void ) const 
     { return ci_data_; }
   uint64_t morsegraphIndex ( MorseGraphRecord const& item ) const 
-    { if ( morsegraph_index_ . count ( item ) == 0 ) return morsegraphData().size(); return morsegraph_index_ . find (item) -> second; }
+    { index ( MORSEGRAPH_INDEX ); if ( morsegraph_index_ . count ( item ) == 0 ) return morsegraphData().size(); return morsegraph_index_ . find (item) -> second; }
   uint64_t stringIndex ( std::string const& item ) const 
-    { if ( string_index_ . count ( item ) == 0 ) return stringData().size(); return string_index_ . find (item) -> second; }
+    { index ( STRING_INDEX ); if ( string_index_ . count ( item ) == 0 ) return stringData().size(); return string_index_ . find (item) -> second; }
   uint64_t annotationIndex ( Annotation_Record const& item ) const 
-    { if ( annotation_index_ . count ( item ) == 0 ) return annotationData().size(); return annotation_index_ . find (item) -> second; }
+    { index ( ANNOTATION_INDEX ); if ( annotation_index_ . count ( item ) == 0 ) return annotationData().size(); return annotation_index_ . find (item) -> second; }
   uint64_t dagIndex ( DAG_Data const& item ) const 
-    { if ( dag_index_ . count ( item ) == 0 ) return dagData().size(); return dag_index_ . find (item) -> second; }
+    { index ( DAG_INDEX ); if ( dag_index_ . count ( item ) == 0 ) return dagData().size(); return dag_index_ . find (item) -> second; }
   uint64_t bgIndex ( BG_Data const& item ) const 
-    { if ( bg_index_ . count ( item ) == 0 ) return bgData().size(); return bg_index_ . find (item) -> second; }
+    { index ( BG_INDEX ); if ( bg_index_ . count ( item ) == 0 ) return bgData().size(); return bg_index_ . find (item) -> second; }
   uint64_t csIndex ( CS_Data const& item ) const 
-    { if ( cs_index_ . count ( item ) == 0 ) return csData().size(); return cs_index_ . find (item) -> second; }
+    { index ( CS_INDEX ); if ( cs_index_ . count ( item ) == 0 ) return csData().size(); return cs_index_ . find (item) -> second; }
   uint64_t ciIndex ( CI_Data const& item ) const 
-    { if ( ci_index_ . count ( item ) == 0 ) return ciData().size(); return ci_index_ . find (item) -> second; }
+    { index ( CI_INDEX ); if ( ci_index_ . count ( item ) == 0 ) return ciData().size(); return ci_index_ . find (item) -> second; }
   uint64_t inccpIndex ( INCCP_Record const& item ) const 
-    { if ( inccp_index_ . count ( item ) == 0 ) return INCCP_Records().size(); return inccp_index_ . find (item) -> second; }
+    { index ( INCCP_INDEX ); if ( inccp_index_ . count ( item ) == 0 ) return INCCP_Records().size(); return inccp_index_ . find (item) -> second; }
 
 
   const std::vector < uint64_t > & pb_to_mgccp ( void ) const { return pb_to_mgccp_; }
@@ -534,6 +827,10 @@ public:
 
   template<class Archive>
   void serialize(Archive& ar, const unsigned int version) {
+    // The archive holds the indices, so they must be current when saving;
+    // after loading they are all current
+    if ( Archive::is_saving::value ) index ( ALL_INDICES );
+    index_state_ . stale = 0;
     bool has_space = (bool) parameter_space_;
     ar & boost::serialization::make_nvp("HASPARAMETERSPACE", has_space);
     if ( has_space ) {
@@ -571,11 +868,11 @@ public:
   }
    bool is_identity ( const MorseGraphRecord & mgr1, 
                       const MorseGraphRecord & mgr2, 
-                      const BG_Data & bg );
+                      const BG_Data & bg ) const;
 
    bool is_isomorphism ( const MorseGraphRecord & mgr1, 
                          const MorseGraphRecord & mgr2, 
-                         const BG_Data & bg );
+                         const BG_Data & bg ) const;
 };
 
     /*******************/
@@ -675,6 +972,7 @@ inline void Database::insert ( std::shared_ptr<ParameterSpace> parameter_space )
 }
 
 inline uint64_t Database::insert ( const DAG_Data & dag ) {
+  index ( DAG_INDEX );
   if ( dag_index_ . count ( dag ) == 0 ) {
     dag_index_ [ dag ] = dag_data_ . size ();
     dag_data_ . push_back ( dag );
@@ -684,6 +982,7 @@ inline uint64_t Database::insert ( const DAG_Data & dag ) {
 
 
 inline uint64_t Database::insert ( const std::string & s ) {
+  index ( STRING_INDEX );
   if ( string_index_ . count ( s ) == 0 ) {
     string_index_ [ s ] = string_data_ . size ();
     string_data_ . push_back ( s );
@@ -692,6 +991,7 @@ inline uint64_t Database::insert ( const std::string & s ) {
 }
 
 inline uint64_t Database::insert ( const Annotation_Record & ar ) {
+  index ( ANNOTATION_INDEX );
   if ( annotation_index_ . count ( ar ) == 0 ) {
     annotation_index_ [ ar ] = annotation_data_ . size ();
     annotation_data_ . push_back ( ar );
@@ -708,6 +1008,7 @@ inline uint64_t Database::insert ( const std::set<std::string> & annotation ) {
 }
 
 inline uint64_t Database::insert ( const MorseGraphRecord & mgr ) {
+  index ( MORSEGRAPH_INDEX );
   if ( morsegraph_index_ . count ( mgr ) == 0 ) {
     morsegraph_index_ [ mgr ] = morsegraph_data_ . size ();
     morsegraph_data_ . push_back ( mgr );
@@ -744,6 +1045,7 @@ inline void Database::insert ( uint64_t p, const MorseGraph & mg ) {
 }
 
 inline uint64_t Database::insert ( const BG_Data & bg ) {
+  index ( BG_INDEX );
   if ( bg_index_ . count ( bg ) == 0 ) {
     bg_index_ [ bg ] = bg_data_ . size ();
     bg_data_ . push_back ( bg );
@@ -752,6 +1054,7 @@ inline uint64_t Database::insert ( const BG_Data & bg ) {
 }
 
 inline uint64_t Database::insert ( const CS_Data & cs ) {
+  index ( CS_INDEX );
   if ( cs_index_ . count ( cs ) == 0 ) {
     cs_index_ [ cs ] = cs_data_ . size ();
     cs_data_ . push_back ( cs );
@@ -760,6 +1063,7 @@ inline uint64_t Database::insert ( const CS_Data & cs ) {
 }
 
 inline uint64_t Database::insert ( const CI_Data & ci ) {
+  index ( CI_INDEX );
   if ( ci_index_ . count ( ci ) == 0 ) {
     ci_index_ [ ci ] = ci_data_ . size ();
     ci_data_ . push_back ( ci );
@@ -840,9 +1144,46 @@ private:
   std::vector<uint64_t> rank;
 };
 
+/// ConcurrentIntegerUnionFind
+///    Union-find structure on 0, ..., N-1 which several threads may use at
+///    once. Roots are linked with an atomic compare-and-swap, always the
+///    larger index under the smaller, and Find halves paths as it goes. The
+///    partition does not depend on the order of the Unions.
+class ConcurrentIntegerUnionFind {
+public:
+  ConcurrentIntegerUnionFind ( uint64_t N ) : parent ( N ) {
+    for ( uint64_t i = 0; i < N; ++ i ) parent [ i ] . store ( i, std::memory_order_relaxed );
+  }
+
+  void Union ( uint64_t x, uint64_t y ) {
+    while ( 1 ) {
+      x = Find ( x );
+      y = Find ( y );
+      if ( x == y ) return;
+      if ( x < y ) std::swap ( x, y );
+      // Fails if another thread linked x meanwhile; then start over
+      uint64_t expected = x;
+      if ( parent [ x ] . compare_exchange_strong ( expected, y ) ) return;
+    }
+  }
+
+  uint64_t Find ( uint64_t x ) {
+    while ( 1 ) {
+      uint64_t p = parent [ x ] . load ();
+      if ( p == x ) return x;
+      uint64_t g = parent [ p ] . load ();
+      if ( g != p ) parent [ x ] . compare_exchange_weak ( p, g );
+      x = g;
+    }
+  }
+
+private:
+  std::vector < std::atomic < uint64_t > > parent;
+};
+
 inline bool Database::is_identity ( const MorseGraphRecord & mgr1, 
                                     const MorseGraphRecord & mgr2, 
-                                    const BG_Data & bg ) {
+                                    const BG_Data & bg ) const {
   const DAG_Data & dag1 = dagData()[mgr1.dag_index];
   const DAG_Data & dag2 = dagData()[mgr2.dag_index];
   if ( dag1 . num_vertices != dag2 . num_vertices ) return false;
@@ -855,56 +1196,84 @@ inline bool Database::is_identity ( const MorseGraphRecord & mgr1,
 
 inline bool Database::is_isomorphism ( const MorseGraphRecord & mgr1, 
                                        const MorseGraphRecord & mgr2, 
-                                       const BG_Data & bg ) {
+                                       const BG_Data & bg ) const {
   const DAG_Data & dag1 = dagData()[mgr1.dag_index];
   const DAG_Data & dag2 = dagData()[mgr2.dag_index];
   // Check that it is a bijection
   if ( dag1 . num_vertices != dag2 . num_vertices ) return false;
-  std::unordered_map < int, int > forward;
-  std::unordered_map < int, int > backward;
+  if ( bg . edges . size () != (uint64_t) dag1 . num_vertices ) return false;
+  int n = dag1 . num_vertices;
+  std::vector < int > forward ( n, -1 );
+  std::vector < int > backward ( n, -1 );
   typedef std::pair < int, int > Edge;
-  size_t num_clutch_edges = 0;
   BOOST_FOREACH ( const Edge & e, bg . edges ) {
-    if ( forward . count ( e . first ) != 0 ) return false;
-    if ( backward . count ( e . second ) != 0 ) return false;
+    if ( e . first < 0 || e . first >= n || e . second < 0 || e . second >= n ) return false;
+    if ( forward [ e . first ] != -1 ) return false;
+    if ( backward [ e . second ] != -1 ) return false;
     forward [ e . first ] = e . second;
     backward [ e . second ] = e . first;
     if ( mgr1.annotation_index_by_vertex[e.first] != 
          mgr2.annotation_index_by_vertex[e.second] ) return false;
-    ++ num_clutch_edges;
   }
-  if ( num_clutch_edges != (uint64_t) dag1 . num_vertices ) return false;
-  if ( num_clutch_edges != (uint64_t) dag2 . num_vertices ) return false;
   // Check that the partial order is respected
-  std::unordered_set < Edge, boost::hash<Edge> > po1;
-  std::unordered_set < Edge, boost::hash<Edge> > po2;
-  BOOST_FOREACH ( const Edge & e, dag1 . partial_order ) po1 . insert ( e );
-  BOOST_FOREACH ( const Edge & e, dag2 . partial_order ) po2 . insert ( e );
+  std::vector < Edge > po1 ( dag1 . partial_order . begin (), dag1 . partial_order . end () );
+  std::vector < Edge > po2 ( dag2 . partial_order . begin (), dag2 . partial_order . end () );
+  std::sort ( po1 . begin (), po1 . end () );
+  std::sort ( po2 . begin (), po2 . end () );
   BOOST_FOREACH ( const Edge & e, dag1 . partial_order ) {
     Edge checkme ( forward [ e . first ], forward [ e . second ] );
-    if ( po2 . count ( checkme ) == 0 ) return false;
+    if ( not std::binary_search ( po2 . begin (), po2 . end (), checkme ) ) return false;
   }
   BOOST_FOREACH ( const Edge & e, dag2 . partial_order ) {
     Edge checkme ( backward [ e . first ], backward [ e . second ] );
-    if ( po1 . count ( checkme ) == 0 ) return false;
+    if ( not std::binary_search ( po1 . begin (), po1 . end (), checkme ) ) return false;
   }
   return true;
 }
 
-inline void Database::postprocess ( void ) {
+inline void Database::postprocess ( int threads ) {
   typedef uint64_t ParameterIndex;
+  index ( CS_INDEX | INCCP_INDEX );
+  threads = resolveThreadCount ( threads );
 
   uint64_t N = parameter_space_ -> size ();
+  bool incremental = not MGCCP_records_ . empty ();
+  if ( incremental && not incc_conley_ . empty () ) {
+    throw std::logic_error ( "Database::postprocess. Cannot fold records into a database "
+                             "which already has Conley index data\n" );
+  }
 
   std::cout << "Database::postprocess\n";
   std::cout << " Number of parameters = " << N << "\n";
   std::cout << " Number of Morse Records = " << parameter_records () . size () << "\n";
   std::cout << " Number of DAGs = " << dagData () . size () << "\n";
+  std::cout << " Threads = " << threads << "\n";
+  if ( incremental ) {
+    std::cout << " Folding into " << MGCCP_Records () . size () << " MGCCPs\n";
+    // Parameters classified by an earlier postprocess keep their Morse graphs
+    uint64_t unclassified = MGCCP_Records () . size ();
+    uint64_t kept = 0;
+    for ( uint64_t i = 0; i < parameter_records_ . size (); ++ i ) {
+      if ( pb_to_mgccp_ [ parameter_records_ [ i ] . parameter_index ] != unclassified ) continue;
+      parameter_records_ [ kept ++ ] = parameter_records_ [ i ];
+    }
+    if ( kept < parameter_records_ . size () ) {
+      std::cout << "Warning: ignoring " << parameter_records_ . size () - kept 
+                << " records of parameters which were already postprocessed.\n";
+      parameter_records_ . resize ( kept );
+    }
+  }
+
   // Loop through morse records and create a temporary lookup
   // from parameter indices to dag codes
 
   // TODO: USE EXTERNAL MEMORY SORT TO AVOID RANDOM ACCESS PATTERN
   std::vector < int64_t > param_to_mgr ( N, -1 );
+  BOOST_FOREACH ( const MGCCP_Record & mgccp_record, MGCCP_Records () ) {
+    BOOST_FOREACH ( ParameterIndex pi, mgccp_record . parameter_indices ) {
+      param_to_mgr [ pi ] = (int64_t) mgccp_record . morsegraph_index;
+    }
+  }
   BOOST_FOREACH ( const ParameterRecord & pr, parameter_records () ) {
     uint64_t morsegraph_index = pr . morsegraph_index;
     //const MorseGraphRecord & mgr = morsegraphData () [ morsegraph_index ];
@@ -915,26 +1284,60 @@ inline void Database::postprocess ( void ) {
     //}
     param_to_mgr [ pr . parameter_index ] = (int64_t) morsegraph_index;
   }
+  uint64_t num_clutch_records = clutch_records_ . size ();
+  std::vector < char > valid_clutching ( num_clutch_records );
+  uint64_t num_invalid = 0;
+  for ( uint64_t r = 0; r < num_clutch_records; ++ r ) {
+    const ClutchingRecord & cr = clutch_records_ [ r ];
+    valid_clutching [ r ] = param_to_mgr [ cr . parameter_index_1 ] != -1 &&
+                            param_to_mgr [ cr . parameter_index_2 ] != -1;
+    if ( not valid_clutching [ r ] ) ++ num_invalid;
+  }
+  if ( num_invalid > 0 ) {
+    std::cout << "Warning: database has " << num_invalid << " invalid clutching records.\n";
+  }
 
-  // Process the clutching records sequentially, and create
+  // Process the clutching records in parallel, and create
   // a union-find structure on parameters
 
-  //std::cout << "Database::postprocess Process clutching in sequence and create union-find\n";
-  ContiguousIntegerUnionFind mgccp_uf (N);
-  BOOST_FOREACH ( const ClutchingRecord & cr, clutch_records () ) {
-    // Handle spurious records
-    if ( param_to_mgr [ cr . parameter_index_1 ] == -1 ||
-        param_to_mgr [ cr . parameter_index_2 ] == -1 ) {
-      std::cout << "Warning: database has invalid clutching records.\n";
-      continue;
-    }
-
-    if ( is_identity ( morsegraph_data_ [ param_to_mgr [ cr . parameter_index_1 ] ], 
-                       morsegraph_data_ [ param_to_mgr [ cr . parameter_index_2 ] ],
-                       bg_data_ [ cr . bg_index ] ) ) {
-      mgccp_uf . Union ( cr . parameter_index_1, cr . parameter_index_2 );
+  //std::cout << "Database::postprocess Process clutching in parallel and create union-find\n";
+  ConcurrentIntegerUnionFind mgccp_uf ( N );
+  BOOST_FOREACH ( const MGCCP_Record & mgccp_record, MGCCP_Records () ) {
+    BOOST_FOREACH ( ParameterIndex pi, mgccp_record . parameter_indices ) {
+      mgccp_uf . Union ( mgccp_record . parameter_indices [ 0 ], pi );
     }
   }
+  parallelFor ( 0, num_clutch_records, 1024, threads,
+                [&] ( uint64_t begin, uint64_t end, int ) {
+    for ( uint64_t r = begin; r < end; ++ r ) {
+      if ( not valid_clutching [ r ] ) continue;
+      const ClutchingRecord & cr = clutch_records_ [ r ];
+      if ( is_identity ( morsegraph_data_ [ param_to_mgr [ cr . parameter_index_1 ] ], 
+                         morsegraph_data_ [ param_to_mgr [ cr . parameter_index_2 ] ],
+                         bg_data_ [ cr . bg_index ] ) ) {
+        mgccp_uf . Union ( cr . parameter_index_1, cr . parameter_index_2 );
+      }
+    }
+  });
+
+  // Set aside the classes of an earlier postprocess; they seed the
+  // union-find structures below
+  std::vector < MGCCP_Record > old_mgccp_records;
+  std::vector < INCCP_Record > old_inccp_records;
+  std::vector < MGCC_Record > old_mgcc_records;
+  std::vector < INCC_Record > old_incc_records;
+  old_mgccp_records . swap ( MGCCP_records_ );
+  old_inccp_records . swap ( INCCP_records_ );
+  old_mgcc_records . swap ( MGCC_records_ );
+  old_incc_records . swap ( INCC_records_ );
+  inccp_index_ . clear ();
+  pb_to_mgccp_ . clear ();
+  mgccp_to_mgcc_ . clear ();
+  inccp_to_incc_ . clear ();
+  incc_to_mgcc_ . clear ();
+  mgcc_sizes_ . clear ();
+  incc_sizes_ . clear ();
+  mgcc_nb_ . clear ();
 
   // Now we use the union-find structure mgccp_uf to make
   // "Morse Graph Continuation Class Pieces"
@@ -962,11 +1365,14 @@ inline void Database::postprocess ( void ) {
       pb_to_mgccp_ [ pi ] = mgccp_index;
     }
   }
+  std::vector < uint64_t > old_to_new_mgccp ( old_mgccp_records . size () );
+  for ( uint64_t i = 0; i < old_mgccp_records . size (); ++ i ) {
+    old_to_new_mgccp [ i ] = pb_to_mgccp_ [ old_mgccp_records [ i ] . parameter_indices [ 0 ] ];
+  }
 
   // Create singleton INCCP records regardless of continuation
   //std::cout << "Database::postprocess create INCCP \n";
 
-  ContiguousIntegerUnionFind incc_uf;
   for ( uint64_t mgccp_index = 0; mgccp_index < MGCCP_Records () . size (); ++ mgccp_index ) {
     const MGCCP_Record & mgccp_record = MGCCP_Records () [ mgccp_index ];
     const MorseGraphRecord & mgr = morsegraphData() [ mgccp_record . morsegraph_index ];
@@ -987,108 +1393,184 @@ inline void Database::postprocess ( void ) {
       if ( inccp_index_ . count ( inccp_record ) == 0 ) {
           inccp_index_ [ inccp_record ] = INCCP_records_ . size ();
           INCCP_records_ . push_back ( inccp_record );
-          incc_uf . MakeSet ();
       }
     }
   }
-  // Process the clutching records sequentially, and create a union-find
-  // structure on MGCC pieces. Also, analyze the bipartite graph
-  // connected components to create INCCPs
-  //std::cout << "Database::postprocess create mgcc_uf\n";
 
+  // Seed the union-find structures on MGCC pieces and INCC pieces
+  // with the classes of an earlier postprocess
   ContiguousIntegerUnionFind mgcc_uf ( MGCCP_records_ . size () );
-  BOOST_FOREACH ( const ClutchingRecord & cr, clutch_records () ) {
-    if ( param_to_mgr [ cr . parameter_index_1 ] == -1 ||
-        param_to_mgr [ cr . parameter_index_2 ] == -1 ) {
-      std::cerr << "Warning: database has invalid clutching records.\n";
-      continue;
+  BOOST_FOREACH ( const MGCC_Record & mgcc_record, old_mgcc_records ) {
+    BOOST_FOREACH ( uint64_t mgccp_index, mgcc_record . mgccp_indices ) {
+      mgcc_uf . Union ( old_to_new_mgccp [ mgcc_record . mgccp_indices [ 0 ] ],
+                        old_to_new_mgccp [ mgccp_index ] );
     }
-    uint64_t mgccp1 = pb_to_mgccp_ [ cr . parameter_index_1 ];
-    uint64_t mgccp2 = pb_to_mgccp_ [ cr . parameter_index_2 ];
-
-    const MorseGraphRecord & mgr1 = morsegraph_data_ [ param_to_mgr [ cr . parameter_index_1 ] ];
-    const MorseGraphRecord & mgr2 = morsegraph_data_ [ param_to_mgr [ cr . parameter_index_2 ] ];
+  }
+  ConcurrentIntegerUnionFind incc_uf_pieces ( INCCP_records_ . size () );
+  std::vector < uint64_t > old_to_new_inccp ( old_inccp_records . size (), INCCP_records_ . size () );
+  for ( uint64_t i = 0; i < old_inccp_records . size (); ++ i ) {
+    INCCP_Record inccp_record = old_inccp_records [ i ];
+    inccp_record . mgccp_index = old_to_new_mgccp [ inccp_record . mgccp_index ];
+    old_to_new_inccp [ i ] = inccpIndex ( inccp_record );
+  }
+  BOOST_FOREACH ( const INCC_Record & incc_record, old_incc_records ) {
+    BOOST_FOREACH ( uint64_t inccp_index, incc_record . inccp_indices ) {
+      uint64_t first = old_to_new_inccp [ incc_record . inccp_indices [ 0 ] ];
+      uint64_t other = old_to_new_inccp [ inccp_index ];
+      if ( first == INCCP_records_ . size () || other == INCCP_records_ . size () ) continue;
+      incc_uf_pieces . Union ( first, other );
+    }
+  }
 
-    BG_Data & bg = bg_data_ [ cr . bg_index ];
+  // Classify the clutching records between different MGCC pieces in
+  // parallel (the isomorphism checks are the expensive part)
+  //std::cout << "Database::postprocess classify clutching records\n";
+  std::vector < char > isomorphic ( num_clutch_records, 0 );
+  parallelFor ( 0, num_clutch_records, 1024, threads,
+                [&] ( uint64_t begin, uint64_t end, int ) {
+    for ( uint64_t r = begin; r < end; ++ r ) {
+      if ( not valid_clutching [ r ] ) continue;
+      const ClutchingRecord & cr = clutch_records_ [ r ];
+      if ( pb_to_mgccp_ [ cr . parameter_index_1 ] == pb_to_mgccp_ [ cr . parameter_index_2 ] ) continue;
+      isomorphic [ r ] = is_isomorphism ( morsegraph_data_ [ param_to_mgr [ cr . parameter_index_1 ] ],
+                                          morsegraph_data_ [ param_to_mgr [ cr . parameter_index_2 ] ],
+                                          bg_data_ [ cr . bg_index ] );
+    }
+  });
 
+  // Process the clutching records sequentially to create the union-find
+  // structure on MGCC pieces. A record joining pieces which earlier records
+  // already joined is not analyzed further, so this pass is sequential.
+  //std::cout << "Database::postprocess create mgcc_uf\n";
+  std::vector < char > analyze ( num_clutch_records, 0 );
+  for ( uint64_t r = 0; r < num_clutch_records; ++ r ) {
+    if ( not valid_clutching [ r ] ) continue;
+    const ClutchingRecord & cr = clutch_records_ [ r ];
+    uint64_t mgccp1 = pb_to_mgccp_ [ cr . parameter_index_1 ];
+    uint64_t mgccp2 = pb_to_mgccp_ [ cr . parameter_index_2 ];
     if ( mgcc_uf . Find ( mgccp1 ) == mgcc_uf . Find ( mgccp2 ) ) continue;
-    if ( is_isomorphism ( mgr1, mgr2, bg ) ) {
-      mgcc_uf . Union ( mgccp1, mgccp2 );
-    }
-    // Analyze ClutchingRecord
-    // (1) Generate a list of pairs of convex sets which are matched by the BG
-    const DAG_Data & dag1 = dag_data_ [ mgr1 . dag_index ];
-    const DAG_Data & dag2 = dag_data_ [ mgr2 . dag_index ];
-    ContiguousIntegerUnionFind bg_connected_components ( dag1 . num_vertices + dag2 . num_vertices );
-    typedef std::pair < int, int > Edge;
-    BOOST_FOREACH ( Edge & edge, bg . edges ) {
-      bg_connected_components . Union ( edge . first, edge . second + dag1 . num_vertices );
-    }
-    std::vector < std::vector < uint64_t > > bg_components = bg_connected_components . Components ();
-    std::vector < std::vector < uint64_t > > dag1_components ( bg_components . size () );
-    std::vector < std::vector < uint64_t > > dag2_components ( bg_components . size () );
-    for ( uint64_t i = 0; i < bg_components . size (); ++ i ) {
-      BOOST_FOREACH ( uint64_t x, bg_components [ i ] ) {
-        if ( x < (uint64_t) dag1 . num_vertices ) dag1_components [ i ] . push_back ( x );
-        else dag2_components [ i ] . push_back ( x - dag1 . num_vertices );
+    if ( isomorphic [ r ] ) mgcc_uf . Union ( mgccp1, mgccp2 );
+    analyze [ r ] = 1;
+  }
+
+  // Analyze the bipartite graph connected components of the remaining
+  // records in parallel to join INCCPs. Pairs whose convex set or INCCP
+  // is not there yet are put off, and handled in record order below.
+  //std::cout << "Database::postprocess analyze clutching records\n";
+  struct PendingPair {
+    uint64_t record;
+    uint64_t v1;
+    uint64_t v2;
+    bool operator < ( const PendingPair & rhs ) const { return record < rhs . record; }
+  };
+  std::vector < std::vector < PendingPair > > pending_by_thread ( threads );
+  parallelFor ( 0, num_clutch_records, 256, threads,
+                [&] ( uint64_t begin, uint64_t end, int thread_id ) {
+    for ( uint64_t r = begin; r < end; ++ r ) {
+      if ( not analyze [ r ] ) continue;
+      const ClutchingRecord & cr = clutch_records_ [ r ];
+      uint64_t mgccp1 = pb_to_mgccp_ [ cr . parameter_index_1 ];
+      uint64_t mgccp2 = pb_to_mgccp_ [ cr . parameter_index_2 ];
+      const MorseGraphRecord & mgr1 = morsegraph_data_ [ param_to_mgr [ cr . parameter_index_1 ] ];
+      const MorseGraphRecord & mgr2 = morsegraph_data_ [ param_to_mgr [ cr . parameter_index_2 ] ];
+      const BG_Data & bg = bg_data_ [ cr . bg_index ];
+      // Analyze ClutchingRecord
+      // (1) Generate a list of pairs of convex sets which are matched by the BG
+      const DAG_Data & dag1 = dag_data_ [ mgr1 . dag_index ];
+      const DAG_Data & dag2 = dag_data_ [ mgr2 . dag_index ];
+      ContiguousIntegerUnionFind bg_connected_components ( dag1 . num_vertices + dag2 . num_vertices );
+      typedef std::pair < int, int > Edge;
+      BOOST_FOREACH ( const Edge & edge, bg . edges ) {
+        bg_connected_components . Union ( edge . first, edge . second + dag1 . num_vertices );
       }
-      std::sort ( dag1_components [ i ] . begin (), dag1_components [ i ] . end () );
-      std::sort ( dag2_components [ i ] . begin (), dag2_components [ i ] . end () );
-      // HANDLE INCCP AND INCC_UF
-      // For now use singleton condition, but write as if you were doing it more generally
-      if ( dag1_components [ i ] . size () == 1 &&
-           dag2_components [ i ] . size () == 1 ) {
-        // Produce Convex Set Data records if necessary
+      std::vector < std::vector < uint64_t > > bg_components = bg_connected_components . Components ();
+      for ( uint64_t i = 0; i < bg_components . size (); ++ i ) {
+        std::vector < uint64_t > dag1_component, dag2_component;
+        BOOST_FOREACH ( uint64_t x, bg_components [ i ] ) {
+          if ( x < (uint64_t) dag1 . num_vertices ) dag1_component . push_back ( x );
+          else dag2_component . push_back ( x - dag1 . num_vertices );
+        }
+        // HANDLE INCCP AND INCC_UF
+        // For now use singleton condition, but write as if you were doing it more generally
+        if ( dag1_component . size () != 1 || dag2_component . size () != 1 ) continue;
+        uint64_t v1 = dag1_component [ 0 ];
+        uint64_t v2 = dag2_component [ 0 ];
+        INCCP_Record inccp1, inccp2;
         CS_Data cs1, cs2;
-        BOOST_FOREACH ( uint64_t x, dag1_components [ i ] ) cs1 . vertices . push_back ( x );
-        BOOST_FOREACH ( uint64_t x, dag2_components [ i ] ) cs2 . vertices . push_back ( x );
-        
-        uint64_t cs1_index = insert ( cs1 );
-        uint64_t cs2_index = insert ( cs2 );
-
+        cs1 . vertices . push_back ( v1 );
+        cs2 . vertices . push_back ( v2 );
+        inccp1 . cs_index = csIndex ( cs1 );
+        inccp2 . cs_index = csIndex ( cs2 );
+        inccp1 . mgccp_index = mgccp1;
+        inccp2 . mgccp_index = mgccp2;
+        uint64_t inccp1_index = inccpIndex ( inccp1 );
+        uint64_t inccp2_index = inccpIndex ( inccp2 );
+        if ( inccp1_index == INCCP_records_ . size () || inccp2_index == INCCP_records_ . size () ) {
+          PendingPair pending = { r, v1, v2 };
+          pending_by_thread [ thread_id ] . push_back ( pending );
+          continue;
+        }
         // Check if annotations match (continue if they do not)
         // WARNING, USES SINGLETON ASSUMPTION
-        uint64_t v1 = * dag1_components [ i ] . begin ();
-        uint64_t v2 = * dag2_components [ i ] . begin ();
         if ( mgr1.annotation_index_by_vertex[v1] 
              != mgr2.annotation_index_by_vertex[v2] ) continue;
         // END ANNOTATION MATCHING
-
-        // Produce INCCP Records if necessary
-        INCCP_Record inccp1, inccp2;
-        inccp1 . cs_index = cs1_index;
-        inccp1 . mgccp_index = mgccp1;
-        inccp2 . cs_index = cs2_index;
-        inccp2 . mgccp_index = mgccp2;
-
-        if ( inccp_index_ . count ( inccp1 ) == 0 ) {
-          inccp_index_ [ inccp1 ] = INCCP_records_ . size ();
-          INCCP_records_ . push_back ( inccp1 );
-          incc_uf . MakeSet ();
-        }
-        if ( inccp_index_ . count ( inccp2 ) == 0 ) {
-          inccp_index_ [ inccp2 ] = INCCP_records_ . size ();
-          INCCP_records_ . push_back ( inccp2 );
-          incc_uf . MakeSet ();
-        }
-        // Call Union operation
-        uint64_t inccp1_index = inccp_index_ [ inccp1 ];
-        uint64_t inccp2_index = inccp_index_ [ inccp2 ];
-        incc_uf . Union ( inccp1_index, inccp2_index );
+        incc_uf_pieces . Union ( inccp1_index, inccp2_index );
       }
     }
-    /* TODO: Deal with non-trivial convex sets (bigger than singletons)
-    std::unordered_map < uint64_t, uint64_t > dag_to_cs1;
-    std::unordered_map < uint64_t, uint64_t > dag_to_cs2;
-    std::unordered_map < uint64_t, uint64_t > rep_to_cs
-    for ( uint64_t i = 0; i < dag1 . num_vertices; ++ i ) {
-      dag_to_cs1 [ i ] = bg_connected_components . Find ( i );
+  });
+
+  ContiguousIntegerUnionFind incc_uf ( INCCP_records_ . size () );
+  for ( uint64_t i = 0; i < INCCP_records_ . size (); ++ i ) {
+    incc_uf . Union ( i, incc_uf_pieces . Find ( i ) );
+  }
+  std::vector < PendingPair > pending;
+  BOOST_FOREACH ( const std::vector < PendingPair > & thread_pending, pending_by_thread ) {
+    pending . insert ( pending . end (), thread_pending . begin (), thread_pending . end () );
+  }
+  std::stable_sort ( pending . begin (), pending . end () );
+  BOOST_FOREACH ( const PendingPair & pair, pending ) {
+    const ClutchingRecord & cr = clutch_records_ [ pair . record ];
+    const MorseGraphRecord & mgr1 = morsegraph_data_ [ param_to_mgr [ cr . parameter_index_1 ] ];
+    const MorseGraphRecord & mgr2 = morsegraph_data_ [ param_to_mgr [ cr . parameter_index_2 ] ];
+    // Produce Convex Set Data records if necessary
+    CS_Data cs1, cs2;
+    cs1 . vertices . push_back ( pair . v1 );
+    cs2 . vertices . push_back ( pair . v2 );
+    uint64_t cs1_index = insert ( cs1 );
+    uint64_t cs2_index = insert ( cs2 );
+    if ( mgr1.annotation_index_by_vertex[pair . v1] 
+         != mgr2.annotation_index_by_vertex[pair . v2] ) continue;
+    // Produce INCCP Records if necessary
+    INCCP_Record inccp1, inccp2;
+    inccp1 . cs_index = cs1_index;
+    inccp1 . mgccp_index = pb_to_mgccp_ [ cr . parameter_index_1 ];
+    inccp2 . cs_index = cs2_index;
+    inccp2 . mgccp_index = pb_to_mgccp_ [ cr . parameter_index_2 ];
+    if ( inccp_index_ . count ( inccp1 ) == 0 ) {
+      inccp_index_ [ inccp1 ] = INCCP_records_ . size ();
+      INCCP_records_ . push_back ( inccp1 );
+      incc_uf . MakeSet ();
+    }
+    if ( inccp_index_ . count ( inccp2 ) == 0 ) {
+      inccp_index_ [ inccp2 ] = INCCP_records_ . size ();
+      INCCP_records_ . push_back ( inccp2 );
+      incc_uf . MakeSet ();
     }
-    for ( uint64_t i = 0; i < dag2 . num_vertices; ++ i ) {
-      dag_to_cs2 [ i ] = bg_connected_components . Find ( i + dag1 . num_vertices );
-    }  
-    */
+    // Call Union operation
+    incc_uf . Union ( inccp_index_ [ inccp1 ], inccp_index_ [ inccp2 ] );
+  }
+  /* TODO: Deal with non-trivial convex sets (bigger than singletons)
+  std::unordered_map < uint64_t, uint64_t > dag_to_cs1;
+  std::unordered_map < uint64_t, uint64_t > dag_to_cs2;
+  std::unordered_map < uint64_t, uint64_t > rep_to_cs
+  for ( uint64_t i = 0; i < dag1 . num_vertices; ++ i ) {
+    dag_to_cs1 [ i ] = bg_connected_components . Find ( i );
+  }
+  for ( uint64_t i = 0; i < dag2 . num_vertices; ++ i ) {
+    dag_to_cs2 [ i ] = bg_connected_components . Find ( i + dag1 . num_vertices );
   }  
+  */
 
   // Now we use the union-find structure on MGCC Pieces to create the MGCC records
   std::vector < std::vector < uint64_t > > mgcc_components = mgcc_uf . Components ();
@@ -1141,38 +1623,63 @@ inline void Database::postprocess ( void ) {
 
 
   // calculate correct smallest_reps field for INCC_Records
-  BOOST_FOREACH ( const ParameterRecord & pr, parameter_records () ) {
-    ParameterIndex pi = pr . parameter_index;
-    uint64_t morsegraph_index = pr . morsegraph_index;
-    const MorseGraphRecord & mgr = morsegraphData() [ morsegraph_index ];
-    uint64_t mgccp_index = pb_to_mgccp_ [ pi ];
-    // Iterate through INCCP records associated with MGCCP 
-    //   (unforunately this is complicated)
-    uint64_t n = dagData()[ mgr . dag_index] . num_vertices;
-    for ( uint64_t i = 0; i < n; ++ i ) {
-      CS_Data cs;
-      cs . vertices . push_back ( i );
-      if ( cs_index_ . count ( cs ) == 0 ) {
-        cs_index_ [ cs ] = cs_data_ . size ();
-        cs_data_ . push_back ( cs );
-      }
-      uint64_t cs_index = cs_index_ [ cs ];
-      INCCP_Record inccp_record;
-      inccp_record . cs_index = cs_index;
-      inccp_record . mgccp_index = mgccp_index;
-      // Fetch INCC associated with INCCP
-      uint64_t inccp_index = inccp_index_ [ inccp_record ];
-      uint64_t incc_index = inccp_to_incc_ [ inccp_index ];
-      INCC_Record & incc_record = INCC_records_ [ incc_index ];
-      uint64_t morseset_size = pr . morseset_sizes [ i ];
-      incc_record . smallest_reps . 
-        insert ( std::make_pair ( morseset_size, std::make_pair ( pi, i ) ) );
-      // UNIMPLEMENTED FEATURE: make number of smallest reps held configurable
-      if ( incc_record . smallest_reps . size () > 16 ) {
-        incc_record . smallest_reps . erase ( * incc_record . smallest_reps . rbegin () );
-      }
+  // (the smallest reps of a class are the smallest of those of its
+  //  pieces, so the order of insertion does not matter)
+  typedef std::pair<uint64_t,std::pair<uint64_t,uint64_t> > Representative;
+  const uint64_t num_locks = 64;
+  std::vector < boost::mutex > incc_locks ( num_locks );
+  auto add_representative = [&] ( uint64_t incc_index, const Representative & rep ) {
+    boost::lock_guard < boost::mutex > lock ( incc_locks [ incc_index % num_locks ] );
+    INCC_Record & incc_record = INCC_records_ [ incc_index ];
+    incc_record . smallest_reps . insert ( rep );
+    // UNIMPLEMENTED FEATURE: make number of smallest reps held configurable
+    if ( incc_record . smallest_reps . size () > 16 ) {
+      incc_record . smallest_reps . erase ( * incc_record . smallest_reps . rbegin () );
+    }
+  };
+  for ( uint64_t i = 0; i < old_incc_records . size (); ++ i ) {
+    uint64_t inccp_index = old_to_new_inccp [ old_incc_records [ i ] . inccp_indices [ 0 ] ];
+    if ( inccp_index == INCCP_records_ . size () ) continue;
+    BOOST_FOREACH ( const Representative & rep, old_incc_records [ i ] . smallest_reps ) {
+      add_representative ( inccp_to_incc_ [ inccp_index ], rep );
     }
   }
+  std::vector < uint64_t > singleton_cs;
+  for ( uint64_t i = 0; i < cs_data_ . size (); ++ i ) {
+    if ( cs_data_ [ i ] . vertices . size () != 1 ) continue;
+    uint64_t v = cs_data_ [ i ] . vertices [ 0 ];
+    if ( singleton_cs . size () <= v ) singleton_cs . resize ( v + 1, cs_data_ . size () );
+    singleton_cs [ v ] = i;
+  }
+  parallelFor ( 0, parameter_records_ . size (), 256, threads,
+                [&] ( uint64_t begin, uint64_t end, int ) {
+    for ( uint64_t r = begin; r < end; ++ r ) {
+      const ParameterRecord & pr = parameter_records_ [ r ];
+      ParameterIndex pi = pr . parameter_index;
+      uint64_t morsegraph_index = pr . morsegraph_index;
+      const MorseGraphRecord & mgr = morsegraphData() [ morsegraph_index ];
+      uint64_t mgccp_index = pb_to_mgccp_ [ pi ];
+      // Iterate through INCCP records associated with MGCCP 
+      //   (unforunately this is complicated)
+      uint64_t n = dagData()[ mgr . dag_index] . num_vertices;
+      for ( uint64_t i = 0; i < n; ++ i ) {
+        // The singleton INCCPs of every MGCCP were made above
+        INCCP_Record inccp_record;
+        inccp_record . cs_index = i < singleton_cs . size () ? singleton_cs [ i ] : 0;
+        inccp_record . mgccp_index = mgccp_index;
+        // Fetch INCC associated with INCCP
+        std::unordered_map < INCCP_Record, uint64_t, boost::hash<INCCP_Record> >::const_iterator
+          it = i < singleton_cs . size () ? inccp_index_ . find ( inccp_record ) : inccp_index_ . end ();
+        if ( it == inccp_index_ . end () ) {
+          throw std::logic_error ( "Database::postprocess. Missing singleton INCCP\n" );
+        }
+        uint64_t inccp_index = it -> second;
+        uint64_t incc_index = inccp_to_incc_ [ inccp_index ];
+        uint64_t morseset_size = pr . morseset_sizes [ i ];
+        add_representative ( incc_index, std::make_pair ( morseset_size, std::make_pair ( pi, i ) ) );
+      }
+    }
+  });
 
 
   
@@ -1265,6 +1772,7 @@ inline void Database::makeAttractorsMinimal ( void ) {
 
 inline void Database::performTransitiveReductions ( void ) {
   // tricky part: to update the dags, we need to update the lookup table too
+  index ( DAG_INDEX );
   for ( uint64_t dag_index = 0; dag_index < dag_data_ . size (); ++ dag_index ) {
     DAG_Data & dag = dag_data_ [ dag_index ];
     dag_index_ . erase ( dag );
@@ -1305,6 +1813,11 @@ inline const std::vector < INCC_Record > & Database::INCC_Records ( void ) const
 
 // file operations
 inline void Database::save ( const char * filename ) {
+  std::cout << "Database SAVE\n";
+  saveColumns ( filename );
+}
+
+inline void Database::saveArchive ( const char * filename ) {
   std::cout << "Database SAVE\n";
   std::ofstream ofs(filename);
   assert(ofs.good());
@@ -1322,6 +1835,11 @@ inline void Database::load ( const char * filename ) {
     std::cout << "Could not load " << filename << "\n";
     exit ( 1 );
   }
+  if ( ColumnReader::isColumnFile ( filename ) ) {
+    ifs . close ();
+    loadColumns ( filename );
+    return;
+  }
 
   boost::archive::binary_iarchive ia(ifs);
       //boost::archive::text_iarchive ia(ifs);
@@ -1331,4 +1849,215 @@ inline void Database::load ( const char * filename ) {
       //ifs . close ();
 }
 
+inline void Database::saveColumns ( const char * filename ) {
+  typedef std::pair<int,int> Edge;
+  ColumnWriter file;
+  file . open ( filename );
+  // parameter space
+  std::string space_bytes;
+  if ( parameter_space_ ) {
+    std::ostringstream buffer;
+    {
+      boost::archive::binary_oarchive oa ( buffer );
+      oa << parameter_space_;
+    }
+    space_bytes = buffer . str ();
+  }
+  file . write ( "space", space_bytes . data (), space_bytes . size () );
+  // data
+  file . writeRows<char> ( "str", string_data_ . size (),
+    [&] ( uint64_t i, std::vector<char> * row ) {
+      row -> assign ( string_data_ [ i ] . begin (), string_data_ [ i ] . end () ); } );
+  file . writeRows<uint64_t> ( "ann", annotation_data_ . size (),
+    [&] ( uint64_t i, std::vector<uint64_t> * row ) {
+      const std::set<uint64_t> & indices = annotation_data_ [ i ] . string_indices;
+      row -> assign ( indices . begin (), indices . end () ); } );
+  file . writeColumn<uint64_t> ( "mg.dag", morsegraph_data_ . size (),
+    [&] ( uint64_t i ) { return morsegraph_data_ [ i ] . dag_index; } );
+  file . writeColumn<uint64_t> ( "mg.ann", morsegraph_data_ . size (),
+    [&] ( uint64_t i ) { return morsegraph_data_ [ i ] . annotation_index; } );
+  file . writeRows<uint64_t> ( "mg.abv", morsegraph_data_ . size (),
+    [&] ( uint64_t i, std::vector<uint64_t> * row ) {
+      * row = morsegraph_data_ [ i ] . annotation_index_by_vertex; } );
+  file . writeColumn<int32_t> ( "dag.n", dag_data_ . size (),
+    [&] ( uint64_t i ) { return (int32_t) dag_data_ [ i ] . num_vertices; } );
+  file . writeRows<int32_t> ( "dag.po", dag_data_ . size (),
+    [&] ( uint64_t i, std::vector<int32_t> * row ) {
+      BOOST_FOREACH ( const Edge & e, dag_data_ [ i ] . partial_order ) {
+        row -> push_back ( e . first );
+        row -> push_back ( e . second );
+      } } );
+  file . writeRows<int32_t> ( "bg.e", bg_data_ . size (),
+    [&] ( uint64_t i, std::vector<int32_t> * row ) {
+      BOOST_FOREACH ( const Edge & e, bg_data_ [ i ] . edges ) {
+        row -> push_back ( e . first );
+        row -> push_back ( e . second );
+      } } );
+  file . writeRows<int32_t> ( "cs.v", cs_data_ . size (),
+    [&] ( uint64_t i, std::vector<int32_t> * row ) {
+      row -> assign ( cs_data_ [ i ] . vertices . begin (), cs_data_ [ i ] . vertices . end () ); } );
+  std::vector<const std::string *> ci_strings;
+  std::vector<uint64_t> ci_offsets ( 1, 0 );
+  BOOST_FOREACH ( const CI_Data & ci, ci_data_ ) {
+    BOOST_FOREACH ( const std::string & s, ci . conley_index ) ci_strings . push_back ( & s );
+    ci_offsets . push_back ( ci_strings . size () );
+  }
+  file . write ( "ci.o", ci_offsets );
+  file . writeRows<char> ( "ci.str", ci_strings . size (),
+    [&] ( uint64_t i, std::vector<char> * row ) {
+      row -> assign ( ci_strings [ i ] -> begin (), ci_strings [ i ] -> end () ); } );
+  // raw records
+  file . writeColumn<uint64_t> ( "pr.pi", parameter_records_ . size (),
+    [&] ( uint64_t i ) { return parameter_records_ [ i ] . parameter_index; } );
+  file . writeColumn<uint64_t> ( "pr.mg", parameter_records_ . size (),
+    [&] ( uint64_t i ) { return parameter_records_ [ i ] . morsegraph_index; } );
+  file . writeRows<uint64_t> ( "pr.mss", parameter_records_ . size (),
+    [&] ( uint64_t i, std::vector<uint64_t> * row ) {
+      * row = parameter_records_ [ i ] . morseset_sizes; } );
+  file . writeColumn<uint64_t> ( "cr.pi1", clutch_records_ . size (),
+    [&] ( uint64_t i ) { return clutch_records_ [ i ] . parameter_index_1; } );
+  file . writeColumn<uint64_t> ( "cr.pi2", clutch_records_ . size (),
+    [&] ( uint64_t i ) { return clutch_records_ [ i ] . parameter_index_2; } );
+  file . writeColumn<uint64_t> ( "cr.bg", clutch_records_ . size (),
+    [&] ( uint64_t i ) { return clutch_records_ [ i ] . bg_index; } );
+  // continuation records
+  file . writeColumn<uint64_t> ( "mgccp.mg", MGCCP_records_ . size (),
+    [&] ( uint64_t i ) { return MGCCP_records_ [ i ] . morsegraph_index; } );
+  file . writeRows<uint64_t> ( "mgccp.pi", MGCCP_records_ . size (),
+    [&] ( uint64_t i, std::vector<uint64_t> * row ) {
+      * row = MGCCP_records_ [ i ] . parameter_indices; } );
+  file . writeColumn<uint64_t> ( "inccp.cs", INCCP_records_ . size (),
+    [&] ( uint64_t i ) { return INCCP_records_ [ i ] . cs_index; } );
+  file . writeColumn<uint64_t> ( "inccp.mgccp", INCCP_records_ . size (),
+    [&] ( uint64_t i ) { return INCCP_records_ [ i ] . mgccp_index; } );
+  file . writeRows<uint64_t> ( "mgcc.mgccp", MGCC_records_ . size (),
+    [&] ( uint64_t i, std::vector<uint64_t> * row ) {
+      * row = MGCC_records_ [ i ] . mgccp_indices; } );
+  file . writeRows<uint64_t> ( "incc.inccp", INCC_records_ . size (),
+    [&] ( uint64_t i, std::vector<uint64_t> * row ) {
+      * row = INCC_records_ [ i ] . inccp_indices; } );
+  file . writeRows<uint64_t> ( "incc.rep", INCC_records_ . size (),
+    [&] ( uint64_t i, std::vector<uint64_t> * row ) {
+      typedef std::pair<uint64_t,std::pair<uint64_t,uint64_t> > Rep;
+      BOOST_FOREACH ( const Rep & rep, INCC_records_ [ i ] . smallest_reps ) {
+        row -> push_back ( rep . first );
+        row -> push_back ( rep . second . first );
+        row -> push_back ( rep . second . second );
+      } } );
+  // lookup tables
+  file . write ( "pb_to_mgccp", pb_to_mgccp_ );
+  file . write ( "mgccp_to_mgcc", mgccp_to_mgcc_ );
+  file . write ( "inccp_to_incc", inccp_to_incc_ );
+  file . write ( "mgcc_sizes", mgcc_sizes_ );
+  file . write ( "incc_sizes", incc_sizes_ );
+  file . write ( "incc_conley", incc_conley_ );
+  file . writeRows<uint64_t> ( "incc_to_mgcc", incc_to_mgcc_ . size (),
+    [&] ( uint64_t i, std::vector<uint64_t> * row ) {
+      row -> assign ( incc_to_mgcc_ [ i ] . begin (), incc_to_mgcc_ [ i ] . end () );
+      std::sort ( row -> begin (), row -> end () ); } );
+  file . writeRows<uint64_t> ( "mgcc_nb", mgcc_nb_ . size (),
+    [&] ( uint64_t i, std::vector<uint64_t> * row ) {
+      row -> assign ( mgcc_nb_ [ i ] . begin (), mgcc_nb_ [ i ] . end () );
+      std::sort ( row -> begin (), row -> end () ); } );
+  file . close ();
+}
+
+inline void Database::loadColumns ( const char * filename ) {
+  DatabaseFile file;
+  file . open ( filename );
+  * this = Database ();
+  parameter_space_ = file . parameterSpace ();
+  // data
+  string_data_ . reserve ( file . numStrings () );
+  for ( uint64_t i = 0; i < file . numStrings (); ++ i ) string_data_ . push_back ( file . string ( i ) );
+  annotation_data_ . reserve ( file . numAnnotations () );
+  for ( uint64_t i = 0; i < file . numAnnotations (); ++ i ) annotation_data_ . push_back ( file . annotation ( i ) );
+  morsegraph_data_ . reserve ( file . numMorseGraphs () );
+  for ( uint64_t i = 0; i < file . numMorseGraphs (); ++ i ) morsegraph_data_ . push_back ( file . morsegraph ( i ) );
+  dag_data_ . reserve ( file . numDAGs () );
+  for ( uint64_t i = 0; i < file . numDAGs (); ++ i ) dag_data_ . push_back ( file . dag ( i ) );
+  bg_data_ . reserve ( file . numBGs () );
+  for ( uint64_t i = 0; i < file . numBGs (); ++ i ) bg_data_ . push_back ( file . bg ( i ) );
+  cs_data_ . reserve ( file . numCSs () );
+  for ( uint64_t i = 0; i < file . numCSs (); ++ i ) cs_data_ . push_back ( file . cs ( i ) );
+  ci_data_ . reserve ( file . numCIs () );
+  for ( uint64_t i = 0; i < file . numCIs (); ++ i ) ci_data_ . push_back ( file . ci ( i ) );
+  // records
+  parameter_records_ . reserve ( file . numParameterRecords () );
+  for ( uint64_t i = 0; i < file . numParameterRecords (); ++ i ) parameter_records_ . push_back ( file . parameterRecord ( i ) );
+  clutch_records_ . reserve ( file . numClutchRecords () );
+  for ( uint64_t i = 0; i < file . numClutchRecords (); ++ i ) clutch_records_ . push_back ( file . clutchRecord ( i ) );
+  MGCCP_records_ . reserve ( file . numMGCCPs () );
+  for ( uint64_t i = 0; i < file . numMGCCPs (); ++ i ) MGCCP_records_ . push_back ( file . MGCCP ( i ) );
+  INCCP_records_ . reserve ( file . numINCCPs () );
+  for ( uint64_t i = 0; i < file . numINCCPs (); ++ i ) INCCP_records_ . push_back ( file . INCCP ( i ) );
+  MGCC_records_ . reserve ( file . numMGCCs () );
+  for ( uint64_t i = 0; i < file . numMGCCs (); ++ i ) MGCC_records_ . push_back ( file . MGCC ( i ) );
+  INCC_records_ . reserve ( file . numINCCs () );
+  for ( uint64_t i = 0; i < file . numINCCs (); ++ i ) INCC_records_ . push_back ( file . INCC ( i ) );
+  // lookup tables
+  Column<uint64_t> column;
+  column = file . pb_to_mgccp (); pb_to_mgccp_ . assign ( column . begin (), column . end () );
+  column = file . mgccp_to_mgcc (); mgccp_to_mgcc_ . assign ( column . begin (), column . end () );
+  column = file . inccp_to_incc (); inccp_to_incc_ . assign ( column . begin (), column . end () );
+  column = file . mgcc_sizes (); mgcc_sizes_ . assign ( column . begin (), column . end () );
+  column = file . incc_sizes (); incc_sizes_ . assign ( column . begin (), column . end () );
+  column = file . incc_conley (); incc_conley_ . assign ( column . begin (), column . end () );
+  Rows<uint64_t> rows = file . incc_to_mgcc ();
+  incc_to_mgcc_ . resize ( rows . size () );
+  for ( uint64_t i = 0; i < rows . size (); ++ i ) {
+    incc_to_mgcc_ [ i ] . insert ( rows [ i ] . begin (), rows [ i ] . end () );
+  }
+  rows = file . mgcc_nb ();
+  mgcc_nb_ . resize ( rows . size () );
+  for ( uint64_t i = 0; i < rows . size (); ++ i ) {
+    mgcc_nb_ [ i ] . insert ( rows [ i ] . begin (), rows [ i ] . end () );
+  }
+  // the hash indices are rebuilt when first needed
+  index_state_ . stale = ALL_INDICES;
+}
+
+// rebuild the stale indices among "which" from the data they index
+inline void Database::index ( int which ) const {
+  // Once an index is current it is only read; the first caller to find it
+  // stale rebuilds it while any others wait
+  if ( ( which & index_state_ . stale ) == 0 ) return;
+  boost::lock_guard<boost::mutex> lock ( index_state_ . mutex );
+  which &= index_state_ . stale;
+  if ( which == 0 ) return;
+  if ( which & STRING_INDEX ) {
+    string_index_ . clear ();
+    for ( uint64_t i = 0; i < string_data_ . size (); ++ i ) string_index_ [ string_data_ [ i ] ] = i;
+  }
+  if ( which & ANNOTATION_INDEX ) {
+    annotation_index_ . clear ();
+    for ( uint64_t i = 0; i < annotation_data_ . size (); ++ i ) annotation_index_ [ annotation_data_ [ i ] ] = i;
+  }
+  if ( which & MORSEGRAPH_INDEX ) {
+    morsegraph_index_ . clear ();
+    for ( uint64_t i = 0; i < morsegraph_data_ . size (); ++ i ) morsegraph_index_ [ morsegraph_data_ [ i ] ] = i;
+  }
+  if ( which & DAG_INDEX ) {
+    dag_index_ . clear ();
+    for ( uint64_t i = 0; i < dag_data_ . size (); ++ i ) dag_index_ [ dag_data_ [ i ] ] = i;
+  }
+  if ( which & BG_INDEX ) {
+    bg_index_ . clear ();
+    for ( uint64_t i = 0; i < bg_data_ . size (); ++ i ) bg_index_ [ bg_data_ [ i ] ] = i;
+  }
+  if ( which & CS_INDEX ) {
+    cs_index_ . clear ();
+    for ( uint64_t i = 0; i < cs_data_ . size (); ++ i ) cs_index_ [ cs_data_ [ i ] ] = i;
+  }
+  if ( which & CI_INDEX ) {
+    ci_index_ . clear ();
+    for ( uint64_t i = 0; i < ci_data_ . size (); ++ i ) ci_index_ [ ci_data_ [ i ] ] = i;
+  }
+  if ( which & INCCP_INDEX ) {
+    inccp_index_ . clear ();
+    for ( uint64_t i = 0; i < INCCP_records_ . size (); ++ i ) inccp_index_ [ INCCP_records_ [ i ] ] = i;
+  }
+  index_state_ . stale &= ~ which;
+}
+
 #endif
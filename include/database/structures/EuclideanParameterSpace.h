@@ -87,6 +87,13 @@ public:
 	///    and the edge between them.
 	virtual std::shared_ptr<ParameterPatch> patch ( void ) const;
 
+  /// countPatches
+  ///    Return the number of patches and the number of vertices in them.
+  ///    These are computed directly for a UniformGrid, without building
+  ///    the patches.
+  virtual void countPatches ( uint64_t * num_patches, 
+                              uint64_t * num_vertices ) const;
+
   /// dimension
   ///    Return dimension of parameter space
   int dimension ( void ) const;
@@ -97,6 +104,9 @@ public:
   grid ( void ) const;
 
 private:
+  // Interval covered in dimension d by patches with coordinate c
+  void patchInterval ( int d, int c, double * lower, double * upper ) const;
+
 	std::shared_ptr<Grid> parameter_grid_;
   RectGeo bounds_;
   std::vector<bool> periodic_;
@@ -266,24 +276,8 @@ EuclideanParameterSpace::patch ( void ) const {
   // Determine a rectangle based on "coordinates"
   RectGeo geo ( dimension_ );
   for ( int d = 0; d < dimension_; ++ d ) {
-	 // tol included for robustness
-  	double tol = (bounds_.upper_bounds[d] - bounds_.lower_bounds[d]) 
-                   /(double)(1000000000.0);
-    geo . lower_bounds [ d ] = 
-        bounds_.lower_bounds[d]+((double)coordinates_[d])*
-        (bounds_.upper_bounds[d]-bounds_.lower_bounds[d]) 
-        /(double)patches_across_[d] - tol;
-    geo . upper_bounds [ d ] = 
-        bounds_.lower_bounds[d]+((double)(1+coordinates_[d]))*
-        (bounds_.upper_bounds[d]-bounds_.lower_bounds[d])
-        /(double)patches_across_[d] + tol;
-      
-    if ( not periodic_ [ d ] ) {
-      if ( geo . lower_bounds [ d ] < bounds_ . lower_bounds [ d ] ) 
-        geo . lower_bounds [ d ] = bounds_ . lower_bounds [ d ];
-      if ( geo . upper_bounds [ d ] > bounds_. upper_bounds [ d ] ) 
-        geo . upper_bounds [ d ] = bounds_ . upper_bounds [ d ];
-    }
+    patchInterval ( d, coordinates_ [ d ], 
+                    & geo . lower_bounds [ d ], & geo . upper_bounds [ d ] );
   }
    
   //std::cout << "EuclideanParameterSpace::patch geo = " << geo << "\n";
@@ -330,6 +324,52 @@ EuclideanParameterSpace::patch ( void ) const {
 }
 
 
+inline void
+EuclideanParameterSpace::patchInterval ( int d, int c, double * lower, double * upper ) const {
+  // tol included for robustness
+  double tol = (bounds_.upper_bounds[d] - bounds_.lower_bounds[d]) 
+                 /(double)(1000000000.0);
+  * lower = bounds_.lower_bounds[d]+((double)c)*
+      (bounds_.upper_bounds[d]-bounds_.lower_bounds[d]) 
+      /(double)patches_across_[d] - tol;
+  * upper = bounds_.lower_bounds[d]+((double)(1+c))*
+      (bounds_.upper_bounds[d]-bounds_.lower_bounds[d])
+      /(double)patches_across_[d] + tol;
+  if ( not periodic_ [ d ] ) {
+    if ( * lower < bounds_ . lower_bounds [ d ] ) * lower = bounds_ . lower_bounds [ d ];
+    if ( * upper > bounds_ . upper_bounds [ d ] ) * upper = bounds_ . upper_bounds [ d ];
+  }
+}
+
+inline void
+EuclideanParameterSpace::countPatches ( uint64_t * num_patches, 
+                                        uint64_t * num_vertices ) const {
+#ifdef EDGEPATCHMETHOD
+  ParameterSpace::countPatches ( num_patches, num_vertices );
+#else
+  std::shared_ptr<const UniformGrid> grid = 
+    std::dynamic_pointer_cast<const UniformGrid> ( parameter_grid_ );
+  if ( not grid ) {
+    ParameterSpace::countPatches ( num_patches, num_vertices );
+    return;
+  }
+  // Both the patches and their covers are products over the dimensions
+  * num_patches = 1;
+  * num_vertices = 1;
+  for ( int d = 0; d < dimension_; ++ d ) {
+    uint64_t num_coordinates = 0;
+    for ( int c = 0; c < patches_across_ [ d ]; ++ c ) {
+      double lower, upper;
+      patchInterval ( d, c, & lower, & upper );
+      std::pair<int64_t, int64_t> range = grid -> coverRange ( d, lower, upper );
+      if ( range . second > range . first ) num_coordinates += range . second - range . first;
+    }
+    * num_patches *= patches_across_ [ d ];
+    * num_vertices *= num_coordinates;
+  }
+#endif
+}
+
 inline int 
 EuclideanParameterSpace::dimension ( void ) const {
   return dimension_;
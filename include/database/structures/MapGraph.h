@@ -8,12 +8,20 @@
 #include <iterator>
 #include <iostream>
 #include <algorithm>
+#include <string>
 #include <unistd.h>
 
 #include "boost/unordered_map.hpp"
 #include "boost/foreach.hpp"
 
 #include "database/structures/Grid.h"
+#include "database/structures/TreeGrid.h"
+#include "database/structures/RectGeo.h"
+#include "database/structures/BoxBatch.h"
+#include "database/structures/AdjacencyCache.h"
+#include "database/structures/MapGraphSettings.h"
+#include "database/maps/Map.h"
+#include "database/algorithms/parallelFor.h"
 
 #ifdef CMDB_STORE_GRAPH
 #include "database/program/ComputeGraph.h"
@@ -21,8 +29,12 @@
 
 /// class MapGraph
 ///    This class is used to created an object suitable for graph algorithms
-///    given a grid and a map object. By default "adjacencies" is computed on demand
-///    in order to avoid storing the adjacency lists.
+///    given a grid and a map object. "adjacencies" is computed on demand and
+///    kept in an AdjacencyCache (subject to a memory budget), so that a second
+///    pass over the graph does not have to evaluate the map again.
+///    Vertices are grid elements, numbered as in the grid unless
+///    settings.order asks for another numbering; "element" and "label"
+///    translate between the two.
 class MapGraph {
 public:
   // Typedefs
@@ -31,7 +43,8 @@ public:
     
   // Constructor. Requires Grid and Map.
   MapGraph ( std::shared_ptr<const Grid> grid, 
-             std::shared_ptr<const Map> f );
+             std::shared_ptr<const Map> f,
+             const MapGraphSettings & settings = MapGraphSettings () );
   
   /// adjacencies
   ///   Return vector of Vertices which are out-edge adjacencies of input v
@@ -41,12 +54,57 @@ public:
   ///   Return number of vertices
   size_type num_vertices ( void ) const;
 
+  /// element
+  ///   Return the grid element of vertex v
+  Grid::GridElement element ( const Vertex & v ) const;
+
+  /// label
+  ///   Return the vertex of grid element ge
+  Vertex label ( const Grid::GridElement & ge ) const;
+
+  /// precompute
+  ///   Evaluate the adjacency lists of all vertices up front with a pool of
+  ///   settings.threads worker threads, each taking chunks of consecutive
+  ///   vertices, and place them in the cache. Lists that do not fit in the
+  ///   cache are thrown away and recomputed on demand later. If caching is
+  ///   disabled every list is kept in memory instead.
+  ///   Where the map evaluates boxes directly, it is called on batches of
+  ///   BATCH_SIZE boxes (see Map::operator () ( const BoxBatch &, BoxBatch * )).
+  void precompute ( void );
+
+  /// cache
+  ///   Return the adjacency cache (null if caching is disabled)
+  std::shared_ptr<const AdjacencyCache> cache ( void ) const;
+
 private:
+  // Scratch space for evaluating adjacency lists, one per thread
+  struct Workspace {
+    RectGeo domain;
+    RectGeo image;
+    TreeGrid::CoverWorkspace cover;
+    BoxBatch domains;
+    BoxBatch images;
+    std::vector<Vertex> target;
+  };
+  static Workspace & workspace ( void );
+  // Number of boxes handed to the map at once by precompute
+  static const size_t BATCH_SIZE = 1024;
   // Private methods
-  std::vector<size_type> compute_adjacencies ( const size_type & v ) const;
+  void compute_adjacencies ( const Vertex & v, std::vector<Vertex> * target ) const;
+  void precompute_batch ( Vertex begin, Vertex end );
+  void precompute_store ( Vertex source, const std::vector<Vertex> & target );
+  void relabel ( std::vector<Vertex> * target ) const;
   // Private data
   std::shared_ptr<const Grid> grid_;
+  std::shared_ptr<const TreeGrid> tree_grid_; // set if the box path applies
+  TreeGrid::CoverIndex cover_index_;          // of tree_grid_, if settings.cover_index allows
   std::shared_ptr<const Map> f_;
+  MapGraphSettings settings_;
+  std::shared_ptr<AdjacencyCache> cache_;
+  // Translation tables between vertices and grid elements (settings.order);
+  // both empty if vertices are grid elements
+  std::vector<Grid::GridElement> element_;
+  std::vector<Vertex> label_;
   // Variables used if graph is stored in memory. (See CMDB_STORE_GRAPH define)
   bool stored_graph;
   std::vector<std::vector<Vertex> > adjacency_lists_;
@@ -54,13 +112,45 @@ private:
 
 inline 
 MapGraph::MapGraph ( std::shared_ptr<const Grid> grid,
-           std::shared_ptr<const Map> f ) : 
+           std::shared_ptr<const Map> f,
+           const MapGraphSettings & settings ) : 
 grid_ ( grid ),
 f_ ( f ),
+settings_ ( settings ),
 stored_graph ( false ) {
   if ( not f_ ) {
     throw std::logic_error ( "MapGraph::MapGraph. Unable to construct with uninitialized Map f\n");
   }
+  // Use the allocation-free path if the grid is a TreeGrid and the map
+  // evaluates boxes directly (checked on the first grid element)
+  tree_grid_ = std::dynamic_pointer_cast<const TreeGrid> ( grid_ );
+  if ( tree_grid_ ) {
+    RectGeo box, image;
+    if ( tree_grid_ -> dimension () == 0 || tree_grid_ -> size () == 0 ) {
+      tree_grid_ . reset ();
+    } else {
+      tree_grid_ -> geometry ( 0, & box );
+      if ( not (*f_) ( box, & image ) ) tree_grid_ . reset ();
+    }
+  }
+  if ( tree_grid_ && num_vertices () >= settings_ . cover_index ) {
+    tree_grid_ -> buildCoverIndex ( & cover_index_ );
+  }
+  if ( settings_ . order == "hilbert" ) {
+    std::shared_ptr<const TreeGrid> tree_grid = std::dynamic_pointer_cast<const TreeGrid> ( grid_ );
+    if ( tree_grid && tree_grid -> dimension () > 0 ) {
+      tree_grid -> hilbertOrder ( & element_ );
+      label_ . resize ( element_ . size () );
+      for ( size_type v = 0; v < element_ . size (); ++ v ) label_ [ element_ [ v ] ] = v;
+    }
+  } else if ( settings_ . order != "tree" ) {
+    throw std::logic_error ( "MapGraph::MapGraph. Unknown vertex order \"" + settings_ . order + "\"\n" );
+  }
+  if ( settings_ . cache_memory > AdjacencyCache::overhead ( num_vertices () ) ) {
+    cache_ . reset ( new AdjacencyCache ( num_vertices (), 
+                                          settings_ . cache_memory,
+                                          settings_ . cache_spill ) );
+  }
 #ifdef CMDB_STORE_GRAPH
   
   // Determine whether it is efficient to use an MPI job to store the graph
@@ -101,23 +191,128 @@ stored_graph ( false ) {
 
 inline std::vector<MapGraph::Vertex>
 MapGraph::adjacencies ( const size_type & source ) const {
-  if ( stored_graph )
-    return adjacency_lists_ [ source ];
-  else
-    return compute_adjacencies ( source );
+  if ( stored_graph ) return adjacency_lists_ [ source ];
+  std::vector<Vertex> target;
+  if ( cache_ && cache_ -> find ( source, &target ) ) return target;
+  compute_adjacencies ( source, &target );
+  if ( cache_ ) cache_ -> insert ( source, target );
+  return target;
 }
 
-inline std::vector<MapGraph::Vertex>
-MapGraph::compute_adjacencies ( const Vertex & source ) const {
-  std::vector < Vertex > target = 
-    grid_ -> cover ( (*f_) ( grid_ -> geometry ( source ) ) ); // here is the work
-  return target;
+inline void
+MapGraph::compute_adjacencies ( const Vertex & source, 
+                                std::vector<Vertex> * target ) const {
+  Grid::GridElement ge = element ( source );
+  Workspace & scratch = workspace ();
+  if ( tree_grid_ ) tree_grid_ -> geometry ( ge, & scratch . domain );
+  if ( tree_grid_ && (*f_) ( scratch . domain, & scratch . image ) ) {
+    // Box to box, reusing this thread's storage
+    scratch . cover . index = & cover_index_;
+    tree_grid_ -> coverAccept ( scratch . image, & scratch . cover, target ); // here is the work
+  } else {
+    * target = grid_ -> cover ( (*f_) ( grid_ -> geometry ( ge ) ) ); // here is the work
+  }
+  relabel ( target );
+}
+
+inline void
+MapGraph::relabel ( std::vector<Vertex> * target ) const {
+  if ( label_ . empty () ) return;
+  for ( size_t i = 0; i < target -> size (); ++ i ) {
+    (*target) [ i ] = label_ [ (*target) [ i ] ];
+  }
+}
+
+
+inline void
+MapGraph::precompute ( void ) {
+  if ( stored_graph ) return;
+  if ( not cache_ ) adjacency_lists_ . resize ( num_vertices () );
+  int threads = resolveThreadCount ( settings_ . threads );
+  size_type N = num_vertices ();
+  // Aim for a few dozen chunks per thread so the slow regions of phase space
+  // do not all land on the same worker.
+  uint64_t chunk = std::max ( (uint64_t) 64, N / ( 32 * (uint64_t) threads ) );
+  parallelFor ( 0, N, chunk, threads, 
+    [&] ( uint64_t chunk_begin, uint64_t chunk_end, int ) {
+      for ( Vertex source = chunk_begin; source < chunk_end; source += BATCH_SIZE ) {
+        Vertex batch_end = std::min ( (Vertex) chunk_end, source + BATCH_SIZE );
+        precompute_batch ( source, batch_end );
+      }
+    });
+  if ( not cache_ ) stored_graph = true;
 }
 
+inline void
+MapGraph::precompute_batch ( Vertex begin, Vertex end ) {
+  Workspace & scratch = workspace ();
+  std::vector<Vertex> & target = scratch . target;
+  if ( not tree_grid_ ) {
+    for ( Vertex source = begin; source < end; ++ source ) {
+      compute_adjacencies ( source, &target );
+      precompute_store ( source, target );
+    }
+    return;
+  }
+  // Gather the boxes, evaluate the map on all of them at once, then cover
+  scratch . domains . resize ( tree_grid_ -> dimension (), end - begin );
+  for ( Vertex source = begin; source < end; ++ source ) {
+    tree_grid_ -> geometry ( element ( source ), & scratch . domain );
+    scratch . domains . set ( source - begin, scratch . domain );
+  }
+  if ( not (*f_) ( scratch . domains, & scratch . images ) ) {
+    // Some image is not a box; evaluate this batch one vertex at a time
+    for ( Vertex source = begin; source < end; ++ source ) {
+      compute_adjacencies ( source, &target );
+      precompute_store ( source, target );
+    }
+    return;
+  }
+  scratch . cover . index = & cover_index_;
+  for ( Vertex source = begin; source < end; ++ source ) {
+    scratch . images . get ( source - begin, & scratch . image );
+    tree_grid_ -> coverAccept ( scratch . image, & scratch . cover, &target );
+    relabel ( &target );
+    precompute_store ( source, target );
+  }
+}
+
+inline void
+MapGraph::precompute_store ( Vertex source, const std::vector<Vertex> & target ) {
+  // A list the cache has no room for is simply recomputed when asked for
+  if ( cache_ ) {
+    cache_ -> insert ( source, target );
+  } else {
+    adjacency_lists_ [ source ] = target;
+  }
+}
+
+inline MapGraph::Workspace &
+MapGraph::workspace ( void ) {
+  static thread_local Workspace result;
+  return result;
+}
+
+inline std::shared_ptr<const AdjacencyCache>
+MapGraph::cache ( void ) const {
+  return cache_;
+}
 
 inline MapGraph::size_type
 MapGraph::num_vertices ( void ) const {
   return grid_ -> size ();
 }
 
+inline Grid::GridElement
+MapGraph::element ( const Vertex & v ) const {
+  if ( element_ . empty () ) return v;
+  return element_ [ v ];
+}
+
+inline MapGraph::Vertex
+MapGraph::label ( const Grid::GridElement & ge ) const {
+  if ( label_ . empty () ) return ge;
+  return label_ [ ge ];
+}
+
 #endif
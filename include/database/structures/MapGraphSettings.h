@@ -0,0 +1,51 @@
+// MapGraphSettings.h
+
+#ifndef CMDB_MAPGRAPHSETTINGS_H
+#define CMDB_MAPGRAPHSETTINGS_H
+
+#include <stdint.h>
+#include <string>
+#include "boost/serialization/serialization.hpp"
+#include "boost/serialization/string.hpp"
+
+/// struct MapGraphSettings
+///    Controls how MapGraph evaluates and keeps adjacency lists.
+///      threads      : threads used by MapGraph::precompute (0 means one per core)
+///      cache_memory : bytes kept in memory by the adjacency cache, including
+///                     12 bytes of bookkeeping per vertex (0, the default,
+///                     disables the cache); split evenly among node_threads
+///      cache_spill  : directory to spill cached lists to once cache_memory is
+///                     exceeded (empty means stop caching instead)
+///      order        : how vertices are numbered; "tree" numbers them as the
+///                     grid does (leaf order), "hilbert" along a Hilbert curve
+///                     through phase space (TreeGrids only)
+///      node_threads : nodes of the Morse decomposition hierarchy decomposed
+///                     at once by Compute_Morse_Graph (0 means one per core);
+///                     each may use "threads" threads of its own
+///      cover_index  : least number of grid elements for which MapGraph builds
+///                     a TreeGrid::CoverIndex (2 to 4 tree nodes per element)
+///                     to start covers below the root (default 1024; 0 means
+///                     always, and the largest value never)
+struct MapGraphSettings {
+  int threads;
+  uint64_t cache_memory;
+  std::string cache_spill;
+  std::string order;
+  int node_threads;
+  uint64_t cover_index;
+  MapGraphSettings ( void ) : threads ( 1 ), cache_memory ( 0 ), order ( "tree" ),
+    node_threads ( 1 ), cover_index ( 1024 ) {}
+
+  friend class boost::serialization::access;
+  template<class Archive>
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & threads;
+    ar & cache_memory;
+    ar & cache_spill;
+    ar & order;
+    ar & node_threads;
+    ar & cover_index;
+  }
+};
+
+#endif
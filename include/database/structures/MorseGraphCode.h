@@ -0,0 +1,381 @@
+// MorseGraphCode.h
+#ifndef CMDB_MORSEGRAPHCODE_H
+#define CMDB_MORSEGRAPHCODE_H
+
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <stack>
+#include <set>
+#include <string>
+#include <utility>
+#include <memory>
+#include <exception>
+#include <stdexcept>
+
+#include "boost/serialization/serialization.hpp"
+#include "boost/serialization/vector.hpp"
+#include "boost/serialization/set.hpp"
+#include "boost/serialization/string.hpp"
+#include "boost/serialization/utility.hpp"
+
+#include "database/structures/Grid.h"
+#include "database/structures/TreeGrid.h"
+#include "database/structures/PointerGrid.h"
+#include "database/structures/Atlas.h"
+#include "database/structures/BitSequence.h"
+#include "database/structures/CompressedTree.h"
+#include "database/structures/MorseGraph.h"
+
+/// class MorseGraphCode
+///    Compact form of a Morse graph with its grids, for shipping between
+///    processes and storing on disk. Each tree of the phase space (the phase
+///    space itself, or each chart of an Atlas) is kept as the leaf and valid
+///    bit sequences of its CompressedTree, followed by one label per valid
+///    leaf, in preorder: the Morse set containing the leaf, or NumVertices ()
+///    for none. Labels take labelWidth () bits each. The Morse set grids are
+///    thus stored once, as labels on the partition, rather than as a tree
+///    apiece. Conley indices are not kept.
+class MorseGraphCode {
+public:
+  typedef MorseGraph::Vertex Vertex;
+  typedef MorseGraph::Edge Edge;
+
+  /// Chart
+  ///    The partition of one tree of the phase space and its leaf labels
+  struct Chart {
+    uint64_t id;                     // Atlas chart id (0 for a TreeGrid)
+    RectGeo bounds;
+    std::vector<bool> periodicity;
+    CompressedTree tree;
+    BitSequence labels;
+    template<class Archive>
+    void serialize ( Archive & ar, const unsigned int version ) {
+      ar & id;
+      ar & bounds;
+      ar & periodicity;
+      ar & tree . leaf_sequence;
+      ar & tree . valid_sequence;
+      ar & labels;
+    }
+  };
+
+  /// MorseGraphCode
+  MorseGraphCode ( void );
+
+  /// MorseGraphCode
+  ///   Encode "morse_graph"
+  explicit MorseGraphCode ( const MorseGraph & morse_graph );
+
+  /// encode
+  ///   Encode the vertices, edges, annotations and grids of "morse_graph".
+  ///   The phase space must be a TreeGrid or an Atlas (or absent, in which
+  ///   case no grids are kept), and each Morse set a subset of it of the
+  ///   same kind.
+  void encode ( const MorseGraph & morse_graph );
+
+  /// decode
+  ///   Rebuild the Morse graph in "morse_graph". "phase_space" is a grid of
+  ///   the kind the model uses (typically model . phaseSpace ()); it is
+  ///   overwritten with the stored partition and becomes the phase space of
+  ///   the result.
+  void decode ( MorseGraph * morse_graph,
+                std::shared_ptr<Grid> phase_space ) const;
+
+  /// decodePhaseSpace
+  ///   Overwrite "phase_space" with the stored partition, as decode does,
+  ///   without rebuilding the Morse sets
+  void decodePhaseSpace ( std::shared_ptr<Grid> phase_space ) const;
+
+  /// morseSet
+  ///   Write the grid elements of Morse set "vertex" in "phase_space", a
+  ///   TreeGrid restored by decodePhaseSpace, in increasing order (none if
+  ///   the phase space is an Atlas)
+  void morseSet ( std::vector<Grid::GridElement> * result,
+                  const TreeGrid & phase_space,
+                  Vertex vertex ) const;
+
+  /// NumVertices
+  uint64_t NumVertices ( void ) const { return num_vertices_; }
+
+  /// atlas
+  ///   Return true if the phase space was an Atlas
+  bool atlas ( void ) const { return atlas_; }
+
+  /// charts
+  const std::vector<Chart> & charts ( void ) const { return charts_; }
+
+  /// labelWidth
+  ///   Return the number of bits per leaf label
+  int labelWidth ( void ) const { return width_; }
+
+  /// label
+  ///   Return the label of valid leaf "leaf" (in preorder) of "chart"
+  uint64_t label ( const Chart & chart, uint64_t leaf ) const;
+
+  /// edges
+  const std::vector<Edge> & edges ( void ) const { return edges_; }
+
+  /// leaves
+  ///   Write the grid elements of the leaves of "partition" in preorder,
+  ///   the order in which a CompressedTree lists its valid leaves
+  static void leaves ( std::vector<Grid::GridElement> * result,
+                       const TreeGrid & partition );
+
+private:
+  void encodeChart ( Chart * chart,
+                     const TreeGrid & partition,
+                     const std::vector<std::shared_ptr<const TreeGrid> > & morse_sets ) const;
+  std::shared_ptr<CompressedTreeGrid> partition ( const Chart & chart ) const;
+
+  uint64_t num_vertices_;
+  bool atlas_;
+  int width_;
+  std::vector<Chart> charts_;
+  std::vector<Edge> edges_;
+  std::set<std::string> annotation_;
+  std::vector<std::set<std::string> > annotation_by_vertex_;
+
+  friend class boost::serialization::access;
+  template<class Archive>
+  void serialize ( Archive & ar, const unsigned int version ) {
+    ar & num_vertices_;
+    ar & atlas_;
+    ar & width_;
+    ar & charts_;
+    ar & edges_;
+    ar & annotation_;
+    ar & annotation_by_vertex_;
+  }
+};
+
+inline
+MorseGraphCode::MorseGraphCode ( void ) : num_vertices_ ( 0 ), atlas_ ( false ), width_ ( 0 ) {}
+
+inline
+MorseGraphCode::MorseGraphCode ( const MorseGraph & morse_graph ) {
+  encode ( morse_graph );
+}
+
+inline void
+MorseGraphCode::encode ( const MorseGraph & morse_graph ) {
+  typedef std::shared_ptr<const TreeGrid> TreeGridPtr;
+  num_vertices_ = morse_graph . NumVertices ();
+  atlas_ = false;
+  width_ = 0;
+  while ( ( num_vertices_ >> width_ ) > 0 ) ++ width_;
+  charts_ . clear ();
+  edges_ . assign ( morse_graph . Edges () . first, morse_graph . Edges () . second );
+  std::sort ( edges_ . begin (), edges_ . end () );
+  annotation_ = morse_graph . annotation ();
+  annotation_by_vertex_ . resize ( num_vertices_ );
+  for ( uint64_t v = 0; v < num_vertices_; ++ v ) {
+    annotation_by_vertex_ [ v ] = morse_graph . annotation ( v );
+  }
+
+  std::shared_ptr<const Grid> phase_space = morse_graph . phaseSpace ();
+  if ( not phase_space ) return;
+  std::shared_ptr<const Atlas> atlas = std::dynamic_pointer_cast<const Atlas> ( phase_space );
+  TreeGridPtr tree = std::dynamic_pointer_cast<const TreeGrid> ( phase_space );
+  if ( atlas ) {
+    atlas_ = true;
+    for ( Atlas::IdChartPair const& pair : atlas -> charts () ) {
+      std::vector<TreeGridPtr> morse_sets ( num_vertices_ );
+      for ( uint64_t v = 0; v < num_vertices_; ++ v ) {
+        std::shared_ptr<const Atlas> morse_set =
+          std::dynamic_pointer_cast<const Atlas> ( morse_graph . grid ( v ) );
+        if ( not morse_set ) continue;
+        for ( Atlas::IdChartPair const& other : morse_set -> charts () ) {
+          if ( other . first == pair . first ) morse_sets [ v ] = other . second;
+        }
+      }
+      charts_ . push_back ( Chart () );
+      charts_ . back () . id = pair . first;
+      encodeChart ( & charts_ . back (), * pair . second, morse_sets );
+    }
+  } else if ( tree ) {
+    std::vector<TreeGridPtr> morse_sets ( num_vertices_ );
+    for ( uint64_t v = 0; v < num_vertices_; ++ v ) {
+      morse_sets [ v ] = std::dynamic_pointer_cast<const TreeGrid> ( morse_graph . grid ( v ) );
+    }
+    charts_ . push_back ( Chart () );
+    charts_ . back () . id = 0;
+    encodeChart ( & charts_ . back (), * tree, morse_sets );
+  } else {
+    throw std::logic_error ( "MorseGraphCode::encode. The phase space is neither a TreeGrid nor an Atlas.\n" );
+  }
+}
+
+inline void
+MorseGraphCode::encodeChart ( Chart * chart,
+                              const TreeGrid & partition,
+                              const std::vector<std::shared_ptr<const TreeGrid> > & morse_sets ) const {
+  chart -> bounds = partition . bounds ();
+  chart -> periodicity = partition . periodicity ();
+  BitSequence & leaf_sequence = chart -> tree . leaf_sequence;
+  BitSequence & valid_sequence = chart -> tree . valid_sequence;
+  if ( partition . size () == 0 ) {
+    leaf_sequence . push_back ( false );
+    valid_sequence . push_back ( false );
+    return;
+  }
+  // Label the leaves by grid element
+  std::vector<uint64_t> label_of ( partition . size (), num_vertices_ );
+  for ( uint64_t v = 0; v < num_vertices_; ++ v ) {
+    if ( not morse_sets [ v ] || morse_sets [ v ] -> size () == 0 ) continue;
+    std::vector<Grid::GridElement> subset = partition . subset ( * morse_sets [ v ] );
+    for ( Grid::GridElement ge : subset ) label_of [ ge ] = v;
+  }
+  // Write the tree and the labels in preorder. A missing child is written
+  // as an invalid leaf, so the result is a full binary tree.
+  std::stack<Tree::iterator> work;
+  work . push ( partition . treeBegin () );
+  while ( not work . empty () ) {
+    Tree::iterator it = work . top ();
+    work . pop ();
+    if ( it == partition . treeEnd () ||
+         ( partition . tree () . isLeaf ( it ) && not partition . isGrid ( it ) ) ) {
+      leaf_sequence . push_back ( false );
+      valid_sequence . push_back ( false );
+      continue;
+    }
+    if ( partition . isGrid ( it ) ) {
+      leaf_sequence . push_back ( false );
+      valid_sequence . push_back ( true );
+      chart -> labels . append ( label_of [ * partition . TreeToGrid ( it ) ], width_ );
+      continue;
+    }
+    leaf_sequence . push_back ( true );
+    work . push ( partition . right ( it ) );
+    work . push ( partition . left ( it ) );
+  }
+}
+
+inline std::shared_ptr<CompressedTreeGrid>
+MorseGraphCode::partition ( const Chart & chart ) const {
+  std::shared_ptr<CompressedTreeGrid> result ( new CompressedTreeGrid );
+  result -> bounds () = chart . bounds;
+  result -> periodicity () = chart . periodicity;
+  * result -> tree () = chart . tree;
+  return result;
+}
+
+inline void
+MorseGraphCode::decodePhaseSpace ( std::shared_ptr<Grid> phase_space ) const {
+  if ( charts_ . empty () ) return;
+  std::shared_ptr<Atlas> atlas = std::dynamic_pointer_cast<Atlas> ( phase_space );
+  std::shared_ptr<TreeGrid> tree = std::dynamic_pointer_cast<TreeGrid> ( phase_space );
+  if ( atlas_ && atlas ) {
+    atlas -> clear ();
+    for ( const Chart & chart : charts_ ) {
+      std::shared_ptr<TreeGrid> chart_grid ( new PointerGrid );
+      chart_grid -> assign ( partition ( chart ) );
+      atlas -> chart ( chart . id ) = chart_grid;
+    }
+    atlas -> finalize ();
+  } else if ( not atlas_ && tree ) {
+    tree -> assign ( partition ( charts_ [ 0 ] ) );
+  } else {
+    throw std::logic_error ( "MorseGraphCode::decodePhaseSpace. The phase space is not of the stored kind.\n" );
+  }
+}
+
+inline void
+MorseGraphCode::decode ( MorseGraph * morse_graph,
+                         std::shared_ptr<Grid> phase_space ) const {
+  // Restore the partitions
+  std::vector<std::shared_ptr<TreeGrid> > partitions;
+  if ( not charts_ . empty () ) {
+    decodePhaseSpace ( phase_space );
+    if ( atlas_ ) {
+      Atlas & atlas = dynamic_cast<Atlas &> ( * phase_space );
+      for ( const Chart & chart : charts_ ) partitions . push_back ( atlas . chart ( chart . id ) );
+    } else {
+      partitions . push_back ( std::dynamic_pointer_cast<TreeGrid> ( phase_space ) );
+    }
+  } else {
+    phase_space . reset ();
+  }
+
+  // Vertices, edges and annotations
+  * morse_graph = MorseGraph ( phase_space );
+  for ( uint64_t v = 0; v < num_vertices_; ++ v ) {
+    morse_graph -> AddVertex ();
+    morse_graph -> annotation ( v ) = annotation_by_vertex_ [ v ];
+  }
+  for ( const Edge & edge : edges_ ) morse_graph -> AddEdge ( edge . first, edge . second );
+  morse_graph -> annotation () = annotation_;
+  if ( partitions . empty () ) return;
+
+  // Morse set grids: the leaves of each chart carrying each label
+  std::vector<std::vector<std::shared_ptr<TreeGrid> > > morse_sets
+    ( num_vertices_, std::vector<std::shared_ptr<TreeGrid> > ( charts_ . size () ) );
+  std::vector<Grid::GridElement> grid_elements;
+  for ( size_t c = 0; c < charts_ . size (); ++ c ) {
+    const TreeGrid & chart_grid = * partitions [ c ];
+    leaves ( & grid_elements, chart_grid );
+    std::vector<std::deque<Grid::GridElement> > members ( num_vertices_ );
+    for ( uint64_t leaf = 0; leaf < grid_elements . size (); ++ leaf ) {
+      uint64_t v = label ( charts_ [ c ], leaf );
+      if ( v < num_vertices_ ) members [ v ] . push_back ( grid_elements [ leaf ] );
+    }
+    for ( uint64_t v = 0; v < num_vertices_; ++ v ) {
+      morse_sets [ v ] [ c ] . reset ( chart_grid . subgrid ( members [ v ] ) );
+    }
+  }
+  for ( uint64_t v = 0; v < num_vertices_; ++ v ) {
+    if ( atlas_ ) {
+      std::shared_ptr<Atlas> morse_set ( new Atlas );
+      for ( size_t c = 0; c < charts_ . size (); ++ c ) {
+        morse_set -> chart ( charts_ [ c ] . id ) = morse_sets [ v ] [ c ];
+      }
+      morse_set -> finalize ();
+      morse_graph -> grid ( v ) = morse_set;
+    } else {
+      morse_graph -> grid ( v ) = morse_sets [ v ] [ 0 ];
+    }
+  }
+}
+
+inline void
+MorseGraphCode::morseSet ( std::vector<Grid::GridElement> * result,
+                           const TreeGrid & phase_space,
+                           Vertex vertex ) const {
+  result -> clear ();
+  if ( charts_ . empty () || atlas_ ) return;
+  std::vector<Grid::GridElement> grid_elements;
+  leaves ( & grid_elements, phase_space );
+  for ( uint64_t leaf = 0; leaf < grid_elements . size (); ++ leaf ) {
+    if ( label ( charts_ [ 0 ], leaf ) == (uint64_t) vertex ) result -> push_back ( grid_elements [ leaf ] );
+  }
+  std::sort ( result -> begin (), result -> end () );
+}
+
+inline uint64_t
+MorseGraphCode::label ( const Chart & chart, uint64_t leaf ) const {
+  if ( width_ == 0 ) return num_vertices_;
+  return chart . labels . get ( leaf * width_, width_ );
+}
+
+inline void
+MorseGraphCode::leaves ( std::vector<Grid::GridElement> * result,
+                         const TreeGrid & partition ) {
+  result -> clear ();
+  if ( partition . size () == 0 ) return;
+  std::stack<Tree::iterator> work;
+  work . push ( partition . treeBegin () );
+  while ( not work . empty () ) {
+    Tree::iterator it = work . top ();
+    work . pop ();
+    if ( it == partition . treeEnd () ) continue;
+    if ( partition . tree () . isLeaf ( it ) ) {
+      if ( partition . isGrid ( it ) ) result -> push_back ( * partition . TreeToGrid ( it ) );
+      continue;
+    }
+    work . push ( partition . right ( it ) );
+    work . push ( partition . left ( it ) );
+  }
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <utility>
+#include <stdexcept>
 #include "unordered_map"
 #include <memory>
 #include "boost/serialization/serialization.hpp"
@@ -112,6 +113,15 @@ public:
 	///    and the edge between them.
 	virtual std::shared_ptr<ParameterPatch> patch ( void ) const;
 
+	/// countPatches
+	///    Return the number of patches in the sequence produced by "patch",
+	///    and the total number of vertices in them (counted with repetition).
+	///    Must be called at the start of the sequence.
+	///    The default implementation walks through the sequence; derived
+	///    classes should compute the counts directly where they can.
+	virtual void countPatches ( uint64_t * num_patches, 
+	                            uint64_t * num_vertices ) const;
+
 	/// begin
 	///    Return "begin" iterator
 
@@ -187,6 +197,22 @@ ParameterSpace::patch ( void ) const {
 	return result;
 }
 
+inline void
+ParameterSpace::countPatches ( uint64_t * num_patches, 
+                               uint64_t * num_vertices ) const {
+  * num_patches = 0;
+  * num_vertices = 0;
+  while ( 1 ) {
+    std::shared_ptr<ParameterPatch> p = patch ();
+    if ( not p ) {
+      throw std::logic_error("ParameterSpace::countPatches. Unable to obtain patch.\n");
+    }
+    if ( p -> empty () ) break;
+    ++ * num_patches;
+    * num_vertices += p -> vertices . size ();
+  }
+}
+
 	/// begin
 	///    Return "begin" iterator
 
@@ -32,6 +32,7 @@ public:
   virtual PointerTree & tree ( void );
   virtual PointerGrid * spawn ( void ) const;
   virtual void rebuild ( std::shared_ptr<const CompressedTreeGrid> compressed );
+  virtual void subdivide ( void );
   void rebuildFromTree ( void );
 private:
   std::shared_ptr<PointerTree> tree_;
@@ -115,6 +116,35 @@ PointerGrid::rebuild ( std::shared_ptr<const CompressedTreeGrid> compressed ) {
   rebuildFromTree ();
 }
 
+/// subdivide
+///   Subdivides the tree in place rather than through a CompressedTreeGrid.
+///   Grid element g is replaced by grid elements 2g and 2g+1 (its left and
+///   right halves), which is the numbering TreeGrid::subdivide gives.
+inline void 
+PointerGrid::subdivide ( void ) {
+  uint64_t old_tree_size = tree () . size ();
+  tree () . subdivide ();
+  uint64_t new_tree_size = tree () . size ();
+  std::vector < Tree::iterator > tree_iterators ( 2 * size_ );
+  grid_iterators_ . resize ( new_tree_size );
+  for ( uint64_t ge = 0; ge < size_; ++ ge ) {
+    Tree::iterator it = tree_iterators_ [ ge ];
+    grid_iterators_ [ * it ] = Grid::iterator ( new_tree_size );
+    tree_iterators [ 2 * ge ] = tree () . left ( it );
+    tree_iterators [ 2 * ge + 1 ] = tree () . right ( it );
+  }
+  for ( uint64_t node = 0; node < old_tree_size; ++ node ) {
+    if ( * grid_iterators_ [ node ] == old_tree_size ) {
+      grid_iterators_ [ node ] = Grid::iterator ( new_tree_size );
+    }
+  }
+  for ( uint64_t ge = 0; ge < 2 * size_; ++ ge ) {
+    grid_iterators_ [ * tree_iterators [ ge ] ] = Grid::iterator ( ge );
+  }
+  std::swap ( tree_iterators_, tree_iterators );
+  size_ *= 2;
+}
+
 inline void 
 PointerGrid::rebuildFromTree ( void ) {
   // Now we rebuild the GridIterator to TreeIterator conversions
@@ -34,6 +34,11 @@ public:
   virtual bool isRight ( iterator it ) const;
   virtual bool isLeaf ( iterator it ) const;
   virtual void assign ( std::shared_ptr<const CompressedTree> compressed );
+  /// subdivide
+  ///   Give every leaf two children. The new nodes are appended, two per
+  ///   leaf, in the order of the leaves' node indices; existing nodes keep
+  ///   their indices.
+  void subdivide ( void );
   virtual uint64_t memory ( void ) const;
 private:
   std::vector < PointerTreeNode > nodes_;
@@ -129,9 +134,9 @@ inline void
 PointerTree::assign ( std::shared_ptr<const CompressedTree> compressed ) {
   const bool LEAF = false;
   const bool NOT_A_LEAF = true;
-  const std::vector<bool> & leaf_sequence = 
+  const BitSequence & leaf_sequence = 
     compressed -> leaf_sequence;
-  const std::vector<bool> & valid_sequence = 
+  const BitSequence & valid_sequence = 
     compressed -> valid_sequence;
   size_t N = leaf_sequence . size ();
   std::stack<std::pair<Tree::iterator, int> > path_to_root;
@@ -175,6 +180,35 @@ PointerTree::assign ( std::shared_ptr<const CompressedTree> compressed ) {
   }
 }
 
+inline void 
+PointerTree::subdivide ( void ) {
+  int64_t old_size = nodes_ . size ();
+  int64_t num_leaves = 0;
+  for ( int64_t i = 0; i < old_size; ++ i ) if ( isleaf_ [ i ] ) ++ num_leaves;
+  int64_t new_size = old_size + 2 * num_leaves;
+  nodes_ . reserve ( new_size );
+  parity_ . reserve ( new_size );
+  isleaf_ . reserve ( new_size );
+  for ( int64_t i = 0; i < old_size; ++ i ) {
+    // Missing links point at end (), which moves
+    PointerTreeNode & node = nodes_ [ i ];
+    if ( node . left_ == old_size ) node . left_ = new_size;
+    if ( node . right_ == old_size ) node . right_ = new_size;
+    if ( node . parent_ == old_size ) node . parent_ = new_size;
+    if ( not isleaf_ [ i ] ) continue;
+    node . left_ = nodes_ . size ();
+    nodes_ . push_back ( PointerTreeNode ( new_size, new_size, i ) );
+    parity_ . push_back ( false );
+    isleaf_ . push_back ( true );
+    node . right_ = nodes_ . size ();
+    nodes_ . push_back ( PointerTreeNode ( new_size, new_size, i ) );
+    parity_ . push_back ( true );
+    isleaf_ . push_back ( true );
+    isleaf_ [ i ] = false;
+  }
+  size_ = new_size;
+}
+
 inline uint64_t 
 PointerTree::memory ( void ) const {
   return sizeof ( PointerTree ) +
@@ -15,6 +15,7 @@
 #include "sdsl/rank_support_v5.hpp"
 #include "sdsl/select_support_mcl.hpp"
 #include "sdsl/util.hpp"
+#include "database/structures/BitSequence.h"
 
 /// RankSelect
 class RankSelect {
@@ -41,6 +42,28 @@ public:
     select_ = sdsl::select_support_mcl < > ( &bits_ );
   }
 
+  /// assign
+  ///    Delayed constructor from a BitSequence, copied a word at a time.
+  void assign ( const BitSequence & bits ) {
+    bits_ = sdsl::bit_vector ( bits . size (), 0 );
+    for ( size_type i = 0; i < bits . size (); i += 64 ) {
+      int width = ( bits . size () - i < 64 ) ? bits . size () - i : 64;
+      bits_ . set_int ( i, bits . get ( i, width ), width );
+    }
+    rank_ = sdsl::rank_support_v5 < > ( &bits_ );
+    select_ = sdsl::select_support_mcl < > ( &bits_ );
+  }
+
+  /// assign
+  ///    Delayed constructor from an sdsl bit vector. The bits are swapped
+  ///    in; "bits" is left empty.
+  void assign ( sdsl::bit_vector * bits ) {
+    bits_ . swap ( * bits );
+    sdsl::bit_vector () . swap ( * bits );
+    rank_ = sdsl::rank_support_v5 < > ( &bits_ );
+    select_ = sdsl::select_support_mcl < > ( &bits_ );
+  }
+
   /// rank
   ///   @return the rank of the bit sequence at a given position. 
   ///   Here the rank is defined as the number of 1's on [0,i-1]  
@@ -48,6 +48,7 @@ public:
   virtual SuccinctTree & tree ( void );
   virtual SuccinctGrid * spawn ( void ) const;
   virtual void rebuild ( std::shared_ptr<const CompressedTreeGrid> compressed );
+  virtual void subdivide ( void );
   
 private:
   // Data
@@ -130,4 +131,53 @@ SuccinctGrid::rebuild ( std::shared_ptr<const CompressedTreeGrid> compressed ) {
   valid_sequence_ . assign ( compressed -> tree () -> valid_sequence );
 }
 
+/// subdivide
+///   Builds the subdivided leaf and valid sequences directly from the
+///   current ones, rather than through a CompressedTreeGrid. Every valid
+///   leaf becomes an interior node with two valid leaves; invalid leaves
+///   are kept. Grid element g becomes grid elements 2g and 2g+1.
+inline void 
+SuccinctGrid::subdivide ( void ) {
+  const sdsl::bit_vector & leaf_sequence = tree () . leafSequence ();
+  const sdsl::bit_vector & valid_sequence = valid_sequence_ . bitSequence ();
+  uint64_t num_valid = size ();
+  // Both outputs start zeroed, so only the 1 bits need writing
+  sdsl::bit_vector new_leaf_sequence ( leaf_sequence . size () + 2 * num_valid, 0 );
+  sdsl::bit_vector new_valid_sequence ( valid_sequence . size () + num_valid, 0 );
+  const uint64_t * leaf_words = leaf_sequence . data ();
+  const uint64_t * valid_words = valid_sequence . data ();
+  uint64_t * new_leaf_words = new_leaf_sequence . data ();
+  uint64_t * new_valid_words = new_valid_sequence . data ();
+  // Bit 0 is the sentinel open parenthesis in front of the root
+  new_leaf_words [ 0 ] |= 1;
+  uint64_t leaf_position = 1;
+  uint64_t leaf = 0;
+  uint64_t valid_position = 0;
+  for ( uint64_t i = 1; i < leaf_sequence . size (); ++ i ) {
+    uint64_t interior = ( leaf_words [ i >> 6 ] >> ( i & 63 ) ) & 1;
+    if ( interior ) {
+      new_leaf_words [ leaf_position >> 6 ] |= (uint64_t) 1 << ( leaf_position & 63 );
+      ++ leaf_position;
+      continue;
+    }
+    uint64_t valid = ( valid_words [ leaf >> 6 ] >> ( leaf & 63 ) ) & 1;
+    ++ leaf;
+    if ( valid ) {
+      // 1 0 0 : an interior node with two leaves, both valid
+      new_leaf_words [ leaf_position >> 6 ] |= (uint64_t) 1 << ( leaf_position & 63 );
+      leaf_position += 3;
+      new_valid_words [ valid_position >> 6 ] |= (uint64_t) 1 << ( valid_position & 63 );
+      ++ valid_position;
+      new_valid_words [ valid_position >> 6 ] |= (uint64_t) 1 << ( valid_position & 63 );
+      ++ valid_position;
+    } else {
+      ++ leaf_position;
+      ++ valid_position;
+    }
+  }
+  tree () . assignFromBitVector ( & new_leaf_sequence );
+  valid_sequence_ . assign ( & new_valid_sequence );
+  size_ = 2 * num_valid;
+}
+
 #endif
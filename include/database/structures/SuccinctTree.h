@@ -6,6 +6,7 @@
 /// @description This file defines class SuccinctTree which 
 /// provides an implementation of a full binary tree using SDSL.
 #include <exception>
+#include <algorithm>
 #include "boost/foreach.hpp"
 #include <memory>
 #include "boost/iterator/counting_iterator.hpp"
@@ -20,6 +21,7 @@
 #include "sdsl/select_support_mcl.hpp"
 #include "sdsl/util.hpp"
 #include "database/structures/Tree.h"
+#include "database/structures/BitSequence.h"
 
 /// SuccinctTree
 ///   Implements a full binary tree using SDSL
@@ -41,6 +43,12 @@ public:
   /// assignFromLeafSequence 
   void assignFromLeafSequence ( const std::vector<bool> & leaf_sequence );
 
+  /// assignFromBitVector
+  ///   Reset structure to the tree given by "leaf_sequence", which is in
+  ///   the format returned by leafSequence () (i.e. with a leading 1).
+  ///   The bits are swapped in; "leaf_sequence" is left empty.
+  void assignFromBitVector ( sdsl::bit_vector * leaf_sequence );
+
   /// leafEnd
   ///   Give the one-past-the-end leaf (i.e. return number of leaves)
   int64_t leafEnd ( void ) const;
@@ -116,8 +124,16 @@ SuccinctTree::SuccinctTree ( void ) {
 
 inline void 
 SuccinctTree::assign ( std::shared_ptr<const CompressedTree> compressed ) {
-  const std::vector < bool > & leaf_sequence = compressed -> leaf_sequence;
-  assignFromLeafSequence ( leaf_sequence );
+  const BitSequence & leaf_sequence = compressed -> leaf_sequence;
+  size_t N = leaf_sequence . size ();
+  // Copy a word at a time, behind the leading 1
+  sdsl::bit_vector bits ( N + 1, 0 );
+  bits [ 0 ] = 1;
+  for ( size_t i = 0; i < N; i += 64 ) {
+    int width = (int) std::min ( (size_t) 64, N - i );
+    bits . set_int ( i + 1, leaf_sequence . get ( i, width ), width );
+  }
+  assignFromBitVector ( & bits );
 }
 
 inline void 
@@ -135,6 +151,17 @@ SuccinctTree::assignFromLeafSequence ( const std::vector<bool> & leaf_sequence )
   select_ =  sdsl::select_support_mcl <0> ( &leaf_sequence_ );
 }
 
+inline void 
+SuccinctTree::assignFromBitVector ( sdsl::bit_vector * leaf_sequence ) {
+  leaf_sequence_ . swap ( * leaf_sequence );
+  sdsl::bit_vector () . swap ( * leaf_sequence );
+  size_ = leaf_sequence_ . size () - 1;
+  leaf_count_ = leaf_sequence_ . size () - sdsl::util::cnt_one_bits ( leaf_sequence_ );
+  tree_ = sdsl::bp_support_sada <> ( & leaf_sequence_ );
+  rank_ = sdsl::rank_support_v5 <0> ( &leaf_sequence_ );
+  select_ =  sdsl::select_support_mcl <0> ( &leaf_sequence_ );
+}
+
 inline int64_t 
 SuccinctTree::leafEnd ( void ) const {
   return leaf_count_;
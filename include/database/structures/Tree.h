@@ -60,6 +60,8 @@ public:
  *     a full binary tree and a valid_sequence over the leaves, what we need to do
  *     is create the full binary tree that is the join of the "joinands", and
  *     each leaf will be valid if it is valid for at least one of the joinands.
+ *     Where only one joinand reaches a subtree, its bits are copied from the
+ *     joinand's CompressedTree a word at a time instead of being walked.
  */
   template < class InputIterator >
   static CompressedTree * join ( InputIterator start, InputIterator stop );
@@ -117,9 +119,9 @@ Tree::subtree ( const std::deque < iterator > & leaves ) const {
 
   CompressedTree * result = new CompressedTree;
   CompressedTree & new_tree = * result;
-  std::vector < bool > & new_leaf_sequence
+  BitSequence & new_leaf_sequence
     = new_tree . leaf_sequence;
-  std::vector < bool > & new_valid_sequence
+  BitSequence & new_valid_sequence
     = new_tree . valid_sequence;
 
   if ( leaves . empty () ) {
@@ -182,8 +184,8 @@ CompressedTree * Tree::join ( InputIterator start, InputIterator stop ) {
   typedef std::shared_ptr<CompressedTree> CompressedTreePtr;
 
   CompressedTree * result = new CompressedTree;
-  std::vector<bool> & leaf_sequence = result -> leaf_sequence;
-  std::vector<bool> & valid_sequence = result -> valid_sequence;
+  BitSequence & leaf_sequence = result -> leaf_sequence;
+  BitSequence & valid_sequence = result -> valid_sequence;
   
   bool trivial_case = true; // All trees are empty.
   for ( InputIterator it = start; it != stop; ++ it ) {
@@ -217,7 +219,7 @@ CompressedTree * Tree::join ( InputIterator start, InputIterator stop ) {
   std::vector< boost::unordered_set < uint64_t > > trees_by_depth ( 1 );
   boost::unordered_set < uint64_t > stalled_valid_trees;
   std::vector< CompressedTreePtr > compressed_trees;
-  //std::vector< int64_t > leaf_seq_positions; //debug
+  std::vector< int64_t > leaf_seq_positions;
   std::vector< int64_t > valid_seq_positions;
   std::vector < bool > left_child_missing;
   std::stack<uint64_t> path_to_root;
@@ -237,7 +239,7 @@ CompressedTree * Tree::join ( InputIterator start, InputIterator stop ) {
     trees . push_back ( tree_compressed_pair . first );
     iterators . push_back ( tree_compressed_pair . first -> begin () );
     compressed_trees . push_back ( tree_compressed_pair . second );
-    //leaf_seq_positions . push_back ( 0 ); //debug
+    leaf_seq_positions . push_back ( 0 );
     valid_seq_positions . push_back ( -1 );
     left_child_missing . push_back ( false );
   }
@@ -297,6 +299,25 @@ CompressedTree * Tree::join ( InputIterator start, InputIterator stop ) {
   int state = 0;  
   while ( 1 ) {
     if ( (depth == 0) && ( state == 2 ) ) break;
+    // If a single tree reaches this interior node and no tree stalled above
+    // it has a valid leaf, the join below it is that tree's subtree. Copy
+    // its leaf and valid bits in bulk and rise.
+    if ( state == 0 && trees_by_depth [ depth ] . size () == 1 && stalled_valid_trees . empty () ) {
+      uint64_t i = * trees_by_depth [ depth ] . begin ();
+      const CompressedTree & compressed = * compressed_trees [ i ];
+      uint64_t node = leaf_seq_positions [ i ];
+      if ( compressed . leaf_sequence [ node ] == NOT_A_LEAF ) {
+        uint64_t node_end = compressed . subtreeEnd ( node );
+        uint64_t leaf = valid_seq_positions [ i ] + 1;
+        uint64_t leaves = ( node_end - node + 1 ) / 2;
+        leaf_sequence . append ( compressed . leaf_sequence, node + 1, node_end );
+        valid_sequence . append ( compressed . valid_sequence, leaf, leaf + leaves );
+        leaf_seq_positions [ i ] = node_end - 1;
+        valid_seq_positions [ i ] += leaves;
+        state = 2;
+        continue;
+      }
+    }
     //std::cout << "Tree::join Position 0. depth = " << depth << " and state = " << state << "\n";
     bool success = false;
     boost::unordered_set < uint64_t > current_trees = trees_by_depth [ depth ]; // copy required
@@ -384,7 +405,7 @@ CompressedTree * Tree::join ( InputIterator start, InputIterator stop ) {
           }
           left_child_missing [ i ] = false;
           //if ( verbose ) std::cout << "Attempt left success.\n";
-          //++ leaf_seq_positions [ i ]; // Advance to child tree index
+          ++ leaf_seq_positions [ i ]; // Advance to child tree index
           iterators[i] = left;
           newdepth = depth + 1;
           success = true;
@@ -401,7 +422,7 @@ CompressedTree * Tree::join ( InputIterator start, InputIterator stop ) {
           if ( left_child_missing [ i ] ) {
             //if ( verbose ) std::cout << "Attempt right notices left child missing.\n";
             ++ valid_seq_positions [ i ];  // Advance to invalid left leaf index.
-            //++ leaf_seq_positions [ i ]; // Advance to invalid left node index.
+            ++ leaf_seq_positions [ i ]; // Advance to invalid left node index.
             // DEBUG BEGIN
             //std::cout << "This code is executed. (A)\n";
             //if (compressed_trees [ i ] -> 
@@ -422,7 +443,7 @@ CompressedTree * Tree::join ( InputIterator start, InputIterator stop ) {
             //  throw std::logic_error ( "Did not expect both children to be missing.\n");
             //}
             // DEBUG END
-            //++ leaf_seq_positions [ i ]; // Advance to invalid right node index.
+            ++ leaf_seq_positions [ i ]; // Advance to invalid right node index.
             ++ valid_seq_positions [ i ];// Advance to invalid right leaf index.
             // DEBUG BEGIN
             /*
@@ -440,7 +461,7 @@ CompressedTree * Tree::join ( InputIterator start, InputIterator stop ) {
             break;
           }
           //if ( verbose ) std::cout << "Attempt right succeeds.\n";
-          //++ leaf_seq_positions [ i ]; // Advance to child tree index 
+          ++ leaf_seq_positions [ i ]; // Advance to child tree index 
           iterators[i] = right;
           newdepth = depth + 1;
           success = true;
@@ -513,7 +534,7 @@ CompressedTree * Tree::join ( InputIterator start, InputIterator stop ) {
             // This is a leaf.
             // We must determine if it is valid.
             // Recharacterize it as a leaf
-            leaf_sequence . back () = LEAF;
+            leaf_sequence . set ( leaf_sequence . size () - 1, LEAF );
             // BEGIN DEBUG
             /*
             valid_count += stalled_valid_trees . empty () ? 0 : 1;
@@ -6,6 +6,8 @@
 #include <vector>
 #include <stack>
 #include <deque>
+#include <algorithm>
+#include <array>
 #include <exception>
 #include "database/structures/Grid.h"
 #include "database/structures/Tree.h"
@@ -35,6 +37,43 @@ public:
   typedef boost::counting_iterator < GridElement > iterator;
   typedef iterator const_iterator;
   typedef uint64_t size_type;
+
+  /// CoverWorkspace
+  ///   Scratch space for coverAccept ( const RectGeo & ). Reusing one across calls
+  ///   avoids reallocating on every cover. A workspace may only be used by one
+  ///   cover call at a time; separate threads need separate workspaces.
+  struct CoverIndex;
+  struct CoverWorkspace {
+    CoverWorkspace ( void ) : index ( NULL ) {}
+    const CoverIndex * index;   // used if set and built from this grid
+    RectGeo region;
+    std::vector<double> width;
+    std::vector<RectGeo> images;
+    std::vector<int64_t> LB;
+    std::vector<int64_t> UB;
+    std::vector<int64_t> NLB;
+    std::vector<int64_t> NUB;
+    std::stack<Tree::iterator, std::vector<Tree::iterator> > parent;
+    std::stack<std::pair<Tree::iterator, Tree::iterator>, 
+               std::vector<std::pair<Tree::iterator, Tree::iterator> > > children;
+  };
+
+  /// CoverIndex
+  ///   Acceleration index for coverAccept ( const RectGeo & ): the tree
+  ///   nodes down to depth "depth", stored by position, so that a cover
+  ///   can start at the deepest node whose box contains the region to be
+  ///   covered rather than at the root. Built by buildCoverIndex and used
+  ///   when a CoverWorkspace points to it. It does not follow changes to
+  ///   the grid; rebuild it after subdividing.
+  struct CoverIndex {
+    CoverIndex ( void ) : grid ( NULL ), depth ( 0 ) {}
+    const TreeGrid * grid;
+    int depth;
+    // The node at depth l whose path from the root reads (left = 0,
+    // right = 1) as the binary number c is nodes [ 2^l + c ], or the end
+    // of the tree if there is no such node
+    std::vector<Tree::iterator> nodes;
+  };
   
   /// assign
   virtual void 
@@ -49,6 +88,8 @@ public:
   compress ( void ) const;
 
   /// subdivide
+  ///   Generic version, by way of compress and assign. PointerGrid and
+  ///   SuccinctGrid override it with direct versions.
   virtual void 
   subdivide ( void );
   
@@ -136,9 +177,20 @@ public:
   virtual std::shared_ptr<Geo> 
   geometry ( GridElement ge ) const; 
 
+  /// geometry
+  ///   Write the box of grid element "ge" into "rect". Once "rect" has the
+  ///   dimension of the grid, no memory is allocated.
+  void 
+  geometry ( GridElement ge, RectGeo * rect ) const;
+
   /// geometryOfTreeNode
   virtual std::shared_ptr<Geo> 
   geometryOfTreeNode ( Tree::iterator it ) const;
+
+  /// geometryOfTreeNode
+  ///   Write the box of tree node "it" into "rect" (as geometry above)
+  void 
+  geometryOfTreeNode ( Tree::iterator it, RectGeo * rect ) const;
   using Grid::geometry;
 
   /// cover
@@ -151,9 +203,40 @@ public:
   std::vector<GridElement> 
 
   /// coverAccept for RectGeo
+  ///   Uses a workspace private to the calling thread, so it is safe
+  ///   to cover from several threads at once.
   coverAccept ( const RectGeo & visitor ) const;
+  std::vector<GridElement> 
+
+  /// coverAccept for RectGeo, with caller-supplied scratch space
+  coverAccept ( const RectGeo & visitor, CoverWorkspace * workspace ) const;
+
+  /// coverAccept for RectGeo, with caller-supplied scratch space and output.
+  ///   "results" is overwritten. For a grid without periodic dimensions,
+  ///   no memory is allocated once the workspace and "results" have grown
+  ///   to size.
+  void
+  coverAccept ( const RectGeo & visitor, 
+                CoverWorkspace * workspace,
+                std::vector<GridElement> * results ) const;
   using Grid::cover;
 
+  /// buildCoverIndex
+  ///   Build a CoverIndex of this grid down to depth "depth". The default
+  ///   (-1) picks a depth with about 2 to 4 entries per grid element,
+  ///   and at most 2^21 entries in all.
+  void
+  buildCoverIndex ( CoverIndex * index, int depth = -1 ) const;
+
+  /// hilbertOrder
+  ///   Write into "order" the grid elements sorted by the position of the
+  ///   lower corner of their boxes along a Hilbert curve through the
+  ///   bounds of the grid. Unlike leaf order (a Z-order curve), consecutive
+  ///   elements of a uniform grid are always neighbours. Coordinates are
+  ///   kept to 64 / dimension bits; finer leaves keep their leaf order.
+  void
+  hilbertOrder ( std::vector<GridElement> * order ) const;
+
   /// memory
   virtual uint64_t 
   memory ( void ) const = 0;
@@ -184,6 +267,48 @@ protected:
   std::vector < bool > periodic_;
   
 private:
+  /// Dimension-specialized kernels
+  ///   coverKernel<D> and geometryKernel<D> hold their per-dimension state
+  ///   in std::arrays of size D, so loops over dimensions unroll.
+  ///   D = 0 is the version for any dimension. The public functions pick
+  ///   one from a table indexed by dimension.
+  static const int SPECIALIZED_DIMENSIONS = 5;
+
+  /// coverStart
+  ///   Return the deepest node in workspace -> index (or the root, if there
+  ///   is no index) whose box contains [ LB, UB ], and set "depth" to its
+  ///   depth and workspace -> NLB, NUB to its box. Return the end of the
+  ///   tree if no leaf can meet [ LB, UB ].
+  Tree::iterator
+  coverStart ( const int64_t * LB, 
+               const int64_t * UB, 
+               CoverWorkspace * workspace,
+               int * depth ) const;
+
+  /// coverKernel
+  ///   Append to "results" the leaves under "start" whose boxes meet
+  ///   [ LB, UB ], given in the integer coordinates of coverAccept.
+  ///   "start" is at depth "depth" and its box is in workspace -> NLB, NUB.
+  template < int D > void
+  coverKernel ( const int64_t * LB, 
+                const int64_t * UB, 
+                Tree::iterator start,
+                int depth,
+                CoverWorkspace * workspace,
+                std::vector<GridElement> * results ) const;
+
+  /// geometryKernel
+  ///   Body of geometryOfTreeNode ( it, rect )
+  template < int D > void
+  geometryKernel ( Tree::iterator it, RectGeo * rect ) const;
+
+  /// hilbertKey
+  ///   Return the index along the Hilbert curve of the point with integer
+  ///   coordinates X [ 0 ] ... X [ dim - 1 ], each of "bits" bits
+  ///   (dim * bits <= 64). X is overwritten.
+  static uint64_t
+  hilbertKey ( uint64_t * X, int dim, int bits );
+
   friend class boost::serialization::access;
   template<class Archive>
   void serialize(Archive & ar, const unsigned int version) {
@@ -532,109 +657,101 @@ TreeGrid::periodicity ( void )  {
 
 inline std::shared_ptr<Geo> 
 TreeGrid::geometryOfTreeNode ( Tree::iterator it ) const {
-  //std::cout << "dimension_ = " << dimension_ << "\n";
-  std::shared_ptr<RectGeo> return_value ( new RectGeo ( dimension(), Real ( 0 ) ) );
-  
-  // Special Case for dimension 0 
-  if ( dimension () == 0 ) return return_value;
-
-  RectGeo & rect = * return_value ; 
-  //std::cout << "Grid::geometry ( " << * cell_iterator << ")\n";
-  /* Climb the tree */
-  Tree::iterator root = tree () . begin ();
-  int division_dimension = tree () . depth ( it ) % dimension ();
+  std::shared_ptr<RectGeo> return_value ( new RectGeo );
+  geometryOfTreeNode ( it, return_value . get () );
+  return return_value;
+}
 
-  while ( it != root ) {
-    //std::cout << "visiting " << *it << " with parent " <<  * tree().parent(it) << "\n";
-    //std::cout . flush ();
-    Tree::iterator parent = tree () . parent ( it );
-    -- division_dimension; if ( division_dimension < 0 ) division_dimension = dimension () - 1;
-    if ( tree () . left ( parent ) == it ) {
-      /* This is a left-child */
-      rect . upper_bounds [ division_dimension ] += Real ( 1 );
-    } else {
-      /* This is a right-child */
-      rect . lower_bounds [ division_dimension ] += Real ( 1 );
-    } /* if-else */
-    rect . lower_bounds [ division_dimension ] /= Real ( 2 );
-    rect . upper_bounds [ division_dimension ] /= Real ( 2 );
-    it = parent;
-  } /* while */
-  for ( int d = 0; d < dimension(); ++ d ) {
-    //std::cout << "d =  " << d << " out of " << dimension_ << "\n";
-    //std::cout << "rect . lower_bounds . size () == " << rect . lower_bounds . size () << "\n";
-    //std::cout << "bounds_ . lower_bounds . size () == " << bounds_ . lower_bounds . size () << "\n";
+inline void 
+TreeGrid::geometryOfTreeNode ( Tree::iterator it, RectGeo * rect ) const {
+  typedef void ( TreeGrid::*Kernel ) ( Tree::iterator, RectGeo * ) const;
+  static const Kernel kernels [ SPECIALIZED_DIMENSIONS + 1 ] = {
+    & TreeGrid::geometryKernel<0>, & TreeGrid::geometryKernel<1>, 
+    & TreeGrid::geometryKernel<2>, & TreeGrid::geometryKernel<3>, 
+    & TreeGrid::geometryKernel<4>, & TreeGrid::geometryKernel<5> };
+  int k = ( dimension_ <= SPECIALIZED_DIMENSIONS ) ? dimension_ : 0;
+  ( this ->* kernels [ k ] ) ( it, rect );
+}
 
-    /* Produce convex combinations */
-    rect . lower_bounds [ d ] = rect . lower_bounds [ d ] * bounds_ . upper_bounds [ d ] +
-    ( Real ( 1 ) - rect . lower_bounds [ d ] ) * bounds_ . lower_bounds [ d ];
-    rect . upper_bounds [ d ] = rect . upper_bounds [ d ] * bounds_ . lower_bounds [ d ] +
-    ( Real ( 1 ) - rect . upper_bounds [ d ] ) * bounds_ . upper_bounds [ d ];
-    //DEBUG
-    if ( rect . lower_bounds [ d ] > rect . lower_bounds [ d ] ) {
-      std::cout << "Grid::geometry ERROR: constructed invalid region.\n";
-      exit(1);
-    }
-  } /* for */
-  //std::cout << "returning from TreeGrid::geometry with " << rect << ".\n";
-  return return_value;
-} /* TreeGrid::geometry */
+template < int D >
+inline void 
+TreeGrid::geometryKernel ( Tree::iterator it, RectGeo * rect ) const {
+  const int dim = ( D > 0 ) ? D : dimension ();
+  std::vector<Real> & lower = rect -> lower_bounds;
+  std::vector<Real> & upper = rect -> upper_bounds;
+  lower . resize ( dim );
+  upper . resize ( dim );
 
-inline std::shared_ptr<Geo> 
-TreeGrid::geometry ( GridElement ge ) const {
-  //std::cout << "TreeGrid::geometry. dimension_ = " << dimension_ << "\n";
-  iterator cell_iterator ( ge ); 
-  std::shared_ptr<RectGeo> return_value ( new RectGeo ( dimension(), Real ( 0 ) ) );
-  
   // Special Case for dimension 0 
-  if ( dimension () == 0 ) return return_value;
-
-  RectGeo & rect = * return_value ; 
-  
-  //std::cout << "TreeGrid::geometry ( " << ge << ")\n";
-  //std::cout << "TreeGrid::geometry. bounds = " << bounds () << "\n";
+  if ( dim == 0 ) return;
+
+  // The fractions of the box within bounds_ are accumulated in "slot"
+  // order (see below): in fixed arrays if D is known, else in rect itself
+  std::array<Real, D> fixed_lower, fixed_upper;
+  Real * slot_lower = ( D > 0 ) ? fixed_lower . data () : & lower [ 0 ];
+  Real * slot_upper = ( D > 0 ) ? fixed_upper . data () : & upper [ 0 ];
+  for ( int d = 0; d < dim; ++ d ) {
+    slot_lower [ d ] = Real ( 0 );
+    slot_upper [ d ] = Real ( 0 );
+  }
 
   /* Climb the tree */
+  // The division dimension of a step depends on the depth of "it", which
+  // is not known until the root is reached. So step k (counting from "it")
+  // is accumulated in slot k % dim, and the slots are put in dimension order
+  // afterwards; step k divides dimension ( depth - 1 - k ) % dim.
   Tree::iterator root = tree () . begin ();
-  Tree::iterator it = GridToTree ( cell_iterator );
-  int division_dimension = tree () . depth ( it ) % dimension ();
-
-  //std::cout << "TreeGrid::geometry. depth = " << tree () . depth ( it ) << "\n";
-
+  int slot = 0;
+  uint64_t depth = 0;
   while ( it != root ) {
-    //std::cout << "TreeGrid::geometry. Visiting " << *it << " with parent " <<  * tree().parent(it) << "\n";
-    //std::cout . flush ();
-    Tree::iterator parent = tree () . parent ( it );
-    -- division_dimension; if ( division_dimension < 0 ) division_dimension = dimension () - 1;
-    if ( tree () . left ( parent ) == it ) {
+    if ( tree () . isLeft ( it ) ) {
       /* This is a left-child */
-      rect . upper_bounds [ division_dimension ] += Real ( 1 );
+      slot_upper [ slot ] += Real ( 1 );
     } else {
       /* This is a right-child */
-      rect . lower_bounds [ division_dimension ] += Real ( 1 );
+      slot_lower [ slot ] += Real ( 1 );
     } /* if-else */
-    rect . lower_bounds [ division_dimension ] /= Real ( 2 );
-    rect . upper_bounds [ division_dimension ] /= Real ( 2 );
-    it = parent;
+    slot_lower [ slot ] /= Real ( 2 );
+    slot_upper [ slot ] /= Real ( 2 );
+    it = tree () . parent ( it );
+    ++ depth;
+    if ( ++ slot == dim ) slot = 0;
   } /* while */
-  for ( int d = 0; d < dimension(); ++ d ) {
-    //std::cout << "d =  " << d << " out of " << dimension_ << "\n";
-    //std::cout << "rect . lower_bounds . size () == " << rect . lower_bounds . size () << "\n";
-    //std::cout << "bounds_ . lower_bounds . size () == " << bounds_ . lower_bounds . size () << "\n";
+  // Dimension d is in slot ( depth - 1 - d ) % dim
+  if ( D > 0 ) {
+    int s = ( depth == 0 ) ? 0 : (int) ( ( depth - 1 ) % dim );
+    for ( int d = 0; d < dim; ++ d ) {
+      lower [ d ] = slot_lower [ s ];
+      upper [ d ] = slot_upper [ s ];
+      if ( s-- == 0 ) s = dim - 1;
+    }
+  } else {
+    int shift = depth % dim;
+    std::reverse ( lower . begin (), lower . end () );
+    std::reverse ( upper . begin (), upper . end () );
+    std::rotate ( lower . begin (), lower . end () - shift, lower . end () );
+    std::rotate ( upper . begin (), upper . end () - shift, upper . end () );
+  }
 
+  for ( int d = 0; d < dim; ++ d ) {
     /* Produce convex combinations */
-    rect . lower_bounds [ d ] = rect . lower_bounds [ d ] * bounds_ . upper_bounds [ d ] +
-    ( Real ( 1 ) - rect . lower_bounds [ d ] ) * bounds_ . lower_bounds [ d ];
-    rect . upper_bounds [ d ] = rect . upper_bounds [ d ] * bounds_ . lower_bounds [ d ] +
-    ( Real ( 1 ) - rect . upper_bounds [ d ] ) * bounds_ . upper_bounds [ d ];
-    //DEBUG
-    if ( rect . lower_bounds [ d ] > rect . lower_bounds [ d ] ) {
-      std::cout << "Grid::geometry ERROR: constructed invalid region.\n";
-      exit(1);
-    }
+    lower [ d ] = lower [ d ] * bounds_ . upper_bounds [ d ] +
+    ( Real ( 1 ) - lower [ d ] ) * bounds_ . lower_bounds [ d ];
+    upper [ d ] = upper [ d ] * bounds_ . lower_bounds [ d ] +
+    ( Real ( 1 ) - upper [ d ] ) * bounds_ . upper_bounds [ d ];
   } /* for */
-  //std::cout << "returning from TreeGrid::geometry with " << rect << ".\n";
+} /* TreeGrid::geometryKernel */
+
+inline std::shared_ptr<Geo> 
+TreeGrid::geometry ( GridElement ge ) const {
+  std::shared_ptr<RectGeo> return_value ( new RectGeo );
+  geometry ( ge, return_value . get () );
   return return_value;
+}
+
+inline void 
+TreeGrid::geometry ( GridElement ge, RectGeo * rect ) const {
+  geometryOfTreeNode ( GridToTree ( iterator ( ge ) ), rect );
 } /* TreeGrid::geometry */
 
 
@@ -660,6 +777,22 @@ TreeGrid::cover ( const Geo & geo ) const {
 
 inline std::vector<Grid::GridElement>
 TreeGrid::coverAccept ( const RectGeo & visitor ) const  {
+  static thread_local CoverWorkspace workspace;
+  return coverAccept ( visitor, & workspace );
+}
+
+inline std::vector<Grid::GridElement>
+TreeGrid::coverAccept ( const RectGeo & visitor, 
+                        CoverWorkspace * workspace ) const  {
+  std::vector<Grid::GridElement> results;
+  coverAccept ( visitor, workspace, & results );
+  return results;
+}
+
+inline void
+TreeGrid::coverAccept ( const RectGeo & visitor, 
+                        CoverWorkspace * workspace,
+                        std::vector<GridElement> * results_ptr ) const  {
   // A note on rigorous numerics:
   // We convert to phase space coordinates into integers for speed. 
   // To do this we convert to a [0,1] double range, and then to {0,1,2,...,2^60}
@@ -673,7 +806,8 @@ TreeGrid::coverAccept ( const RectGeo & visitor ) const  {
 
 
   const RectGeo & geometric_region = visitor;
-  std::vector<Grid::GridElement> results;
+  std::vector<Grid::GridElement> & results = * results_ptr;
+  results . clear ();
   // using namespace chomp;
   //std::cout << "RectGeo version of Cover\n";
   //std::cout << "Covering " << geometric_region << "\n";
@@ -683,21 +817,31 @@ TreeGrid::coverAccept ( const RectGeo & visitor ) const  {
   
   //boost::unordered_set < GridElement > redundancy_check;
   
-  std::vector < double > width ( dimension_ );
+  std::vector < double > & width = workspace -> width;
+  width . resize ( dimension_ );
   for ( int d = 0; d < dimension_; ++ d ) {
     width [ d ] = bounds_ . upper_bounds [ d ] - bounds_ . lower_bounds [ d ];
   }
   
-    // Initialize variables
-  RectGeo region ( dimension_ );
-  static  std::vector<int64_t> LB; LB . resize ( dimension_);
-  static std::vector<int64_t> UB; UB . resize ( dimension_);
-  static std::vector<int64_t> NLB; NLB . resize ( dimension_);
-  static std::vector<int64_t> NUB; NUB . resize ( dimension_);
-  static std::stack<Tree::iterator, std::vector<Tree::iterator> > parent;
-  static std::stack<std::pair<Tree::iterator, Tree::iterator>, 
-                    std::vector<std::pair<Tree::iterator, Tree::iterator>> > children;
-  static std::stack < RectGeo, std::vector<RectGeo> > work_stack;
+  // Initialize variables (storage is reused between calls via the workspace)
+  RectGeo & region = workspace -> region;
+  region . lower_bounds . resize ( dimension_ );
+  region . upper_bounds . resize ( dimension_ );
+  std::vector<int64_t> & LB = workspace -> LB; LB . resize ( dimension_);
+  std::vector<int64_t> & UB = workspace -> UB; UB . resize ( dimension_);
+  typedef void ( TreeGrid::*Kernel ) ( const int64_t *, const int64_t *, 
+                                       Tree::iterator, int,
+                                       CoverWorkspace *, 
+                                       std::vector<GridElement> * ) const;
+  static const Kernel kernels [ SPECIALIZED_DIMENSIONS + 1 ] = {
+    & TreeGrid::coverKernel<0>, & TreeGrid::coverKernel<1>, 
+    & TreeGrid::coverKernel<2>, & TreeGrid::coverKernel<3>, 
+    & TreeGrid::coverKernel<4>, & TreeGrid::coverKernel<5> };
+  Kernel kernel = kernels [ ( dimension_ <= SPECIALIZED_DIMENSIONS ) ? dimension_ : 0 ];
+  // The regions to cover (several if there are periodic images). Elements
+  // of "images" are assigned to rather than constructed, to reuse storage.
+  std::vector < RectGeo > & images = workspace -> images;
+  size_t num_images = 0;
 
   // TODO: Make this computation happen once and for all
   bool periodic_flag = false;
@@ -736,11 +880,13 @@ TreeGrid::coverAccept ( const RectGeo & visitor ) const  {
           r . upper_bounds [ d ] += width [ d ];
         }
       }
-      work_stack . push ( r );
+      if ( images . size () == num_images ) images . resize ( num_images + 1 );
+      images [ num_images ++ ] = r;
       //std::cout << "Pushed " << r << "\n";
     }
   } else {
-    work_stack . push ( geometric_region );
+    if ( images . empty () ) images . resize ( 1 );
+    images [ num_images ++ ] = geometric_region;
   }
 
   //std::cout << "ready to cover pushed things\n";
@@ -751,10 +897,8 @@ TreeGrid::coverAccept ( const RectGeo & visitor ) const  {
    convert the input to these standard coordinates, which we put into integers. */
   
 
-  while ( not work_stack . empty () ) {
-    //std::cout << "Top of cover loop. Size of work stack = " << work_stack . size () << "\n";
-    RectGeo GR = work_stack . top ();
-    work_stack . pop (); // PROFILED
+  for ( size_t image = 0; image < num_images; ++ image ) {
+    const RectGeo & GR = images [ image ];
     //std::cout << "Trying to cover " << GR << "\n";
     // Step 1. Convert input to standard coordinates.
 
@@ -796,168 +940,322 @@ TreeGrid::coverAccept ( const RectGeo & visitor ) const  {
     if ( out_of_bounds ) continue;
     // Step 2. Perform DFS on the Grid tree, recursing whenever we have intersection,
     //         (or adding leaf to output when we have leaf intersection)
+    int depth;
+    Tree::iterator start = coverStart ( & LB [ 0 ], & UB [ 0 ], workspace, & depth );
+    if ( start == treeEnd () ) continue;
+    ( this ->* kernel ) ( & LB [ 0 ], & UB [ 0 ], start, depth, workspace, & results );
+  }
+  //std::cout << "Returning from cover.\n";
 
-    for ( int d = 0; d < dimension_; ++ d ) {
-      NLB [ d ] = 0;
-      NUB [ d ] = INTPHASEWIDTH;
-    }
-    //std::cout << "C\n";
-    
-    /* Strategy.
-     We will take the Euler Tour using a 4-state machine.
-     There are Four states.
-     0 = Just Descended. Check for an intersection.
-     1 = Descend to the left
-     2 = Descend to right
-     3 = Rise.
-     */
-    
-    Tree::iterator root = tree () . begin ();
-    Tree::iterator N = root;
-    Tree::iterator tree_end = treeEnd ();
-    
-    char state = 0;
-    int depth = -1;
+  if ( periodic_flag ) {
+    // Remove duplicates if necessary. (This is needed only
+    // with periodicity)
+    std::sort ( results . begin (), results . end () );
+    results . erase ( std::unique ( results . begin (), results . end () ),
+                      results . end () );
+  }
+} // cover
 
+template < int D >
+inline void
+TreeGrid::coverKernel ( const int64_t * LB_in, 
+                        const int64_t * UB_in, 
+                        Tree::iterator start,
+                        int depth,
+                        CoverWorkspace * workspace,
+                        std::vector<GridElement> * results_ptr ) const {
+  std::vector<GridElement> & results = * results_ptr;
+  const int dim = ( D > 0 ) ? D : dimension_;
+  // If D is known the bounds are kept in local arrays, which the compiler
+  // may hold in registers; otherwise in the workspace.
+  std::array<int64_t, D> fixed_LB, fixed_UB, fixed_NLB, fixed_NUB;
+  const int64_t * LB = LB_in;
+  const int64_t * UB = UB_in;
+  int64_t * NLB = fixed_NLB . data ();
+  int64_t * NUB = fixed_NUB . data ();
+  if ( D > 0 ) {
+    std::copy ( LB_in, LB_in + dim, fixed_LB . begin () );
+    std::copy ( UB_in, UB_in + dim, fixed_UB . begin () );
+    std::copy ( workspace -> NLB . begin (), workspace -> NLB . end (), fixed_NLB . begin () );
+    std::copy ( workspace -> NUB . begin (), workspace -> NUB . end (), fixed_NUB . begin () );
+    LB = fixed_LB . data ();
+    UB = fixed_UB . data ();
+  } else {
+    NLB = & workspace -> NLB [ 0 ];
+    NUB = & workspace -> NUB [ 0 ];
+  }
+  std::stack<Tree::iterator, std::vector<Tree::iterator> > & 
+    parent = workspace -> parent;
+  std::stack<std::pair<Tree::iterator, Tree::iterator>, 
+             std::vector<std::pair<Tree::iterator, Tree::iterator> > > & 
+    children = workspace -> children;
 
-    if ( not parent . empty () ) {
-      abort ();
-    }
-    if ( not children . empty () ) {
-      abort ();
-    }
-    parent . push ( tree_end );
-
-    while ( 1 ) {
-      //std::cout << "Entering Loop, state = " << (int) state << "\n";
-      //std::cout << " N = " << *N << "\n";
-      if ( state == 0 ) {
-        ++ depth;
-
-        //std::cout << "State " << (int)state << "\n";
-        //std::cout << "Depth = " << depth << " \n";
-        //std::cout << " N = " << *N << "\n";
-        // If we have descended here, then we should check for intersection.
-        bool intersect_flag = true;
-        for ( int d = 0; d < dimension_; ++ d ) {
-          if ( LB[d] > NUB[d] || UB[d] < NLB [d] ) {  // INTERSECTION CHECK
-            intersect_flag = false;
-            break;
-          }
-        }
+  /* Strategy.
+   We will take the Euler Tour using a 4-state machine.
+   There are Four states.
+   0 = Just Descended. Check for an intersection.
+   1 = Descend to the left
+   2 = Descend to right
+   3 = Rise.
+   */
+  
+  Tree::iterator N = start;
+  Tree::iterator tree_end = treeEnd ();
+  
+  char state = 0;
+  // The division dimension, depth % dim, kept up to date as depth changes
+  // (depth starts one above "start")
+  int div_dim = ( depth + dim - 1 ) % dim;
+
+  while ( not parent . empty () ) parent . pop ();
+  while ( not children . empty () ) children . pop ();
+  parent . push ( tree_end );
+
+  while ( 1 ) {
+    if ( state == 0 ) {
+      if ( ++ div_dim == dim ) div_dim = 0;
+      // If we have descended here, then we should check for intersection.
+      bool miss = false;
+      for ( int d = 0; d < dim; ++ d ) {
+        miss |= ( LB[d] > NUB[d] ) | ( UB[d] < NLB [d] ); // INTERSECTION CHECK
+      }
+      
+      if ( not miss ) {
+        // Determine children
+        children . push ( std::make_pair ( left ( N ), 
+                                           right ( N ) ) );
         
-        if ( intersect_flag ) {
-          //std::cout << "Detected intersection.\n";
-          // Determine children
-          
-          children . push ( std::make_pair ( left ( N ), 
-                                             right ( N ) ) );
-          
-          // Check if its a leaf.
-          if ( children . top () . first == tree_end ) { 
-            if ( children . top () . second == tree_end ) {
-              // Here's what we are looking for.
-              iterator grid_it = TreeToGrid ( N );
-              if ( grid_it != end () ) results . push_back ( * grid_it ); 
-              // Issue the order to rise.
-              //std::cout << "Issue rise.\n";
-              state = 3;
-            } else {
-              // Issue the order to descend to the right.
-              //std::cout << "Issue descend right.\n";
-              state = 2;
-            }
+        // Check if its a leaf.
+        if ( children . top () . first == tree_end ) { 
+          if ( children . top () . second == tree_end ) {
+            // Here's what we are looking for.
+            iterator grid_it = TreeToGrid ( N );
+            if ( grid_it != end () ) results . push_back ( * grid_it ); 
+            // Issue the order to rise.
+            state = 3;
           } else {
-            // Issue the order to descend to the left.
-            //std::cout << "Issue descend left.\n";
-            state = 1;
+            // Issue the order to descend to the right.
+            state = 2;
           }
         } else {
-          // No intersection, issue order to rise.
-          children . push ( std::make_pair ( 0, 0 ) ); // dummy to be popped (PROFILED)
-          //std::cout << "No intersection. \n";
-          //std::cout << "Issue Rise.\n";
-          state = 3;
-        } // intersection check complete
-      } // state 0
-      
-      if ( state == 1 ) {
-        // We have been ordered to descend to the left.
-        //std::cout << "State " << (int)state << "\n";
-        //std::cout << "Depth = " << depth << " \n";
-        //std::cout << " N = " << *N << "\n";
-        //std::cout << "Descend left.\n";
-        int div_dim = depth % dimension ();
-        NUB[div_dim] -= ( (NUB[div_dim]-NLB[div_dim]) >> 1 );
-        parent . push ( N );
-        N = children . top () . first; //tree () . left ( N ) ;
-        state = 0;
-        continue;
-      } // state 1
-      
-      if ( state == 2 ) {
-        // We have been ordered to descend to the right.
-        //std::cout << "State " << (int)state << "\n";
-        //std::cout << "Depth = " << depth << " \n";
-        //std::cout << " N = " << *N << "\n";
-        //std::cout << "Descend right.\n";
-        int div_dim = depth % dimension ();
-        NLB[div_dim] += ( (NUB[div_dim]-NLB[div_dim]) >> 1 );
-        parent . push ( N );
-        N = children . top () . second; //tree () . right ( N ) ;
-        state = 0;
-        continue;
-      } // state 2
-      
-      if ( state == 3 ) {
-        // We have been ordered to rise.
-        //std::cout << "State " << (int)state << "\n";
-        //std::cout << "Depth = " << depth << " \n";
-        //std::cout << " N = " << *N << "\n";
-        //std::cout << "Rise.\n";
-        Tree::iterator P = parent . top (); //tree () . parent ( N );
-        parent . pop ();
-        children . pop ();
-        // Can't rise if root.
-        if ( P == tree_end ) break; // algorithm complete
-
-        -- depth;
-        int div_dim = depth % dimension ();
-        if ( children . top () . first == N ) { //tree () . left ( P )  == N ) {
-          // This is a left child.
-          //std::cout << "We are rising from left.\n";
-          NUB[div_dim] += NUB[div_dim]-NLB[div_dim];
-          // If we rise from the left child, we order parent to go right.
-          // Unless there is no right child.
-          if ( children . top () . second == tree_end ) state = 3; //tree () . right ( P ) == end ) state = 3;
-          else state = 2;
-        } else {
-          // This is the right child.
-          //std::cout << "We are rising from right.\n";
-          NLB[div_dim] -= NUB[div_dim]-NLB[div_dim];
-          // If we rise from the right child, we order parent to rise.
-          state = 3;
+          // Issue the order to descend to the left.
+          state = 1;
         }
-        N = P;
-      } // state 3
-      
-    } // while loop
+      } else {
+        // No intersection, issue order to rise.
+        children . push ( std::make_pair ( 0, 0 ) ); // dummy to be popped (PROFILED)
+        state = 3;
+      } // intersection check complete
+    } // state 0
+    
+    if ( state == 1 ) {
+      // We have been ordered to descend to the left.
+      NUB[div_dim] -= ( (NUB[div_dim]-NLB[div_dim]) >> 1 );
+      parent . push ( N );
+      N = children . top () . first; //tree () . left ( N ) ;
+      state = 0;
+      continue;
+    } // state 1
+    
+    if ( state == 2 ) {
+      // We have been ordered to descend to the right.
+      NLB[div_dim] += ( (NUB[div_dim]-NLB[div_dim]) >> 1 );
+      parent . push ( N );
+      N = children . top () . second; //tree () . right ( N ) ;
+      state = 0;
+      continue;
+    } // state 2
+    
+    if ( state == 3 ) {
+      // We have been ordered to rise.
+      Tree::iterator P = parent . top (); //tree () . parent ( N );
+      parent . pop ();
+      children . pop ();
+      // Can't rise above start.
+      if ( P == tree_end ) break; // algorithm complete
+
+      if ( div_dim -- == 0 ) div_dim = dim - 1;
+      if ( children . top () . first == N ) { //tree () . left ( P )  == N ) {
+        // This is a left child.
+        NUB[div_dim] += NUB[div_dim]-NLB[div_dim];
+        // If we rise from the left child, we order parent to go right.
+        // Unless there is no right child.
+        if ( children . top () . second == tree_end ) state = 3; //tree () . right ( P ) == end ) state = 3;
+        else state = 2;
+      } else {
+        // This is the right child.
+        NLB[div_dim] -= NUB[div_dim]-NLB[div_dim];
+        // If we rise from the right child, we order parent to rise.
+        state = 3;
+      }
+      N = P;
+    } // state 3
+    
+  } // while loop
+} // coverKernel
+
+inline Tree::iterator
+TreeGrid::coverStart ( const int64_t * LB, 
+                       const int64_t * UB, 
+                       CoverWorkspace * workspace,
+                       int * depth ) const {
+  const int dim = dimension_;
+  std::vector<int64_t> & NLB = workspace -> NLB; NLB . assign ( dim, 0 );
+  std::vector<int64_t> & NUB = workspace -> NUB; NUB . assign ( dim, INTPHASEWIDTH );
+  * depth = 0;
+  const CoverIndex * index = workspace -> index;
+  if ( index == NULL || index -> grid != this || dim == 0 ) return treeBegin ();
+
+  // In dimension d the boxes of depth l are the intervals
+  // [ j w, ( j + 1 ) w ] with w = 2^60 / 2^b, b = ( number of divisions of
+  // dimension d above depth l ), and [ LB, UB ] meets those with x >> s <= j
+  // <= y >> s, s = 60 - b, where x and y are below. So it lies in a single
+  // one while b does not exceed the number of leading bits x and y share.
+  // Dimension d is divided at the depths d, d + dim, d + 2 dim, ...
+  int level = index -> depth;
+  for ( int d = 0; d < dim; ++ d ) {
+    uint64_t x = ( LB [ d ] > 0 ) ? LB [ d ] - 1 : 0;
+    uint64_t y = std::min ( UB [ d ], INTPHASEWIDTH - 1 );
+    if ( x > y ) return treeBegin ();
+    int shared = 60;
+    for ( uint64_t diff = x ^ y; diff != 0; diff >>= 1 ) -- shared;
+    level = std::min ( level, shared * dim + d );
   }
-  //std::cout << "Returning from cover.\n";
 
-  if ( periodic_flag ) {
-    // Remove duplicates if necessary. (This is needed only
-    // with periodicity)
-    std::vector<Grid::GridElement> sorted_results;
-    std::swap ( sorted_results, results );
-    std::sort ( sorted_results . begin (), 
-                sorted_results . end () );
-    std::unique_copy ( sorted_results . begin (), 
-                       sorted_results . end (),
-                       std::back_inserter(results) );
+  // Find the node, or if the tree is shallower there, its deepest ancestor
+  // in the tree; "code" is the path to it as in CoverIndex::nodes
+  uint64_t code = 0;
+  for ( int l = 0; l < level; ++ l ) {
+    int d = l % dim;
+    int b = l / dim;   // divisions of dimension d above depth l
+    uint64_t x = ( LB [ d ] > 0 ) ? LB [ d ] - 1 : 0;
+    code = ( code << 1 ) | ( ( x >> ( 59 - b ) ) & 1 );
   }
-  return results;
-} // cover
+  Tree::iterator tree_end = treeEnd ();
+  Tree::iterator node = index -> nodes [ ( (uint64_t) 1 << level ) + code ];
+  while ( node == tree_end ) {
+    -- level;
+    code >>= 1;
+    node = index -> nodes [ ( (uint64_t) 1 << level ) + code ];
+    // Unless it is a leaf, the ancestor lacks the child towards [ LB, UB ]
+    if ( node != tree_end && 
+         ( left ( node ) != tree_end || right ( node ) != tree_end ) ) {
+      return tree_end;
+    }
+  }
+  * depth = level;
+  for ( int d = 0; d < dim; ++ d ) {
+    int b = level / dim + ( ( d < level % dim ) ? 1 : 0 );
+    if ( b == 0 ) continue;
+    uint64_t x = ( LB [ d ] > 0 ) ? LB [ d ] - 1 : 0;
+    uint64_t j = x >> ( 60 - b );
+    NLB [ d ] = j << ( 60 - b );
+    NUB [ d ] = ( j + 1 ) << ( 60 - b );
+  }
+  return node;
+}
+
+inline void
+TreeGrid::buildCoverIndex ( CoverIndex * index, int depth ) const {
+  if ( depth < 0 ) {
+    depth = 0;
+    while ( depth < 20 && ( (uint64_t) 1 << depth ) < size () ) ++ depth;
+  }
+  index -> grid = this;
+  index -> depth = depth;
+  Tree::iterator tree_end = treeEnd ();
+  index -> nodes . assign ( (uint64_t) 2 << depth, tree_end );
+  // Depth first, with positions ( 2^l + c ) in the stack
+  std::vector<std::pair<Tree::iterator, uint64_t> > work;
+  work . push_back ( std::make_pair ( treeBegin (), (uint64_t) 1 ) );
+  while ( not work . empty () ) {
+    Tree::iterator node = work . back () . first;
+    uint64_t position = work . back () . second;
+    work . pop_back ();
+    index -> nodes [ position ] = node;
+    if ( position >= ( (uint64_t) 1 << depth ) ) continue;
+    Tree::iterator left_child = left ( node );
+    Tree::iterator right_child = right ( node );
+    if ( right_child != tree_end ) work . push_back ( std::make_pair ( right_child, 2 * position + 1 ) );
+    if ( left_child != tree_end ) work . push_back ( std::make_pair ( left_child, 2 * position ) );
+  }
+}
+
+inline void
+TreeGrid::hilbertOrder ( std::vector<GridElement> * order ) const {
+  order -> clear ();
+  if ( size () == 0 ) return;
+  int dim = dimension ();
+  int bits = std::min ( 63, 64 / dim );
+  std::vector<std::pair<uint64_t, GridElement> > keys;
+  keys . reserve ( size () );
+  // Depth first, with the lower corner of each node on the stack (dim
+  // coordinates per node, left-aligned to "bits" bits) in "corners"
+  std::vector<std::pair<Tree::iterator, int> > work;
+  std::vector<uint64_t> corners ( dim, 0 );
+  std::vector<uint64_t> X ( dim );
+  Tree::iterator tree_end = treeEnd ();
+  work . push_back ( std::make_pair ( treeBegin (), 0 ) );
+  while ( not work . empty () ) {
+    Tree::iterator node = work . back () . first;
+    int depth = work . back () . second;
+    work . pop_back ();
+    std::copy ( corners . end () - dim, corners . end (), X . begin () );
+    corners . resize ( corners . size () - dim );
+    if ( tree () . isLeaf ( node ) ) {
+      GridElement ge = * TreeToGrid ( node );
+      keys . push_back ( std::make_pair ( hilbertKey ( & X [ 0 ], dim, bits ), ge ) );
+      continue;
+    }
+    int d = depth % dim;
+    int level = depth / dim;
+    Tree::iterator left_child = left ( node );
+    Tree::iterator right_child = right ( node );
+    if ( right_child != tree_end ) {
+      work . push_back ( std::make_pair ( right_child, depth + 1 ) );
+      corners . insert ( corners . end (), X . begin (), X . end () );
+      if ( level < bits ) corners [ corners . size () - dim + d ] |= (uint64_t) 1 << ( bits - 1 - level );
+    }
+    if ( left_child != tree_end ) {
+      work . push_back ( std::make_pair ( left_child, depth + 1 ) );
+      corners . insert ( corners . end (), X . begin (), X . end () );
+    }
+  }
+  std::sort ( keys . begin (), keys . end () );
+  order -> resize ( keys . size () );
+  for ( size_t i = 0; i < keys . size (); ++ i ) (*order) [ i ] = keys [ i ] . second;
+}
+
+inline uint64_t
+TreeGrid::hilbertKey ( uint64_t * X, int dim, int bits ) {
+  // J. Skilling, "Programming the Hilbert curve" (2004): turn the axes
+  // into the "transposed" Hilbert index, then interleave its bits.
+  uint64_t M = (uint64_t) 1 << ( bits - 1 );
+  for ( uint64_t Q = M; Q > 1; Q >>= 1 ) {
+    uint64_t P = Q - 1;
+    for ( int i = 0; i < dim; ++ i ) {
+      if ( X [ i ] & Q ) {
+        X [ 0 ] ^= P;
+      } else {
+        uint64_t t = ( X [ 0 ] ^ X [ i ] ) & P;
+        X [ 0 ] ^= t;
+        X [ i ] ^= t;
+      }
+    }
+  }
+  for ( int i = 1; i < dim; ++ i ) X [ i ] ^= X [ i - 1 ];
+  uint64_t t = 0;
+  for ( uint64_t Q = M; Q > 1; Q >>= 1 ) {
+    if ( X [ dim - 1 ] & Q ) t ^= Q - 1;
+  }
+  uint64_t key = 0;
+  for ( int b = bits - 1; b >= 0; -- b ) {
+    for ( int i = 0; i < dim; ++ i ) {
+      key = ( key << 1 ) | ( ( ( X [ i ] ^ t ) >> b ) & 1 );
+    }
+  }
+  return key;
+}
 
 inline std::vector<Grid::GridElement>
 TreeGrid::coverAccept ( const PrismGeo & visitor ) const {
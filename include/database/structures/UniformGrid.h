@@ -8,6 +8,7 @@
 #include <sstream>
 #include <string>
 #include <cmath>
+#include <utility>
 #include <boost/foreach.hpp>
 #include <boost/iterator/counting_iterator.hpp>
 #include <boost/unordered_map.hpp>
@@ -59,6 +60,12 @@ public:
   const std::vector < uint64_t > & sizes ( void ) const;
   uint64_t width ( int d ) const;
   int dimension ( void ) const;
+
+  /// coverRange
+  ///   Return the range [first, last) of coordinates in dimension d of the
+  ///   grid elements met by the interval [lower, upper]. "cover" returns the
+  ///   product of these ranges.
+  std::pair<int64_t, int64_t> coverRange ( int d, double lower, double upper ) const;
 private:
   RectGeo bounds_;
   std::vector<uint64_t> sizes_;
@@ -156,21 +163,11 @@ UniformGrid::cover ( const Geo & geo ) const {
   uint64_t address = 0;
   //std::cout << "   ";
   for ( int d = 0; d < dimension (); ++ d ) {
-    lower_coordinates [ d ] = (int64_t) std::ceil ( (double) width ( d ) *
-                              (rect.lower_bounds[d]-bounds_.lower_bounds[d])/
-                              (bounds_.upper_bounds[d]-bounds_.lower_bounds[d]) - 1.0);
-    upper_coordinates [ d ] = (int64_t) std::floor ( (double) width ( d ) *
-                              (rect.upper_bounds[d]-bounds_.lower_bounds[d])/
-                              (bounds_.upper_bounds[d]-bounds_.lower_bounds[d]) + 1.0 );
-    if ( lower_coordinates [ d ] < 0 ) 
-        lower_coordinates [ d ] = 0;
-    if ( upper_coordinates [ d ] > (int64_t) sizes_ [ d ] ) 
-        upper_coordinates [ d ] = (int64_t) sizes_ [ d ];
-
+    std::pair<int64_t, int64_t> range = 
+      coverRange ( d, rect.lower_bounds[d], rect.upper_bounds[d] );
+    lower_coordinates [ d ] = range . first;
+    upper_coordinates [ d ] = range . second;
     address += multipliers_ [ d ] * lower_coordinates [ d ];
-    //if ( d != 0 ) std::cout << " x ";
-    //std::cout << "[" << lower_coordinates[d]<<", "<<upper_coordinates[d]<<")";
-    //std::cout << "[" << lower_coordinates[d]<<", "<<upper_coordinates[d]<<")";
   }
 
   //std::cout << "\n";
@@ -200,6 +197,19 @@ UniformGrid::cover ( const Geo & geo ) const {
   return result;
 }
 
+inline std::pair<int64_t, int64_t>
+UniformGrid::coverRange ( int d, double lower, double upper ) const {
+  int64_t first = (int64_t) std::ceil ( (double) width ( d ) *
+                  (lower-bounds_.lower_bounds[d])/
+                  (bounds_.upper_bounds[d]-bounds_.lower_bounds[d]) - 1.0);
+  int64_t last = (int64_t) std::floor ( (double) width ( d ) *
+                 (upper-bounds_.lower_bounds[d])/
+                 (bounds_.upper_bounds[d]-bounds_.lower_bounds[d]) + 1.0 );
+  if ( first < 0 ) first = 0;
+  if ( last > (int64_t) sizes_ [ d ] ) last = (int64_t) sizes_ [ d ];
+  return std::make_pair ( first, last );
+}
+
 inline uint64_t UniformGrid::memory ( void ) const {
   uint64_t result = 0;
   // TODO -- not needed immediately
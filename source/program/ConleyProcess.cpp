@@ -17,6 +17,7 @@
 #include "database/structures/Database.h"
 #include "database/program/Configuration.h"
 #include "database/program/ConleyProcess.h"
+#include "database/program/MorseGridLog.h"
 #include "database/program/jobs/Conley_Index_Job.h"
 
 #include "Model.h"
@@ -55,6 +56,11 @@ void ConleyProcess::initialize ( void ) {
   std::string appendstring ( "/database.mdb" );
   database . load ( (filestring + appendstring) . c_str () );
 
+  // Morse graphs stored by the Morse process spare the jobs recomputing them
+  grids_filename_ = filestring + "/database.grids";
+  uint64_t num_stored = MorseGridLog::index ( grids_filename_, &grid_offsets_ );
+  std::cout << "Found " << num_stored << " stored Morse graphs.\n";
+
   num_incc_ = database . INCC_Records () . size ();
   finished_ . resize ( num_incc_, false );
   attempts_ . resize ( num_incc_, 0 );
@@ -154,6 +160,13 @@ int ConleyProcess::prepare ( Message & job ) {
 
   size_t job_number = num_jobs_sent_;
 
+  // The stored Morse graph of the representative, if any
+  std::string morse_graph_bytes;
+  if ( grid_offsets_ . count ( pi ) ) {
+    std::ifstream grids ( grids_filename_ . c_str (), std::ios::in | std::ios::binary );
+    MorseGridLog::read ( grids, grid_offsets_ [ pi ], &morse_graph_bytes );
+  }
+
   std::shared_ptr<Parameter> parameter = 
     parameter_space_ -> parameter ( pi );
   job << job_number;
@@ -164,6 +177,8 @@ int ConleyProcess::prepare ( Message & job ) {
   job << config.PHASE_SUBDIV_MIN;
   job << config.PHASE_SUBDIV_MAX;
   job << config.PHASE_SUBDIV_LIMIT;
+  job << config.mapGraphSettings ();
+  job << morse_graph_bytes;
 
   std::cout << "Preparing conley job " << job_number 
             << " with parameter = " << *parameter << "  and  ms = (" <<  ms << ")\n";
@@ -21,6 +21,8 @@
 #ifdef COMPUTE_CONTINUATION
 #include "Model.h"
 #include "database/structures/Database.h"
+#include "database/program/Configuration.h"
+#include "database/program/MorseGridLog.h"
 #endif
 #ifdef COMPUTE_CONLEY_INDEX
 #include "database/program/ConleyProcess.h"
@@ -65,6 +67,8 @@ int main ( int argc, char * argv [] ) {
   int comm_rank;
   MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
   if ( comm_rank == 0 ) {
+    Configuration config;
+    config . loadFromFile ( argv[1] );
     Database database;
     {
     std::string filestring ( argv[1] );
@@ -72,12 +76,26 @@ int main ( int argc, char * argv [] ) {
     database . load ( (filestring + appendstring) . c_str () );
     }
     //database . removeBadBoxes<ModelMap> ();
-    database . postprocess ();
+    database . postprocess ( config.CONTINUATION_THREADS );
     {
     std::string filestring ( argv[1] );
     std::string appendstring ( "/database.mdb" );
     database . save ( (filestring + appendstring) . c_str () );
     }
+    // Keep the grids of only the representatives the Conley process uses
+    if ( config.GRIDS_STORE == "reps" ) {
+      typedef std::pair<uint64_t, std::pair<uint64_t, uint64_t> > Representative;
+      boost::unordered_set<uint64_t> representatives;
+      BOOST_FOREACH ( const INCC_Record & incc_record, database . INCC_Records () ) {
+        BOOST_FOREACH ( const Representative & rep, incc_record . smallest_reps ) {
+          representatives . insert ( rep . second . first );
+        }
+      }
+      std::string filestring ( argv[1] );
+      std::string appendstring ( "/database.grids" );
+      uint64_t num_kept = MorseGridLog::filter ( filestring + appendstring, representatives );
+      std::cout << "Kept the grids of " << num_kept << " representative parameters.\n";
+    }
   }
 #endif
 
@@ -8,14 +8,24 @@
 #include <cmath>
 #include <exception>
 #include <vector>
+#include <algorithm>
+#include <string>
+#include <sstream>
 
 #include <memory>
 #include "boost/thread.hpp"
 #include "boost/chrono/chrono_io.hpp"
+#include "boost/foreach.hpp"
+#include "boost/unordered_set.hpp"
 
 #include "database/program/Configuration.h"
 #include "database/program/MorseProcess.h"
+#include "database/program/ResultLog.h"
+#include "database/program/MorseGridLog.h"
+#include "database/algorithms/parallelFor.h"
 #include "database/program/jobs/Clutching_Graph_Job.h"
+#include "database/program/jobs/Morse_Graph_Job.h"
+#include "database/program/jobs/Clutching_Pair_Job.h"
 #include "database/structures/Database.h"
 
 #include "Model.h"
@@ -38,11 +48,47 @@ void MorseProcess::initialize ( void ) {
   // Checkpoint/Progress variable initialization
   time_of_last_checkpoint_ = clock();
   time_of_last_progress_report_ = clock ();
+  start_time_ = boost::chrono::steady_clock::now ();
   progress_bar_ = 0;
   num_jobs_ = 0;
   num_jobs_sent_ = 0;
+  num_patches_skipped_ = 0;
   checkpoint_timer_running_ = false;
 
+  // Recover results of a previous run, if any. The result log holds every
+  // job result received so far; database.raw is the full archive written
+  // when a run finishes (or an hourly checkpoint of older versions).
+  std::string log_filename = std::string ( argv[1] ) + "/database.log";
+  std::string raw_filename = std::string ( argv[1] ) + "/database.raw";
+  uint64_t num_replayed = ResultLog::replay ( log_filename, &database );
+  if ( num_replayed > 0 ) {
+    std::cout << "MorseProcess::initialize. Replayed " << num_replayed 
+              << " job results from " << log_filename << ".\n";
+  } else if ( std::ifstream ( raw_filename . c_str () ) . good () ) {
+    std::cout << "MorseProcess::initialize. Resuming from " << raw_filename << ".\n";
+    database . load ( raw_filename . c_str () );
+  }
+  result_log_ . open ( log_filename );
+  if ( num_replayed == 0 && not database . parameter_records () . empty () ) {
+    // Seed the new log so a later resume does not depend on database.raw
+    result_log_ . append ( database );
+  }
+
+  // Morse graphs stored with their grids by a previous run are not stored again
+  if ( config.GRIDS_STORE != "none" ) {
+    std::string grids_filename = std::string ( argv[1] ) + "/database.grids";
+    MorseGridLog::Index offsets;
+    uint64_t num_stored = MorseGridLog::index ( grids_filename, &offsets );
+    BOOST_FOREACH ( const MorseGridLog::Index::value_type & entry, offsets ) {
+      stored_grids_ . insert ( entry . first );
+    }
+    if ( num_stored > 0 ) {
+      std::cout << "MorseProcess::initialize. Found " << stored_grids_ . size () 
+                << " Morse graphs with grids in " << grids_filename << ".\n";
+    }
+    grid_log_ . open ( grids_filename );
+  }
+
   // Construct Parameter Space
   std::cout << "MorseProcess::initialize. Obtaining parameter space.\n";
   parameter_space_ = model . parameterSpace ();
@@ -52,26 +98,146 @@ void MorseProcess::initialize ( void ) {
   std::cout << "MorseProcess::initialize. Serializing parameter space.\n";
   database . insert ( parameter_space_ );
 
-  // Count number of patches
-  std::cout << "MorseProcess::initialize. Iterating through patches.\n";
+  // Index the results already present
+  BOOST_FOREACH ( const ParameterRecord & record, database . parameter_records () ) {
+    computed_parameters_ . insert ( record . parameter_index );
+  }
+  BOOST_FOREACH ( const ClutchingRecord & record, database . clutch_records () ) {
+    computed_clutchings_ . insert ( std::make_pair ( record . parameter_index_1, 
+                                                     record . parameter_index_2 ) );
+    computed_clutchings_ . insert ( std::make_pair ( record . parameter_index_2, 
+                                                     record . parameter_index_1 ) );
+  }
+
+  box_schedule_ = ( config.PARAM_SCHEDULE == "box" );
+  num_box_calculations_ = 0;
+  box_calculated_ . assign ( parameter_space_ -> size (), false );
   size_t num_calc = 0;
-  while ( 1 ) {
-    std::shared_ptr<ParameterPatch> p = parameter_space_ -> patch ();
-    if ( not p ) {
-      throw std::logic_error("Error. MorseProcess::initialize. Unable to obtain patch from parameter space.\n");
-    }
-    if ( p -> empty () ) break;
-    ++ num_jobs_;
-    num_calc += p -> vertices . size ();
+  size_t num_skipped = 0;
+  if ( box_schedule_ ) {
+    initializeBoxSchedule ( &num_calc, &num_skipped );
+  } else {
+    initializePatchSchedule ( &num_calc );
   }
   
   // Output to the user about the upcoming database calculation
   std::cout << "MorseProcess initialized. \n";
   std::cout << "  There are " << parameter_space_ -> size () << " parameters.\n";
+  if ( num_skipped > 0 ) {
+    std::cout << "  " << num_skipped << " jobs were completed by a previous run and will be skipped.\n";
+  }
   std::cout << "  There are " << num_jobs_ << " jobs.\n";
   std::cout << "  Within those jobs, there are " << num_calc << " parameter box calculations to be done.\n";
-  std::cout << "  On average, a single parameter box calculation will be done " << 
-    (double) num_calc  / (double) parameter_space_ -> size ()  << " times.\n";
+  std::cout << "  Duplicate-work ratio (parameter box calculations per parameter box): " << 
+    (double) num_calc  / (double) parameter_space_ -> size ()  << "\n";
+}
+
+/* * * * * * * * * * * * * * * * * * * * * */
+/* initializePatchSchedule definition      */
+/* * * * * * * * * * * * * * * * * * * * * */
+void MorseProcess::initializePatchSchedule ( size_t * num_calc ) {
+  // Count the patches without building them. Patches are then drawn one
+  // at a time as jobs are prepared, so the first jobs go out right away.
+  std::cout << "MorseProcess::initialize. Counting patches.\n";
+  uint64_t num_patches, num_vertices;
+  parameter_space_ -> countPatches ( & num_patches, & num_vertices );
+  num_jobs_ = num_patches;
+  * num_calc = num_vertices;
+  advancePatch ();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * */
+/* advancePatch definition                 */
+/* * * * * * * * * * * * * * * * * * * * * */
+void MorseProcess::advancePatch ( void ) {
+  // Draw patches until one is found whose results are not all present
+  // (from a previous run), or the sequence ends
+  while ( 1 ) {
+    next_patch_ = parameter_space_ -> patch ();
+    if ( not next_patch_ ) {
+      throw std::logic_error("Error. MorseProcess::advancePatch. Unable to obtain patch from parameter space.\n");
+    }
+    if ( next_patch_ -> empty () ) {
+      next_patch_ . reset ();
+      return;
+    }
+    if ( computed_parameters_ . empty () ) return;
+    bool done = true;
+    BOOST_FOREACH ( uint64_t vertex, next_patch_ -> vertices ) {
+      if ( computed_parameters_ . count ( vertex ) == 0 ) { done = false; break; }
+    }
+    typedef std::pair<uint64_t, uint64_t> Edge;
+    if ( done ) {
+      BOOST_FOREACH ( const Edge & edge, next_patch_ -> edges ) {
+        if ( computed_clutchings_ . count ( edge ) == 0 ) {
+          done = false; 
+          break;
+        }
+      }
+    }
+    if ( not done ) return;
+    ++ num_patches_skipped_;
+    -- num_jobs_;
+  }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * */
+/* initializeBoxSchedule definition        */
+/* * * * * * * * * * * * * * * * * * * * * */
+void MorseProcess::initializeBoxSchedule ( size_t * num_calc, size_t * num_skipped ) {
+  // A box is skipped if a previous run stored its Morse graph and the 
+  // clutching graphs of all its edges. Every other box is computed, and 
+  // every edge between two computed boxes gets a clutching job.
+  std::cout << "MorseProcess::initialize. Iterating through parameter boxes.\n";
+  uint64_t N = parameter_space_ -> size ();
+  box_state_ . assign ( N, BOX_DONE );
+  BOOST_FOREACH ( uint64_t v, * parameter_space_ ) {
+    if ( computed_parameters_ . count ( v ) == 0 ) {
+      box_state_ [ v ] = BOX_TODO;
+      continue;
+    }
+    BOOST_FOREACH ( uint64_t u, parameter_space_ -> adjacencies ( v ) ) {
+      if ( u != v && computed_clutchings_ . count ( std::make_pair ( u, v ) ) == 0 ) {
+        box_state_ [ v ] = BOX_TODO;
+        break;
+      }
+    }
+  }
+  pending_neighbors_ . resize ( N );
+  pending_count_ . resize ( N, 0 );
+  std::vector<uint64_t> boxes;
+  uint64_t num_edges = 0;
+  BOOST_FOREACH ( uint64_t v, * parameter_space_ ) {
+    if ( box_state_ [ v ] == BOX_DONE ) {
+      ++ * num_skipped;
+      continue;
+    }
+    boxes . push_back ( v );
+    BOOST_FOREACH ( uint64_t u, parameter_space_ -> adjacencies ( v ) ) {
+      if ( u > v && box_state_ [ u ] == BOX_TODO ) {
+        pending_neighbors_ [ v ] . push_back ( u );
+        pending_neighbors_ [ u ] . push_back ( v );
+        ++ num_edges;
+      }
+    }
+  }
+  // Nothing is known about costs before the first results arrive, so every
+  // box is predicted at the same (mean) cost and the first jobs go out in
+  // the order of the parameter space. We keep that order rather than seed
+  // the schedule with a spread-out sample: neighboring boxes then arrive
+  // close together, their clutching jobs are sent early and the Morse graphs
+  // held for them are released. Observed costs reorder the rest.
+  scheduler_ . initialize ( boxes, N );
+  num_grid_cells_ = 0;
+  // A configured thread count of 0 is resolved by each worker on its own
+  // machine; until one reports back, assume a single thread
+  worker_threads_ = std::max ( config.PARAM_THREADS, 1 );
+  // The number of Morse graph jobs depends on how boxes get batched, and is
+  // corrected as they are sent out; start from one box per job.
+  num_jobs_ = boxes . size () + num_edges;
+  * num_calc = boxes . size ();
+  std::cout << "MorseProcess::initialize. " << boxes . size () << " parameter boxes and " 
+            << num_edges << " clutching jobs.\n";
 }
 
 /* * * * * * * * * * * */
@@ -82,51 +248,151 @@ int MorseProcess::prepare ( Message & job ) {
   
   if ( progress_bar_ == num_jobs_ ) return 1; // nothing to compute
 
-  if ( not checkpoint_timer_running_  || num_jobs_sent_ == num_jobs_ ) {
+  if ( not checkpoint_timer_running_ || not jobReady () ) {
     job << (uint64_t) 0; // Checkpoint timer job
     checkpoint_timer_running_ = true;
     return 0;
-  } else {
-    job << (uint64_t) 1; // Conley Job
-  }
+  } 
 
   // Job number (job id) of job to be sent
   size_t job_number = num_jobs_sent_;
   std::cout << "MorseProcess::prepare: Preparing job " << job_number << "\n";
+
+  if ( box_schedule_ ) {
+    prepareBoxJob ( job, job_number );
+  } else {
+    preparePatchJob ( job, job_number );
+  }
+
+  /// Increment the jobs_sent counter
+  ++num_jobs_sent_;
   
-  // Obtain patch 
-  std::shared_ptr<ParameterPatch> patch = parameter_space_ -> patch ();
+  /// A new job was prepared and sent
+  return 0;
+}
+
+bool MorseProcess::jobReady ( void ) const {
+  if ( not box_schedule_ ) return (bool) next_patch_;
+  return ( not clutch_queue_ . empty () ) || not scheduler_ . empty ();
+}
+
+void MorseProcess::preparePatchJob ( Message & job, size_t job_number ) {
+  job << (uint64_t) 1; // Clutching Graph Job
+
+  // Take the next patch and draw the one after it
+  std::shared_ptr<ParameterPatch> patch = next_patch_;
+  advancePatch ();
   
   // prepare the message with the job to be sent
   job << job_number;
+  job << config.PARAM_TIME_LIMIT;
   job << patch;
   job << config.PHASE_SUBDIV_INIT;
   job << config.PHASE_SUBDIV_MIN;
   job << config.PHASE_SUBDIV_MAX;
   job << config.PHASE_SUBDIV_LIMIT;
+  job << config.mapGraphSettings ();
+  job << config.PARAM_THREADS;
+  job << (bool) ( config.GRIDS_STORE != "none" );
+}
 
-  /// Increment the jobs_sent counter
-  ++num_jobs_sent_;
-  
-  /// A new job was prepared and sent
-  return 0;
+void MorseProcess::prepareBoxJob ( Message & job, size_t job_number ) {
+  // Clutching jobs go first so that stored Morse graphs are released early
+  if ( not clutch_queue_ . empty () ) {
+    uint64_t u = clutch_queue_ . front () . first;
+    uint64_t v = clutch_queue_ . front () . second;
+    clutch_queue_ . pop_front ();
+    job << (uint64_t) 3; // Clutching Pair Job
+    job << job_number;
+    job << u;
+    job << v;
+    job << morse_graph_bytes_ [ u ];
+    job << morse_graph_bytes_ [ v ];
+    releaseEdge ( u, v );
+    return;
+  }
+  // Next batch of boxes, most expensive first, sized by predicted cost.
+  // A worker computes "threads" boxes of a batch at a time, so it gets at
+  // least that many and proportionally more work.
+  int threads = worker_threads_;
+  std::vector<uint64_t> boxes = 
+    scheduler_ . batch ( config.PARAM_COST_TARGET * threads, 
+                         config.PARAM_COST_DEADLINE * threads,
+                         threads );
+  num_jobs_ -= boxes . size () - 1;
+  std::vector<std::shared_ptr<Parameter> > parameters;
+  BOOST_FOREACH ( uint64_t v, boxes ) {
+    parameters . push_back ( parameter_space_ -> parameter ( v ) );
+  }
+  boxes_of_job_ [ job_number ] = boxes;
+  job << (uint64_t) 2; // Morse Graph Job
+  job << job_number;
+  job << config.PARAM_TIME_LIMIT;
+  job << boxes;
+  job << parameters;
+  job << config.PHASE_SUBDIV_INIT;
+  job << config.PHASE_SUBDIV_MIN;
+  job << config.PHASE_SUBDIV_MAX;
+  job << config.PHASE_SUBDIV_LIMIT;
+  job << config.mapGraphSettings ();
+  job << config.PARAM_THREADS;
+}
+
+void MorseProcess::releaseEdge ( uint64_t u, uint64_t v ) {
+  // Each endpoint keeps its Morse graph until all of its edges are released
+  uint64_t endpoint [ 2 ] = { u, v };
+  for ( int i = 0; i < 2; ++ i ) {
+    uint64_t w = endpoint [ i ];
+    if ( -- pending_count_ [ w ] == 0 ) morse_graph_bytes_ . erase ( w );
+  }
 }
- 
-struct ClutchingJobWorkThread {
+
+void MorseProcess::storeGrids ( uint64_t v, const std::string & code_bytes ) {
+  if ( not grid_log_ . is_open () || code_bytes . empty () ) return;
+  if ( not stored_grids_ . insert ( v ) . second ) return;
+  grid_log_ . append ( v, code_bytes );
+}
+
+void MorseProcess::acceptMorseGraph ( uint64_t v, const std::string & morse_graph_bytes ) {
+  box_state_ [ v ] = BOX_ARRIVED;
+  pending_count_ [ v ] = pending_neighbors_ [ v ] . size ();
+  if ( not morse_graph_bytes . empty () ) morse_graph_bytes_ [ v ] = morse_graph_bytes;
+  BOOST_FOREACH ( uint64_t u, pending_neighbors_ [ v ] ) {
+    if ( box_state_ [ u ] != BOX_ARRIVED ) continue;
+    if ( morse_graph_bytes_ . count ( u ) && morse_graph_bytes_ . count ( v ) ) {
+      clutch_queue_ . push_back ( std::make_pair ( std::min ( u, v ), std::max ( u, v ) ) );
+    } else {
+      // No Morse graph at one end (no map, or the job timed out)
+      -- num_jobs_;
+      releaseEdge ( u, v );
+    }
+  }
+  if ( pending_count_ [ v ] == 0 ) morse_graph_bytes_ . erase ( v );
+  // Neighbors arriving later will find this box marked as arrived
+  std::vector<uint64_t> ( ) . swap ( pending_neighbors_ [ v ] );
+}
+
+struct MorseJobWorkThread {
   Message * result;
   const Message * job;
   bool * computed;
   const Model * model;
-  ClutchingJobWorkThread
+  uint64_t job_type;
+  MorseJobWorkThread
             ( Message * result, 
               const Message * job,
               bool * computed,
-              const Model * model ) 
-  : result(result), job(job), computed(computed), model(model) {}
+              const Model * model,
+              uint64_t job_type ) 
+  : result(result), job(job), computed(computed), model(model), job_type(job_type) {}
 
   void operator () ( void ) {
     try {
-      Clutching_Graph_Job ( result , *job, *model );
+      if ( job_type == 1 ) {
+        Clutching_Graph_Job ( result , *job, *model );
+      } else {
+        Morse_Graph_Job ( result, *job, *model );
+      }
       *computed = true;
     } catch ( std::logic_error& e ) {
       throw e;
@@ -150,24 +416,47 @@ void MorseProcess::work ( Message & result, const Message & job ) const {
     result << (uint64_t) 0;
     break;
   case 1:
+  case 2:
     std::cout << "MorseProcess::work. Normal Job detected.\n";
-    result << (uint64_t) 1;
+    result << job_type;
     // Read Job Number
     size_t job_number;
     job >> job_number;
     result << job_number;
+    // Jobs running longer than this (in seconds) are abandoned
+    double time_limit;
+    job >> time_limit;
     // Perform work
     bool computed;
-    ClutchingJobWorkThread cj ( &result, &job, &computed, &model );
-    boost::thread t(cj);
-    if ( not t . try_join_for ( boost::chrono::seconds( 3600 ) ) ) {
-      t.interrupt();
-      t.join();
+    {
+      MorseJobWorkThread cj ( &result, &job, &computed, &model, job_type );
+      boost::thread t(cj);
+      if ( not t . try_join_for ( boost::chrono::duration<double> ( time_limit ) ) ) {
+        t.interrupt();
+        t.join();
+      }
     }
     if ( not computed ) {
       result << Database ();
+      if ( job_type == 1 ) {
+        result << std::vector<uint64_t> ();
+        result << std::vector<std::string> ();
+      }
+      if ( job_type == 2 ) {
+        result << std::vector<std::string> ();
+        result << std::vector<double> ();
+        result << std::vector<uint64_t> ();
+        result << (int) 0; // threads unknown
+      }
     }
     break;
+  case 3:
+    std::cout << "MorseProcess::work. Clutching Pair Job detected.\n";
+    result << job_type;
+    job >> job_number;
+    result << job_number;
+    Clutching_Pair_Job ( &result, job );
+    break;
   }
   std::cout << "MorseProcess::work. Job complete.\n";
 }
@@ -181,14 +470,9 @@ void MorseProcess::accept(const Message &result) {
   uint64_t result_type;
   result >> result_type;
   if ( result_type == 0 ) {
-    // Checkpoint Timer finished.
+    // Checkpoint Timer finished. (Results are already saved in the 
+    // result log as they arrive, so there is nothing to write here.)
     checkpoint_timer_running_ = false;
-    // Save a checkpoint
-    if ( (float)(current_time - time_of_last_checkpoint_ ) 
-      / (float)CLOCKS_PER_SEC > 3600.0f ) {
-      checkpoint ();
-      progressReport ();
-    }
   } else {
     // Accepting result of normal job.
     // Read the results from the result message
@@ -196,8 +480,52 @@ void MorseProcess::accept(const Message &result) {
     Database job_database;
     result >> job_number;
     result >> job_database;
+    // Record the results on disk before merging them
+    result_log_ . append ( job_database );
     // Merge the results
     database . merge ( job_database );
+    BOOST_FOREACH ( const ParameterRecord & record, job_database . parameter_records () ) {
+      ++ num_box_calculations_;
+      box_calculated_ [ record . parameter_index ] = true;
+    }
+    if ( result_type == 1 ) {
+      std::vector<uint64_t> coded_vertices;
+      std::vector<std::string> coded_graphs;
+      result >> coded_vertices;
+      result >> coded_graphs;
+      for ( size_t i = 0; i < coded_vertices . size (); ++ i ) {
+        storeGrids ( coded_vertices [ i ], coded_graphs [ i ] );
+      }
+    }
+    if ( result_type == 2 ) {
+      std::vector<uint64_t> boxes = boxes_of_job_ [ job_number ];
+      boxes_of_job_ . erase ( job_number );
+      std::vector<std::string> morse_graph_bytes;
+      std::vector<double> seconds;
+      std::vector<uint64_t> grid_sizes;
+      int threads;
+      result >> morse_graph_bytes;
+      result >> seconds;
+      result >> grid_sizes;
+      result >> threads;
+      if ( threads > 0 ) worker_threads_ = threads;
+      else threads = worker_threads_;
+      bool computed = ( morse_graph_bytes . size () == boxes . size () );
+      // A job which hit the time limit is charged evenly to its boxes. Like
+      // the times measured by a job, the charge is per thread: a worker runs
+      // up to "threads" boxes side by side for the whole time limit.
+      double timeout_cost = config.PARAM_TIME_LIMIT * 
+        (double) std::min ( (size_t) threads, boxes . size () ) / (double) boxes . size ();
+      for ( size_t i = 0; i < boxes . size (); ++ i ) {
+        double cost = computed ? seconds [ i ] : timeout_cost;
+        scheduler_ . observe ( boxes [ i ], cost, pending_neighbors_ [ boxes [ i ] ] );
+        if ( computed ) {
+          num_grid_cells_ += grid_sizes [ i ];
+          storeGrids ( boxes [ i ], morse_graph_bytes [ i ] );
+        }
+        acceptMorseGraph ( boxes [ i ], computed ? morse_graph_bytes [ i ] : std::string () );
+      }
+    }
     ++ progress_bar_;
     std::cout << "MorseProcess::read: Received result " 
       << job_number << "\n";
@@ -213,6 +541,17 @@ void MorseProcess::accept(const Message &result) {
 /* * * * * * * * * * * */
 void MorseProcess::finalize ( void ) {
   std::cout << "MorseProcess::finalize \n";
+  if ( num_patches_skipped_ > 0 ) {
+    std::cout << "MorseProcess::finalize. " << num_patches_skipped_ 
+              << " patches were completed by a previous run and skipped.\n";
+  }
+  uint64_t num_distinct = std::count ( box_calculated_ . begin (), box_calculated_ . end (), true );
+  if ( num_distinct > 0 ) {
+    std::cout << "MorseProcess::finalize. " << num_box_calculations_ 
+              << " parameter box calculations for " << num_distinct 
+              << " distinct parameter boxes; duplicate-work ratio " 
+              << (double) num_box_calculations_ / (double) num_distinct << "\n";
+  }
   checkpoint ();
 }
 
@@ -225,9 +564,29 @@ void MorseProcess::checkpoint ( void ) {
 }
 
 void MorseProcess::progressReport ( void ) {
-  std::cout << "MorseProcess::progressReport. " << progress_bar_ << " / " << num_jobs_ << "\n";
+  // Estimate the remaining time from the rate at which work gets done
+  double elapsed = boost::chrono::duration<double> 
+    ( boost::chrono::steady_clock::now () - start_time_ ) . count ();
+  double remaining = -1.0;
+  if ( box_schedule_ ) {
+    if ( scheduler_ . observedCost () > 0.0 ) {
+      remaining = elapsed * scheduler_ . remainingCost () / scheduler_ . observedCost ();
+    }
+  } else if ( progress_bar_ > 0 ) {
+    remaining = elapsed * (double) ( num_jobs_ - progress_bar_ ) / (double) progress_bar_;
+  }
+  std::stringstream ss;
+  ss << progress_bar_ << " / " << num_jobs_;
+  if ( remaining >= 0.0 ) {
+    ss << ", about " << (uint64_t) remaining << "s remaining";
+  }
+  if ( box_schedule_ ) {
+    ss << " (mean box cost " << scheduler_ . mean () << "s, " 
+       << num_grid_cells_ << " phase space cells so far)";
+  }
+  std::cout << "MorseProcess::progressReport. " << ss . str () << "\n";
   std::ofstream progress_file ( "progress.txt" );
-  progress_file << "Morse Process Progress: " << progress_bar_ << " / " << num_jobs_ << "\n";
+  progress_file << "Morse Process Progress: " << ss . str () << "\n";
   progress_file . close ();
   time_of_last_progress_report_ = clock();
 }